@@ -63,6 +63,11 @@ class LLMQSigningTest(EvoZnodeTestFramework):
         self.mninfo[2].node.quorum("sign", 100, id, msgHash)
         wait_for_sigs(True, False, True, 15)
 
+        # The shares were verified and the sig recovered by the sig shares pipeline
+        stats = [mn.node.quorum("sigsharesstats") for mn in self.mninfo]
+        assert(sum(s["verifiedSigShares"] for s in stats) > 0)
+        assert(sum(s["recoveredSigs"] for s in stats) > 0)
+
         # Mine one more quorum, so that we have 2 active ones, nothing should change
         self.mine_quorum()
         assert_sigs_nochange(True, False, True, 3)
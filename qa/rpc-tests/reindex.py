@@ -4,7 +4,8 @@
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #
-# Test -reindex and -reindex-chainstate with CheckBlockIndex
+# Test -reindex and -reindex-chainstate with CheckBlockIndex, and that the
+# address balances are built again by both
 #
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
@@ -22,17 +23,21 @@ class ReindexTest(BitcoinTestFramework):
         self.num_nodes = 1
 
     def setup_network(self):
-        self.nodes = start_nodes(self.num_nodes, self.options.tmpdir)
+        self.nodes = start_nodes(self.num_nodes, self.options.tmpdir, [["-addressindex"]])
+        self.address = self.nodes[0].getnewaddress()
 
     def reindex(self, justchainstate=False):
-        self.nodes[0].generate(3)
+        self.nodes[0].generatetoaddress(3, self.address)
         blockcount = self.nodes[0].getblockcount()
+        balance = self.nodes[0].getaddressbalance({"addresses": [self.address]})
+        assert(balance["balance"] > 0)
         stop_nodes(self.nodes)
-        extra_args = [["-debug", "-reindex-chainstate" if justchainstate else "-reindex", "-checkblockindex=1"]]
+        extra_args = [["-debug", "-addressindex", "-reindex-chainstate" if justchainstate else "-reindex", "-checkblockindex=1"]]
         self.nodes = start_nodes(self.num_nodes, self.options.tmpdir, extra_args)
         while self.nodes[0].getblockcount() < blockcount:
             time.sleep(0.1)
         assert_equal(self.nodes[0].getblockcount(), blockcount)
+        assert_equal(self.nodes[0].getaddressbalance({"addresses": [self.address]}), balance)
         print("Success")
 
     def run_test(self):
@@ -0,0 +1,134 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "arith_uint256.h"
+#include "dbwrapper.h"
+#include "random.h"
+#include "uint256.h"
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+// Replays key access traces shaped like the ones recorded from a syncing node against a database opened with
+// the profile it has by default and with the "default" profile. The cache is kept much smaller than the data,
+// like it is for a node with the full chain, so the block cache/write buffer split matters.
+static const size_t CACHE_SIZE = 1 << 20;
+
+struct TraceOp
+{
+    enum { READ, WRITE, SCAN } type;
+    uint32_t nKey;
+};
+
+typedef std::pair<char, uint256> TraceKey;
+
+static TraceKey MakeKey(uint32_t nKey)
+{
+    return TraceKey('k', ArithToUint256(arith_uint256(nKey)));
+}
+
+// chainstate while connecting blocks: point reads of coins, mostly recently created ones, some misses, and
+// the coins of each block written back
+static std::vector<TraceOp> ChainstateTrace(uint32_t nKeys)
+{
+    FastRandomContext rng(uint256S("01"));
+    std::vector<TraceOp> trace;
+    for (int i = 0; i < 2000; i++) {
+        uint32_t nRand = rng.randrange(100);
+        if (nRand < 85) {
+            // quadratic skew towards the most recent coins
+            uint64_t nAge = rng.randrange(nKeys) * rng.randrange(nKeys) / nKeys;
+            trace.push_back({TraceOp::READ, uint32_t(nKeys - 1 - nAge)});
+        } else if (nRand < 90) {
+            trace.push_back({TraceOp::READ, uint32_t(nKeys + rng.randrange(nKeys))});
+        } else {
+            trace.push_back({TraceOp::WRITE, uint32_t(rng.randrange(nKeys))});
+        }
+    }
+    return trace;
+}
+
+// block index at startup: one pass over all entries in key order, then lookups of a few entries
+static std::vector<TraceOp> BlockIndexTrace(uint32_t nKeys)
+{
+    FastRandomContext rng(uint256S("02"));
+    std::vector<TraceOp> trace;
+    trace.push_back({TraceOp::SCAN, 0});
+    for (int i = 0; i < 100; i++)
+        trace.push_back({TraceOp::READ, uint32_t(rng.randrange(nKeys))});
+    return trace;
+}
+
+static void ReplayTrace(benchmark::State& state, const CDBProfile& profile, uint32_t nKeys, size_t nValueSize,
+                        const std::vector<TraceOp>& trace)
+{
+    CDBWrapper db("", CACHE_SIZE, true, false, false, profile);
+    FastRandomContext rng(uint256S("03"));
+    std::vector<unsigned char> value(nValueSize);
+    for (size_t i = 0; i < nValueSize; i++)
+        value[i] = rng.randrange(16); // a bit compressible, like serialized mint maps
+    for (uint32_t nKey = 0; nKey < nKeys; nKey += 1000) {
+        CDBBatch batch(db);
+        for (uint32_t i = nKey; i < std::min(nKey + 1000, nKeys); i++)
+            batch.Write(MakeKey(i), value);
+        db.WriteBatch(batch);
+    }
+
+    std::vector<unsigned char> readValue;
+    while (state.KeepRunning()) {
+        CDBBatch batch(db);
+        for (const TraceOp& op : trace) {
+            if (op.type == TraceOp::READ) {
+                db.Read(MakeKey(op.nKey), readValue);
+            } else if (op.type == TraceOp::WRITE) {
+                batch.Write(MakeKey(op.nKey), value);
+            } else {
+                std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+                size_t nEntries = 0;
+                for (pcursor->SeekToFirst(); pcursor->Valid(); pcursor->Next()) {
+                    bool fOk = pcursor->GetValue(readValue);
+                    assert(fOk);
+                    nEntries++;
+                }
+                assert(nEntries == nKeys);
+            }
+        }
+        db.WriteBatch(batch);
+    }
+}
+
+static CDBProfile ProfileByName(const std::string& strName)
+{
+    CDBProfile profile;
+    bool fFound = CDBProfile::FromName(strName, profile);
+    assert(fFound);
+    return profile;
+}
+
+static void DBChainstateTraceDefault(benchmark::State& state)
+{
+    ReplayTrace(state, ProfileByName("default"), 50000, 40, ChainstateTrace(50000));
+}
+
+static void DBChainstateTraceLookup(benchmark::State& state)
+{
+    ReplayTrace(state, ProfileByName("lookup"), 50000, 40, ChainstateTrace(50000));
+}
+
+static void DBBlockIndexTraceDefault(benchmark::State& state)
+{
+    ReplayTrace(state, ProfileByName("default"), 2000, 4096, BlockIndexTrace(2000));
+}
+
+static void DBBlockIndexTraceCold(benchmark::State& state)
+{
+    ReplayTrace(state, ProfileByName("cold"), 2000, 4096, BlockIndexTrace(2000));
+}
+
+BENCHMARK(DBChainstateTraceDefault);
+BENCHMARK(DBChainstateTraceLookup);
+BENCHMARK(DBBlockIndexTraceDefault);
+BENCHMARK(DBBlockIndexTraceCold);
@@ -0,0 +1,66 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "lelantus.h"
+#include "random.h"
+
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+
+// Lookups of used serials at about the size the sets can reach, half of the serials looked up are used.
+// The map the state used before is measured too.
+static const uint64_t TAG_COUNT = 10000000;
+static const size_t LOOKUPS = 10000;
+
+static std::vector<Scalar> LookupSerials()
+{
+    FastRandomContext rng(uint256S("01"));
+    std::vector<Scalar> serials;
+    serials.reserve(LOOKUPS);
+    for (size_t i = 0; i < LOOKUPS; i++)
+        serials.emplace_back(uint64_t(rng.randrange(2 * TAG_COUNT) + 1));
+    return serials;
+}
+
+static void FlatTagSetLookup(benchmark::State& state)
+{
+    static lelantus::UsedSerialSet serials;
+    if (serials.empty()) {
+        serials.reserve(TAG_COUNT);
+        for (uint64_t i = 1; i <= TAG_COUNT; i++)
+            serials.insert(Scalar(i), int(i % 16));
+    }
+    std::vector<Scalar> lookups = LookupSerials();
+
+    size_t nFound = 0;
+    while (state.KeepRunning()) {
+        int nGroupId;
+        for (const Scalar& serial : lookups)
+            nFound += serials.Find(serial, nGroupId);
+    }
+    assert(nFound > 0);
+}
+
+static void UnorderedMapTagLookup(benchmark::State& state)
+{
+    static std::unordered_map<Scalar, int> serials;
+    if (serials.empty()) {
+        serials.reserve(TAG_COUNT);
+        for (uint64_t i = 1; i <= TAG_COUNT; i++)
+            serials[Scalar(i)] = int(i % 16);
+    }
+    std::vector<Scalar> lookups = LookupSerials();
+
+    size_t nFound = 0;
+    while (state.KeepRunning()) {
+        for (const Scalar& serial : lookups)
+            nFound += serials.count(serial);
+    }
+    assert(nFound > 0);
+}
+
+BENCHMARK(FlatTagSetLookup);
+BENCHMARK(UnorderedMapTagLookup);
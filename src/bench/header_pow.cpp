@@ -0,0 +1,73 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chainparams.h"
+#include "primitives/block.h"
+#include "util.h"
+#include "validation.h"
+#include "checkqueue.h"
+
+#include <boost/thread/thread.hpp>
+
+#include <cassert>
+#include <vector>
+
+// Part of a "headers" message, a full one has 2000 headers
+static const int HEADER_COUNT = 200;
+// Lyra2Z was used for mainnet blocks from this height until the switch to MTP
+static const int FIRST_HEIGHT = 100000;
+
+static std::vector<CBlockHeader> MakeLyra2ZHeaders()
+{
+    SelectParams(CBaseChainParams::MAIN);
+    std::vector<CBlockHeader> headers(HEADER_COUNT);
+    for (int i = 0; i < HEADER_COUNT; i++) {
+        headers[i].nTime = 1500000000 + i * 600;
+        headers[i].nBits = 0x1b0404cb;
+        headers[i].nNonce = i;
+        if (i > 0)
+            headers[i].hashPrevBlock = headers[i - 1].GetHash();
+        assert(!headers[i].IsMTP() && !headers[i].IsProgPow());
+    }
+    return headers;
+}
+
+// What the message handler thread did for each header before AcceptBlockHeader
+static void HeadersPoWSerial(benchmark::State& state)
+{
+    std::vector<CBlockHeader> headers = MakeLyra2ZHeaders();
+    while (state.KeepRunning()) {
+        for (int i = 0; i < HEADER_COUNT; i++) {
+            headers[i].cachedPoWHash.SetNull();
+            headers[i].GetPoWHash(FIRST_HEIGHT + i);
+        }
+    }
+}
+
+// The same spread over the header check threads
+static void HeadersPoWParallel(benchmark::State& state)
+{
+    std::vector<CBlockHeader> headers = MakeLyra2ZHeaders();
+    CCheckQueue<CHeaderPoWCheck> queue(128);
+    boost::thread_group tg;
+    for (int i = 0; i < GetNumCores() - 1; i++)
+        tg.create_thread([&]{queue.Thread();});
+
+    while (state.KeepRunning()) {
+        std::vector<CHeaderPoWCheck> vChecks;
+        for (int i = 0; i < HEADER_COUNT; i++) {
+            headers[i].cachedPoWHash.SetNull();
+            vChecks.emplace_back(headers[i], FIRST_HEIGHT + i);
+        }
+        CCheckQueueControl<CHeaderPoWCheck> control(&queue);
+        control.Add(vChecks);
+        control.Wait();
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+BENCHMARK(HeadersPoWSerial);
+BENCHMARK(HeadersPoWParallel);
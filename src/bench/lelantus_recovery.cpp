@@ -0,0 +1,59 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "hdmint/wallet.h"
+#include "liblelantus/params.h"
+#include "random.h"
+
+#include <cassert>
+#include <vector>
+
+// Decrypting and checking the amounts of JMints found while a wallet syncs its mint pool, at growing numbers
+// of mints. The amounts are encrypted the way the wallet encrypts them.
+static void LelantusRecovery(benchmark::State& state, size_t nMints)
+{
+    unsigned char seed[32];
+    GetRandBytes(seed, sizeof(seed));
+    CExtKey mintValueKey;
+    mintValueKey.SetMaster(seed, sizeof(seed));
+
+    const GroupElement& h1 = lelantus::Params::get_default()->get_h1();
+    std::vector<LelantusMintCandidate> candidates(nMints);
+    for (size_t i = 0; i < nMints; i++) {
+        GroupElement pubcoin;
+        pubcoin.randomize();
+        uint64_t amount = (i + 1) * COIN / 10;
+
+        LelantusMintCandidate& candidate = candidates[i];
+        candidate.mintPoolEntry.first = primitives::GetPubCoinValueHash(pubcoin);
+        candidate.pubcoin = pubcoin + h1 * Scalar(amount);
+        candidate.encryptedValue = CWallet::EncryptMintAmount(mintValueKey, amount, candidate.pubcoin);
+    }
+
+    while (state.KeepRunning()) {
+        CHDMintWallet::DecryptLelantusMints(mintValueKey, candidates);
+    }
+    for (const LelantusMintCandidate& candidate : candidates)
+        assert(candidate.fValid);
+}
+
+static void LelantusRecovery100(benchmark::State& state)
+{
+    LelantusRecovery(state, 100);
+}
+
+static void LelantusRecovery1000(benchmark::State& state)
+{
+    LelantusRecovery(state, 1000);
+}
+
+static void LelantusRecovery10000(benchmark::State& state)
+{
+    LelantusRecovery(state, 10000);
+}
+
+BENCHMARK(LelantusRecovery100);
+BENCHMARK(LelantusRecovery1000);
+BENCHMARK(LelantusRecovery10000);
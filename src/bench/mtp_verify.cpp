@@ -0,0 +1,68 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "crypto/MerkleTreeProof/mtp.h"
+#include "uint256.h"
+
+#include <cassert>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// The MTP data of a block: what ReadBlockFromDisk and CheckBlock verify for every unstripped MTP block
+struct MTPProof
+{
+    char input[80];
+    uint32_t target;
+    uint256 powLimit;
+    uint8_t hashRootMTP[16];
+    unsigned int nonce;
+    uint64_t blockMTP[mtp::MTP_L * 2][128];
+    std::deque<std::vector<uint8_t>> proofMTP[mtp::MTP_L * 3];
+    uint256 mtpHashValue;
+};
+
+// Mining a proof fills the 4GiB Argon2 memory once, it's done on first use and shared by the benchmarks. The
+// memory and proof parameters are the mainnet ones, only the target is low so that any nonce qualifies quickly.
+static const MTPProof& GetProof()
+{
+    static std::unique_ptr<MTPProof> proof;
+    if (!proof) {
+        proof.reset(new MTPProof());
+        for (int i = 0; i < 80; i++)
+            proof->input[i] = (char)(i * 37 + 5);
+        proof->target = 0x2000ffff;
+        proof->powLimit = uint256S("00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+        mtp::impl::mtp_hash(proof->input, proof->target, proof->hashRootMTP, proof->nonce, proof->blockMTP,
+                proof->proofMTP, proof->powLimit, proof->mtpHashValue);
+    }
+    return *proof;
+}
+
+static void VerifyProof(benchmark::State& state, unsigned nThreads)
+{
+    const MTPProof& proof = GetProof();
+    while (state.KeepRunning()) {
+        uint256 mtpHashValue;
+        bool fOk = mtp::impl::mtp_verify(proof.input, proof.target, proof.hashRootMTP, proof.nonce, proof.blockMTP,
+                proof.proofMTP, proof.powLimit, &mtpHashValue, nThreads);
+        assert(fOk && mtpHashValue == proof.mtpHashValue);
+    }
+}
+
+// All 64 rounds on the calling thread, like the verification did before
+static void MTPVerifySerial(benchmark::State& state)
+{
+    VerifyProof(state, 1);
+}
+
+// Merkle proofs spread over one thread per Argon2 lane, capped by the number of cores
+static void MTPVerifyParallel(benchmark::State& state)
+{
+    VerifyProof(state, 0);
+}
+
+BENCHMARK(MTPVerifySerial);
+BENCHMARK(MTPVerifyParallel);
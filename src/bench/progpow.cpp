@@ -0,0 +1,84 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "crypto/progpow.h"
+#include "crypto/progpow/include/ethash/ethash.hpp"
+#include "crypto/progpow/include/ethash/progpow.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <cassert>
+#include <functional>
+
+// A block verified by ConnectBlock hashes one header, hashes of different nonces stand for different blocks
+static const int HASHES_PER_ITERATION = 8;
+
+static ethash::hash256 BenchHeader()
+{
+    ethash::hash256 header{};
+    header.bytes[0] = 0x42;
+    return header;
+}
+
+static void HashBlocks(benchmark::State& state, const std::function<ethash::result(int, const ethash::hash256&, uint64_t)>& hash)
+{
+    const ethash::hash256 header = BenchHeader();
+    while (state.KeepRunning()) {
+        for (uint64_t nNonce = 0; nNonce < HASHES_PER_ITERATION; nNonce++)
+            hash(1, header, nNonce);
+    }
+}
+
+// What every restart and epoch change used to cost
+static void ProgPowEpochContextBuild(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        ethash::epoch_context_ptr context = ethash::create_epoch_context(0);
+        assert(context);
+    }
+}
+
+// The same with the context persisted by an earlier run
+static void ProgPowEpochContextLoad(benchmark::State& state)
+{
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    const ethash::hash256 header = BenchHeader();
+    {
+        CProgPowEpochCache cache;
+        cache.Init(dir.string(), false);
+        cache.Hash(1, header, 0);
+    }
+    while (state.KeepRunning()) {
+        CProgPowEpochCache cache;
+        cache.Init(dir.string(), false);
+        cache.Hash(1, header, 0);
+    }
+    boost::filesystem::remove_all(dir);
+}
+
+// Full hashes computing each dataset item from the light cache
+static void ProgPowHashLight(benchmark::State& state)
+{
+    ethash::epoch_context_ptr context = ethash::create_epoch_context(0);
+    HashBlocks(state, [&](int nHeight, const ethash::hash256& header, uint64_t nNonce) {
+        return progpow::hash(*context, nHeight, header, nNonce);
+    });
+}
+
+// Full hashes reading dataset items from a generated dataset. The items are filled in by the first iteration,
+// which saves generating 1.5GB, the following ones read them like they'd be read from a complete dataset.
+static void ProgPowHashFullDataset(benchmark::State& state)
+{
+    ethash::epoch_context_full_ptr context = ethash::create_epoch_context_full(0);
+    assert(context);
+    HashBlocks(state, [&](int nHeight, const ethash::hash256& header, uint64_t nNonce) {
+        return progpow::hash(*context, nHeight, header, nNonce);
+    });
+}
+
+BENCHMARK(ProgPowEpochContextBuild);
+BENCHMARK(ProgPowEpochContextLoad);
+BENCHMARK(ProgPowHashLight);
+BENCHMARK(ProgPowHashFullDataset);
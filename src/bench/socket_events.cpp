@@ -0,0 +1,171 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include "config/bitcoin-config.h"
+#endif
+
+#include "bench.h"
+#include "compat.h"
+#include "netbase.h"
+
+#ifndef WIN32
+
+#include <fcntl.h>
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#include <cassert>
+#include <vector>
+
+/*
+ * Compares the readiness wait of the two socket events backends on raw loopback sockets. Neither CConnman nor CNode
+ * is involved, so node locking, message parsing and the send/receive buffers are not part of the numbers, only the
+ * cost of finding the ready sockets and reading them.
+ */
+
+/* Number of loopback connections the socket handler waits on, stays below FD_SETSIZE so select() can be compared */
+static const size_t CONNECTION_COUNT = 400;
+/* Every n-th connection receives a message per iteration, most peers are idle at any given time */
+static const size_t ACTIVE_EVERY = 20;
+
+struct LoopbackConnections
+{
+    SOCKET hListenSocket;
+    std::vector<SOCKET> vClient;
+    std::vector<SOCKET> vServer;
+
+    LoopbackConnections()
+    {
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+
+        hListenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        assert(hListenSocket != INVALID_SOCKET);
+        bool fOk = bind(hListenSocket, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+                   listen(hListenSocket, SOMAXCONN) == 0 &&
+                   getsockname(hListenSocket, (struct sockaddr*)&addr, &len) == 0;
+        assert(fOk);
+
+        for (size_t i = 0; i < CONNECTION_COUNT; i++) {
+            SOCKET hClient = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            assert(hClient != INVALID_SOCKET);
+            fOk = connect(hClient, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+            assert(fOk);
+            SOCKET hServer = accept(hListenSocket, nullptr, nullptr);
+            assert(hServer != INVALID_SOCKET);
+            fcntl(hServer, F_SETFL, fcntl(hServer, F_GETFL, 0) | O_NONBLOCK);
+            vClient.push_back(hClient);
+            vServer.push_back(hServer);
+        }
+    }
+
+    ~LoopbackConnections()
+    {
+        for (size_t i = 0; i < CONNECTION_COUNT; i++) {
+            CloseSocket(vClient[i]);
+            CloseSocket(vServer[i]);
+        }
+        CloseSocket(hListenSocket);
+    }
+
+    void SendToActive()
+    {
+        static const char msg[] = "ping";
+        for (size_t i = 0; i < CONNECTION_COUNT; i += ACTIVE_EVERY) {
+            ssize_t nSent = send(vClient[i], msg, sizeof(msg), MSG_NOSIGNAL);
+            assert(nSent == sizeof(msg));
+        }
+    }
+
+    // reads until the socket would block, returns the number of bytes read
+    static size_t Drain(SOCKET hSocket)
+    {
+        char pchBuf[0x10000];
+        size_t nTotal = 0;
+        int nBytes;
+        while ((nBytes = recv(hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT)) > 0) {
+            nTotal += nBytes;
+        }
+        return nTotal;
+    }
+};
+
+// The readiness wait of -socketevents=select: rebuild the fd_sets for all connections, let the kernel scan all of
+// them and check every connection for readiness
+static void SocketEventsSelect(benchmark::State& state)
+{
+    LoopbackConnections conns;
+    while (state.KeepRunning()) {
+        conns.SendToActive();
+
+        size_t nReady = 0;
+        while (nReady < CONNECTION_COUNT / ACTIVE_EVERY) {
+            fd_set fdsetRecv;
+            fd_set fdsetError;
+            FD_ZERO(&fdsetRecv);
+            FD_ZERO(&fdsetError);
+            SOCKET hSocketMax = 0;
+            for (SOCKET hSocket : conns.vServer) {
+                FD_SET(hSocket, &fdsetRecv);
+                FD_SET(hSocket, &fdsetError);
+                hSocketMax = std::max(hSocketMax, hSocket);
+            }
+
+            struct timeval timeout;
+            timeout.tv_sec = 0;
+            timeout.tv_usec = 50000;
+            select(hSocketMax + 1, &fdsetRecv, nullptr, &fdsetError, &timeout);
+
+            for (SOCKET hSocket : conns.vServer) {
+                if (FD_ISSET(hSocket, &fdsetRecv) || FD_ISSET(hSocket, &fdsetError)) {
+                    LoopbackConnections::Drain(hSocket);
+                    nReady++;
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(SocketEventsSelect);
+
+#ifdef USE_EPOLL
+// The readiness wait of -socketevents=epoll: sockets are registered once edge-triggered, only ready ones are returned
+static void SocketEventsEpoll(benchmark::State& state)
+{
+    LoopbackConnections conns;
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    assert(epollFd != -1);
+    for (SOCKET hSocket : conns.vServer) {
+        epoll_event e;
+        e.events = EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP | EPOLLET;
+        e.data.fd = hSocket;
+        int ret = epoll_ctl(epollFd, EPOLL_CTL_ADD, hSocket, &e);
+        assert(ret == 0);
+    }
+
+    epoll_event events[1024];
+    while (state.KeepRunning()) {
+        conns.SendToActive();
+
+        size_t nReady = 0;
+        while (nReady < CONNECTION_COUNT / ACTIVE_EVERY) {
+            int nEvents = epoll_wait(epollFd, events, 1024, 50);
+            for (int i = 0; i < nEvents; i++) {
+                LoopbackConnections::Drain(events[i].data.fd);
+                nReady++;
+            }
+        }
+    }
+    close(epollFd);
+}
+
+BENCHMARK(SocketEventsEpoll);
+#endif // USE_EPOLL
+
+#endif // WIN32
@@ -0,0 +1,67 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "libspark/coin.h"
+
+/* Number of coins identified per iteration, divide by the reported time to get coins per second */
+static const size_t IDENTIFY_BATCH_SIZE = 100;
+
+static std::vector<spark::Coin> MakeCoins(const spark::Params* params, const spark::Address& address, char type)
+{
+    std::vector<spark::Coin> coins;
+    coins.reserve(IDENTIFY_BATCH_SIZE);
+    for (size_t i = 0; i < IDENTIFY_BATCH_SIZE; i++) {
+        secp_primitives::Scalar k;
+        k.randomize();
+        coins.emplace_back(params, type, k, address, i + 1, "Spam and eggs", std::vector<unsigned char>(32, (unsigned char)i));
+    }
+    return coins;
+}
+
+// Trial decryption of coins addressed to someone else, the common case when a wallet scans the chain
+static void SparkIdentifyForeign(benchmark::State& state)
+{
+    const spark::Params* params = spark::Params::get_default();
+    spark::SpendKey spend_key(params);
+    spark::FullViewKey full_view_key(spend_key);
+    spark::IncomingViewKey incoming_view_key(full_view_key);
+
+    spark::SpendKey other_spend_key(params);
+    spark::FullViewKey other_full_view_key(other_spend_key);
+    spark::IncomingViewKey other_incoming_view_key(other_full_view_key);
+    spark::Address other_address(other_incoming_view_key, 1);
+
+    std::vector<spark::Coin> coins = MakeCoins(params, other_address, spark::COIN_TYPE_MINT);
+    while (state.KeepRunning()) {
+        for (auto& coin : coins) {
+            try {
+                coin.identify(incoming_view_key);
+                assert(false);
+            } catch (const std::runtime_error&) {
+            }
+        }
+    }
+}
+
+// Identification of our own coins, which also authenticates and decrypts the recipient data
+static void SparkIdentifyOwn(benchmark::State& state)
+{
+    const spark::Params* params = spark::Params::get_default();
+    spark::SpendKey spend_key(params);
+    spark::FullViewKey full_view_key(spend_key);
+    spark::IncomingViewKey incoming_view_key(full_view_key);
+    spark::Address address(incoming_view_key, 1);
+
+    std::vector<spark::Coin> coins = MakeCoins(params, address, spark::COIN_TYPE_SPEND);
+    while (state.KeepRunning()) {
+        for (auto& coin : coins) {
+            spark::IdentifiedCoinData data = coin.identify(incoming_view_key);
+            assert(data.i == 1);
+        }
+    }
+}
+
+BENCHMARK(SparkIdentifyForeign);
+BENCHMARK(SparkIdentifyOwn);
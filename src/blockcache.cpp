@@ -0,0 +1,139 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockcache.h"
+#include "blockencodings.h"
+#include "core_memusage.h"
+#include "memusage.h"
+#include "primitives/block.h"
+#include "streams.h"
+#include "validation.h"
+#include "version.h"
+
+static CSerializedBlockCache blockCache(SERIALIZED_BLOCK_CACHE_BYTES);
+
+template <typename T>
+static CSharedNetPayloadRef MakePayload(int nFlags, const T& obj)
+{
+    std::vector<unsigned char> data;
+    CVectorWriter{SER_NETWORK, nFlags | PROTOCOL_VERSION, data, 0, obj};
+    return std::make_shared<const CSharedNetPayload>(std::move(data));
+}
+
+// Memory a parsed block takes, several times its serialized size because of the allocations of its scripts
+// and transactions. MTP blocks also carry about 200KB of MTP data.
+static size_t BlockMemoryUsage(const CBlock& block)
+{
+    size_t mem = sizeof(CBlock) + RecursiveDynamicUsage(block);
+    for (const auto& tx : block.vtx)
+        mem += memusage::DynamicUsage(tx->vExtraPayload);
+    if (block.mtpHashData) {
+        mem += memusage::MallocUsage(sizeof(CMTPHashData));
+        for (const auto& proof : block.mtpHashData->nProofMTP) {
+            for (const auto& node : proof)
+                mem += sizeof(node) + memusage::DynamicUsage(node);
+        }
+    }
+    return mem;
+}
+
+static size_t PayloadMemoryUsage(const CSharedNetPayloadRef& payload)
+{
+    return memusage::MallocUsage(sizeof(CSharedNetPayload)) + memusage::DynamicUsage(payload->data);
+}
+
+CSerializedBlockCache::CSerializedBlockCache(size_t nMaxBytesIn)
+    : nMaxBytes(nMaxBytesIn),
+      nBytes(0) {
+}
+
+void CSerializedBlockCache::AddBlock(const std::shared_ptr<const CBlock>& pblock) {
+    Insert({Key(pblock->GetHash(), ENTRY_BLOCK), pblock, nullptr, BlockMemoryUsage(*pblock)});
+}
+
+std::shared_ptr<const CBlock> CSerializedBlockCache::GetBlock(const CBlockIndex* pindex, bool fStripMTP, const Consensus::Params& params) {
+    Key key(pindex->GetBlockHash(), ENTRY_BLOCK);
+    Entry entry;
+    std::shared_ptr<const CBlock> pblock;
+    if (Get(key, entry)) {
+        pblock = entry.block;
+    } else {
+        AssertLockHeld(cs_main);
+        std::shared_ptr<CBlock> pnewBlock = std::make_shared<CBlock>();
+        if (!ReadBlockFromDisk(*pnewBlock, pindex, params))
+            return nullptr;
+        pblock = pnewBlock;
+        Insert({key, pblock, nullptr, BlockMemoryUsage(*pblock)});
+    }
+
+    if (!fStripMTP || !pblock->mtpHashData || pblock->mtpHashData->IsMTPDataStripped())
+        return pblock;
+
+    // Stripped MTP data is just a zeroed root, don't touch the data the cached block shares with others.
+    // Only the stripped encodings are cached, the block itself is cheap to derive again.
+    std::shared_ptr<CBlock> pstrippedBlock = std::make_shared<CBlock>(*pblock);
+    pstrippedBlock->mtpHashData = std::make_shared<CMTPHashData>();
+    return pstrippedBlock;
+}
+
+CSharedNetPayloadRef CSerializedBlockCache::GetSerializedBlock(const CBlockIndex* pindex, int nFlags, bool fStripMTP, const Consensus::Params& params) {
+    Key key(pindex->GetBlockHash(), ENTRY_WIRE | (nFlags & SERIALIZE_TRANSACTION_NO_WITNESS ? ENTRY_NO_WITNESS : 0) | (fStripMTP ? ENTRY_MTP_STRIPPED : 0));
+    Entry entry;
+    if (Get(key, entry))
+        return entry.payload;
+
+    std::shared_ptr<const CBlock> pblock = GetBlock(pindex, fStripMTP, params);
+    if (!pblock)
+        return nullptr;
+    CSharedNetPayloadRef payload = MakePayload(nFlags, *pblock);
+    Insert({key, nullptr, payload, PayloadMemoryUsage(payload)});
+    return payload;
+}
+
+CSharedNetPayloadRef CSerializedBlockCache::GetSerializedCompactBlock(const CBlockIndex* pindex, bool fUseWTXID, bool fStripMTP, const Consensus::Params& params) {
+    Key key(pindex->GetBlockHash(), ENTRY_CMPCT | (fUseWTXID ? 0 : ENTRY_NO_WITNESS) | (fStripMTP ? ENTRY_MTP_STRIPPED : 0));
+    Entry entry;
+    if (Get(key, entry))
+        return entry.payload;
+
+    std::shared_ptr<const CBlock> pblock = GetBlock(pindex, fStripMTP, params);
+    if (!pblock)
+        return nullptr;
+    CBlockHeaderAndShortTxIDs cmpctblock(*pblock, fUseWTXID);
+    CSharedNetPayloadRef payload = MakePayload(fUseWTXID ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS, cmpctblock);
+    Insert({key, nullptr, payload, PayloadMemoryUsage(payload)});
+    return payload;
+}
+
+bool CSerializedBlockCache::Get(const Key& key, Entry& entryOut) {
+    LOCK(cs);
+    auto it = index.find(key);
+    if (it == index.end())
+        return false;
+    entries.splice(entries.begin(), entries, it->second);
+    entryOut = *it->second;
+    return true;
+}
+
+void CSerializedBlockCache::Insert(Entry&& entry) {
+    LOCK(cs);
+    // concurrent callers may have done the same work for the same key
+    if (index.count(entry.key))
+        return;
+
+    nBytes += entry.nBytes;
+    entries.push_front(std::move(entry));
+    index.emplace(entries.front().key, entries.begin());
+
+    // the new entry is kept even if it exceeds the budget on its own
+    while (nBytes > nMaxBytes && entries.size() > 1) {
+        nBytes -= entries.back().nBytes;
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+CSerializedBlockCache* CSerializedBlockCache::GetCache() {
+    return &blockCache;
+}
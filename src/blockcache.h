@@ -0,0 +1,85 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef FIRO_BLOCKCACHE_H
+#define FIRO_BLOCKCACHE_H
+
+#include "net.h"
+#include "saltedhasher.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+class CBlock;
+class CBlockIndex;
+
+namespace Consensus {
+struct Params;
+}
+
+// Memory used by the parsed blocks and encodings kept in the serialized block cache
+static const size_t SERIALIZED_BLOCK_CACHE_BYTES = 64 * 1024 * 1024;
+
+/*
+ * Recent blocks, parsed and in the wire encodings peers, REST and ZMQ ask for.
+ *
+ * When a new block arrives dozens of peers request it at about the same time, each request used to
+ * read the block from disk and serialize it again. Entries are keyed by block hash and encoding; what's
+ * encoded under a block hash never changes, so entries never go stale and are only evicted, least
+ * recently used first, when the cache exceeds its memory budget. Encodings are shared payloads,
+ * PushMessage queues them for any number of peers without copying.
+ */
+class CSerializedBlockCache {
+public:
+    explicit CSerializedBlockCache(size_t nMaxBytesIn);
+
+    // Seeds the cache with a block that was just received or mined, before it's requested
+    void AddBlock(const std::shared_ptr<const CBlock>& pblock);
+
+    // The following read the block from disk on a miss, cs_main must be held then. They return nullptr
+    // if the block can't be read. With fStripMTP the MTP data of the block is replaced by its stripped form.
+    std::shared_ptr<const CBlock> GetBlock(const CBlockIndex* pindex, bool fStripMTP, const Consensus::Params& params);
+    // Payload of a "block" message, also what /rest/block and ZMQ rawblock send. nFlags are serialization
+    // flags, i.e. SERIALIZE_TRANSACTION_NO_WITNESS or 0.
+    CSharedNetPayloadRef GetSerializedBlock(const CBlockIndex* pindex, int nFlags, bool fStripMTP, const Consensus::Params& params);
+    // Payload of a "cmpctblock" message
+    CSharedNetPayloadRef GetSerializedCompactBlock(const CBlockIndex* pindex, bool fUseWTXID, bool fStripMTP, const Consensus::Params& params);
+
+    static CSerializedBlockCache* GetCache();
+
+private:
+    // second part of the key, the encoding
+    enum : uint32_t {
+        ENTRY_BLOCK = 0,            // parsed full block
+        ENTRY_WIRE = 1,             // "block" payload
+        ENTRY_CMPCT = 2,            // "cmpctblock" payload
+        ENTRY_NO_WITNESS = 4,
+        ENTRY_MTP_STRIPPED = 8,
+    };
+    typedef std::pair<uint256, uint32_t> Key;
+
+    struct Entry {
+        Key key;
+        std::shared_ptr<const CBlock> block;
+        CSharedNetPayloadRef payload;
+        size_t nBytes;
+    };
+
+    bool Get(const Key& key, Entry& entryOut);
+    void Insert(Entry&& entry);
+
+private:
+    CCriticalSection cs;
+
+    const size_t nMaxBytes;
+    size_t nBytes;
+    // most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, StaticSaltedHasher> index;
+};
+
+#endif // FIRO_BLOCKCACHE_H
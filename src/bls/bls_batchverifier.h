@@ -97,29 +97,62 @@ public:
                 badSources.emplace(p.first);
 
                 if (perMessageFallback) {
-                    // revert to per-message verification
-                    if (p.second.size() == 1) {
-                        // no need to re-verify a single message
-                        badMessages.emplace(p.second[0]->second.msgId);
-                    } else {
-                        for (const auto& msgIt : p.second) {
-                            if (badMessages.count(msgIt->first)) {
-                                // same message might be invalid from different source, so no need to re-verify it
-                                continue;
-                            }
-
-                            const auto& msg = msgIt->second;
-                            if (!msg.sig.VerifyInsecure(msg.pubKey, msg.msgHash)) {
-                                badMessages.emplace(msg.msgId);
-                            }
+                    std::vector<MessageMapIterator> msgs;
+                    msgs.reserve(p.second.size());
+                    for (const auto& msgIt : p.second) {
+                        // same message might be invalid from different source, so no need to re-verify it
+                        if (!badMessages.count(msgIt->first)) {
+                            msgs.emplace_back(msgIt);
                         }
                     }
+                    // the source's batch is known to be invalid, unless we dropped already known bad messages from it
+                    FindBadMessages(msgs, msgs.size() == p.second.size());
                 }
             }
         }
     }
 
 private:
+    // Finds the invalid messages by bisecting the batch. When only few messages are invalid, this needs far fewer
+    // pairings than verifying every message on its own. If knownInvalid is set, the batch as a whole has already
+    // failed verification
+    void FindBadMessages(const std::vector<MessageMapIterator>& msgs, bool knownInvalid)
+    {
+        if (msgs.empty()) {
+            return;
+        }
+        if (msgs.size() == 1) {
+            const auto& msg = msgs[0]->second;
+            if (knownInvalid || !msg.sig.VerifyInsecure(msg.pubKey, msg.msgHash)) {
+                badMessages.emplace(msg.msgId);
+            }
+            return;
+        }
+
+        if (!knownInvalid && VerifyMessages(msgs)) {
+            return;
+        }
+
+        auto mid = msgs.begin() + msgs.size() / 2;
+        std::vector<MessageMapIterator> left(msgs.begin(), mid);
+        std::vector<MessageMapIterator> right(mid, msgs.end());
+        bool leftValid = VerifyMessages(left);
+        if (!leftValid) {
+            FindBadMessages(left, true);
+        }
+        // if the left half is valid, the invalid message(s) must be in the right half
+        FindBadMessages(right, leftValid);
+    }
+
+    bool VerifyMessages(const std::vector<MessageMapIterator>& msgs)
+    {
+        std::map<uint256, std::vector<MessageMapIterator>> byMessageHash;
+        for (const auto& msgIt : msgs) {
+            byMessageHash[msgIt->second.msgHash].emplace_back(msgIt);
+        }
+        return VerifyBatch(byMessageHash);
+    }
+
     // All Verify methods take ownership of the passed byMessageHash map and thus might modify the map. This is to avoid
     // unnecessary copies
 
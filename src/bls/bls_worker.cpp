@@ -857,6 +857,20 @@ void CBLSWorker::AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& p
     bool foundDuplicate = false;
     for (auto& s : sigVerifyQueue) {
         if (s.msgHash == msgHash) {
+            if (s.pubKey == pubKey && s.sig == sig) {
+                // exactly the same signature is already queued, so verify it only once and report the result to both
+                // callers
+                auto prevDoneCallback = std::move(s.doneCallback);
+                auto prevCancelCond = std::move(s.cancelCond);
+                s.doneCallback = [prevDoneCallback, doneCallback](bool valid) {
+                    prevDoneCallback(valid);
+                    doneCallback(valid);
+                };
+                s.cancelCond = [prevCancelCond, cancelCond]() {
+                    return prevCancelCond() && cancelCond();
+                };
+                return;
+            }
             foundDuplicate = true;
             break;
         }
@@ -887,6 +901,60 @@ bool CBLSWorker::IsAsyncVerifyInProgress()
     return sigVerifyBatchesInProgress != 0;
 }
 
+template <typename Job>
+static bool VerifySigVerifyJobs(const std::vector<Job>& jobs, const std::vector<size_t>& indexes)
+{
+    CBLSSignature aggSig;
+    std::vector<CBLSPublicKey> pubKeys;
+    std::vector<uint256> msgHashes;
+    pubKeys.reserve(indexes.size());
+    msgHashes.reserve(indexes.size());
+    for (size_t i : indexes) {
+        auto& job = jobs[i];
+        if (pubKeys.empty()) {
+            aggSig = job.sig;
+        } else {
+            aggSig.AggregateInsecure(job.sig);
+        }
+        pubKeys.emplace_back(job.pubKey);
+        msgHashes.emplace_back(job.msgHash);
+    }
+    return aggSig.VerifyInsecureAggregated(pubKeys, msgHashes);
+}
+
+// Splits a batch in halves until the invalid sigs are isolated. With few invalid sigs in a batch, this needs far fewer
+// pairings than verifying every sig on its own. If knownInvalid is set, the batch as a whole failed verification already
+template <typename Job>
+static void BisectSigVerifyJobs(std::vector<Job>& jobs, const std::vector<size_t>& indexes, bool knownInvalid)
+{
+    if (indexes.size() == 1) {
+        auto& job = jobs[indexes[0]];
+        job.doneCallback(!knownInvalid && job.sig.VerifyInsecure(job.pubKey, job.msgHash));
+        return;
+    }
+
+    if (!knownInvalid && VerifySigVerifyJobs(jobs, indexes)) {
+        for (size_t i : indexes) {
+            jobs[i].doneCallback(true);
+        }
+        return;
+    }
+
+    auto mid = indexes.begin() + indexes.size() / 2;
+    std::vector<size_t> left(indexes.begin(), mid);
+    std::vector<size_t> right(mid, indexes.end());
+    bool leftValid = VerifySigVerifyJobs(jobs, left);
+    if (leftValid) {
+        for (size_t i : left) {
+            jobs[i].doneCallback(true);
+        }
+    } else {
+        BisectSigVerifyJobs(jobs, left, true);
+    }
+    // if the left half is valid, the invalid sig(s) must be in the right half
+    BisectSigVerifyJobs(jobs, right, leftValid);
+}
+
 // sigVerifyMutex must be held while calling
 void CBLSWorker::PushSigVerifyBatch()
 {
@@ -935,13 +1003,8 @@ void CBLSWorker::PushSigVerifyBatch()
                     jobs[indexes[i]].doneCallback(true);
                 }
             } else {
-                // one or more sigs were not valid, revert to per-sig verification
-                // TODO this could be improved if we would cache pairing results in some way as the previous aggregated verification already calculated all the pairings for the hashes
-                for (size_t i = 0; i < pubKeys.size(); i++) {
-                    auto& job = jobs[indexes[i]];
-                    bool valid = job.sig.VerifyInsecure(job.pubKey, job.msgHash);
-                    job.doneCallback(valid);
-                }
+                // one or more sigs were not valid, bisect the batch to find them
+                BisectSigVerifyJobs(jobs, indexes, true);
             }
         }
 
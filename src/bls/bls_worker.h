@@ -139,6 +139,15 @@ public:
     std::future<bool> AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, CancelCond cancelCond = [] { return false; });
     bool IsAsyncVerifyInProgress();
 
+    // Runs an arbitrary job on the worker pool. Jobs must not wait for other jobs on the pool
+    template<typename Callable>
+    auto Async(Callable&& f) -> std::future<decltype(f())>
+    {
+        return workerPool.push([f](int threadId) {
+            return f();
+        });
+    }
+
 private:
     void PushSigVerifyBatch();
 };
@@ -8,6 +8,7 @@ extern "C" {
 #include "blake2/blamka-round-ref.h"
 #include "core.h"
 #include "ref.h"
+#include "thread.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,6 +17,7 @@ extern "C" {
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <thread>
 #include "merkle-tree.hpp"
 #include "primitives/block.h"
 #include "streams.h"
@@ -203,6 +205,79 @@ struct TargetHelper
 
 } // unnamed namespace
 
+namespace {
+
+/** What round j of the verification needs to check the openings of its blocks */
+struct VerifyRound
+{
+    uint32_t ij;
+    uint32_t ij_prev;
+    uint32_t ref_index;
+    block block_ij;
+};
+
+/** Merkle proofs of the rounds [begin, end) checked by one thread */
+struct ProofCheckTask
+{
+    const MerkleTree::Buffer* root;
+    const uint64_t (*block_mtp)[128];
+    const std::deque<std::vector<uint8_t>>* proof_mtp;
+    const VerifyRound* rounds;
+    uint32_t begin;
+    uint32_t end;
+    bool result;
+};
+
+bool CheckOpening(const MerkleTree::Buffer& root, const block& opened,
+        const std::deque<std::vector<uint8_t>>& proof, uint32_t index)
+{
+    uint8_t digest[MERKLE_TREE_ELEMENT_SIZE_B];
+    compute_blake2b(opened, digest);
+    MerkleTree::Buffer hash(digest, digest + sizeof(digest));
+    return MerkleTree::checkProofOrdered(proof, root, hash, index + 1);
+}
+
+void CheckProofs(ProofCheckTask& task)
+{
+    task.result = true;
+    for (uint32_t j = task.begin; j < task.end; ++j) {
+        const VerifyRound& round = task.rounds[j - 1];
+        block prev_block, ref_block;
+        std::memcpy(prev_block.v, task.block_mtp[(j * 2) - 2],
+                sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
+        std::memcpy(ref_block.v, task.block_mtp[(j * 2) - 1],
+                sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
+
+        if (!CheckOpening(*task.root, prev_block, task.proof_mtp[(j * 3) - 2], round.ij_prev)) {
+            LogPrintf("error : checkProofOrdered in x[ij_prev]\n");
+            task.result = false;
+            return;
+        }
+        if (!CheckOpening(*task.root, ref_block, task.proof_mtp[(j * 3) - 1], round.ref_index)) {
+            LogPrintf("error : checkProofOrdered in x[ij_ref]\n");
+            task.result = false;
+            return;
+        }
+        if (!CheckOpening(*task.root, round.block_ij, task.proof_mtp[(j * 3) - 3], round.ij)) {
+            LogPrintf("error : checkProofOrdered in x[ij]\n");
+            task.result = false;
+            return;
+        }
+    }
+}
+
+#ifdef _WIN32
+unsigned __stdcall CheckProofsThread(void *task)
+#else
+void *CheckProofsThread(void *task)
+#endif
+{
+    CheckProofs(*static_cast<ProofCheckTask*>(task));
+    return 0;
+}
+
+} // unnamed namespace
+
 namespace impl
 {
 
@@ -211,14 +286,10 @@ bool mtp_verify(const char* input, const uint32_t target,
         const uint64_t block_mtp[MTP_L*2][128],
         const std::deque<std::vector<uint8_t>> proof_mtp[MTP_L*3],
         uint256 pow_limit,
-        uint256 *mtpHashValue)
+        uint256 *mtpHashValue,
+        unsigned threads)
 {
     MerkleTree::Buffer const root(&hash_root_mtp[0], &hash_root_mtp[16]);
-    block blocks[L * 2];
-    for(int i = 0; i < (L * 2); ++i) {
-        std::memcpy(blocks[i].v, block_mtp[i],
-                sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
-    }
 
 #define TEST_OUTLEN 32
 #define TEST_PWDLEN 80
@@ -293,24 +364,23 @@ bool mtp_verify(const char* input, const uint32_t target,
     // get hash_zero
     uint8_t h0[ARGON2_PREHASH_SEED_LENGTH];
     initial_hash(h0, &context_verify, instance.type);
-    
-    // step 8
+
+    // step 8, the chain of y(j) is computed first, the Merkle proofs of the openings don't depend on each
+    // other and are checked afterwards, in parallel
+    static_assert((M_COST & (M_COST - 1)) == 0, "y(j-1) mod M_COST is taken from its low bits");
+    std::vector<VerifyRound> rounds(L);
     for (uint32_t j = 1; j <= L; ++j) {
+        VerifyRound& round = rounds[j - 1];
+
         // compute ij
-        std::string s = "0x" + y[j - 1].GetHex();
-        boost::multiprecision::uint256_t t(s);
-        uint32_t ij = numeric_cast<uint32_t>(t % M_COST);
+        uint32_t ij = static_cast<uint32_t>(UintToArith256(y[j - 1]).GetLow64() % M_COST);
 
         // retrieve x[ij-1] and x[phi(i)] from proof
-        block prev_block, ref_block, t_prev_block, t_ref_block;
-        std::memcpy(t_prev_block.v, block_mtp[(j * 2) - 2],
+        block prev_block, ref_block;
+        std::memcpy(prev_block.v, block_mtp[(j * 2) - 2],
                 sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
-        std::memcpy(t_ref_block.v, block_mtp[j*2 - 1],
+        std::memcpy(ref_block.v, block_mtp[j*2 - 1],
                 sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
-        copy_block(&prev_block , &t_prev_block);
-        copy_block(&ref_block , &t_ref_block);
-        clear_internal_memory(t_prev_block.v, ARGON2_BLOCK_SIZE);
-        clear_internal_memory(t_ref_block.v, ARGON2_BLOCK_SIZE);
 
         //prev_index
         //compute
@@ -331,17 +401,6 @@ bool mtp_verify(const char* input, const uint32_t target,
             ij_prev = ij - 1;
         }
 
-        //hash[prev_index]
-        uint8_t digest_prev[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(prev_block, digest_prev);
-        MerkleTree::Buffer hash_prev(digest_prev,
-                digest_prev + sizeof(digest_prev));
-        if (!MerkleTree::checkProofOrdered(proof_mtp[(j * 3) - 2],
-                    root, hash_prev, ij_prev + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij_prev]\n");
-            return false;
-        }
-
         //compute ref_index
         uint64_t prev_block_opening = prev_block.v[0];
         uint32_t ref_lane = static_cast<uint32_t>((prev_block_opening >> 32) % LANES);
@@ -364,46 +423,51 @@ bool mtp_verify(const char* input, const uint32_t target,
 
         uint32_t computed_ref_block = (lane_length * ref_lane) + ref_index;
 
-        uint8_t digest_ref[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(ref_block, digest_ref);
-        MerkleTree::Buffer hash_ref(digest_ref, digest_ref + sizeof(digest_ref));
-        if (!MerkleTree::checkProofOrdered(proof_mtp[(j * 3) - 1],
-                    root, hash_ref, computed_ref_block + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij_ref]\n");
-            return false;
-        }
-
         // compute x[ij]
-        block block_ij;
-        fill_block_mtp(&blocks[(j * 2) - 2], &blocks[(j * 2) - 1],
-                &block_ij, 0, computed_ref_block, h0);
-
-        // verify opening
-        // hash x[ij]
-        uint8_t digest_ij[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(block_ij, digest_ij);
-        MerkleTree::Buffer hash_ij(digest_ij, digest_ij + sizeof(digest_ij));
-
-        if (!MerkleTree::checkProofOrdered(proof_mtp[(j * 3) - 3], root,
-                    hash_ij, ij + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij]\n");
-            return false;
-        }
+        fill_block_mtp(&prev_block, &ref_block, &round.block_ij, 0, computed_ref_block, h0);
+
+        round.ij = ij;
+        round.ij_prev = ij_prev;
+        round.ref_index = computed_ref_block;
 
         // compute y(j)
-        block blockhash;
-        copy_block(&blockhash, &block_ij);
         uint8_t blockhash_bytes[ARGON2_BLOCK_SIZE];
-        StoreBlock(&blockhash_bytes, &blockhash);
+        StoreBlock(&blockhash_bytes, &round.block_ij);
         blake2b_state ctx_yj;
         blake2b_init(&ctx_yj, 32);
         blake2b_update(&ctx_yj, &y[j - 1], 32);
         blake2b_update(&ctx_yj, blockhash_bytes, ARGON2_BLOCK_SIZE);
         blake2b_final(&ctx_yj, &y[j], 32);
-        clear_internal_memory(block_ij.v, ARGON2_BLOCK_SIZE);
-        clear_internal_memory(blockhash.v, ARGON2_BLOCK_SIZE);
-        clear_internal_memory(blockhash_bytes, ARGON2_BLOCK_SIZE);
-    }    
+    }
+
+    // verify openings: one share of the rounds per thread, the first share is checked by the calling thread, so
+    // is a share whose thread couldn't be started
+    unsigned nThreads = threads;
+    if (nThreads == 0) {
+        nThreads = std::min(LANES, std::max(1u, std::thread::hardware_concurrency()));
+    }
+    nThreads = std::min<unsigned>(nThreads, L);
+    std::vector<ProofCheckTask> tasks(nThreads);
+    std::vector<argon2_thread_handle_t> handles(nThreads);
+    std::vector<bool> started(nThreads, false);
+    for (unsigned t = 0; t < nThreads; ++t) {
+        tasks[t] = {&root, block_mtp, proof_mtp, rounds.data(), 1 + t * L / nThreads, 1 + (t + 1) * L / nThreads, false};
+        if (t > 0) {
+            started[t] = argon2_thread_create(&handles[t], &CheckProofsThread, &tasks[t]) == 0;
+        }
+    }
+    bool proofs_ok = true;
+    for (unsigned t = 0; t < nThreads; ++t) {
+        if (started[t]) {
+            argon2_thread_join(handles[t]);
+        } else {
+            CheckProofs(tasks[t]);
+        }
+        proofs_ok = proofs_ok && tasks[t].result;
+    }
+    if (!proofs_ok) {
+        return false;
+    }
 
     // step 9
     bool negative;
@@ -411,10 +475,6 @@ bool mtp_verify(const char* input, const uint32_t target,
     arith_uint256 bn_target;
     bn_target.SetCompact(target, &negative, &overflow); // diff = 1
 
-    for (int i = 0; i < (L * 2); ++i) {
-        clear_internal_memory(blocks[i].v, ARGON2_BLOCK_SIZE);
-    }
-
     if (mtpHashValue)
         *mtpHashValue = y[L];
 
@@ -78,6 +78,8 @@ void mtp_hash(const char* input,
  * \param block_mtp     [in] Data used to compute hash values
  * \param proof_mtp     [in] Merkle proofs for every element in `block_mtp`;
  * \param pow_limit     [in] Network limit (hash must be less than that)
+ * \param threads       [in] Threads the Merkle proofs are checked on, 0 for one
+ *                           per Argon2 lane up to the number of cores
  *
  * \return `true` if `nonce` is valid, `false` otherwise
  */
@@ -88,7 +90,8 @@ bool mtp_verify(const char* input,
         const uint64_t block_mtp[MTP_L*2][128],
         const std::deque<std::vector<uint8_t>> proof_mtp[MTP_L*3],
         uint256 pow_limit,
-        uint256 *mtpHashValue=nullptr);
+        uint256 *mtpHashValue=nullptr,
+        unsigned threads=0);
 }
 
 }
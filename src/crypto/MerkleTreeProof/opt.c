@@ -0,0 +1,112 @@
+/*
+ * Argon2 reference source code package - reference C implementations
+ *
+ * Copyright 2015
+ * Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves
+ *
+ * You may use this work under the terms of a Creative Commons CC0 1.0
+ * License/Waiver or the Apache Public License 2.0, at your option. The terms of
+ * these licenses can be found at:
+ *
+ * - CC0 1.0 Universal : http://creativecommons.org/publicdomain/zero/1.0
+ * - Apache 2.0        : http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * You should have received a copy of both of these licenses along with this
+ * software. If not, they may be obtained at the above URLs.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "opt.h"
+
+#if defined(MTP_HAVE_FILL_BLOCK_OPT)
+
+#include "blake2/blamka-round-opt.h"
+
+/* The state is loaded into the widest registers the build targets, the rounds are the ones of upstream opt.c */
+#if defined(__AVX512F__)
+typedef __m512i state_word;
+#define STATE_WORDS ARGON2_512BIT_WORDS_IN_BLOCK
+#define LOAD_STATE(p) _mm512_loadu_si512((const void *)(p))
+#define STORE_STATE(p, x) _mm512_storeu_si512((void *)(p), (x))
+#define XOR_STATE(x, y) _mm512_xor_si512((x), (y))
+#elif defined(__AVX2__)
+typedef __m256i state_word;
+#define STATE_WORDS ARGON2_HWORDS_IN_BLOCK
+#define LOAD_STATE(p) _mm256_loadu_si256((const __m256i *)(p))
+#define STORE_STATE(p, x) _mm256_storeu_si256((__m256i *)(p), (x))
+#define XOR_STATE(x, y) _mm256_xor_si256((x), (y))
+#else
+typedef __m128i state_word;
+#define STATE_WORDS ARGON2_OWORDS_IN_BLOCK
+#define LOAD_STATE(p) _mm_loadu_si128((const __m128i *)(p))
+#define STORE_STATE(p, x) _mm_storeu_si128((__m128i *)(p), (x))
+#define XOR_STATE(x, y) _mm_xor_si128((x), (y))
+#endif
+
+void fill_block_mtp_opt(const block *prev_block, const block *ref_block,
+                        block *next_block, int with_xor, uint32_t block_index, const uint8_t *hash_zero) {
+    block blockR;
+    state_word state[STATE_WORDS], block_XY[STATE_WORDS];
+    unsigned i;
+
+    /* blockR = ref_block + prev_block, block_XY = ref_block + prev_block (+ next_block) */
+    for (i = 0; i < STATE_WORDS; ++i) {
+        size_t offset = i * sizeof(state_word);
+        state[i] = XOR_STATE(LOAD_STATE((const uint8_t *)ref_block->v + offset),
+                             LOAD_STATE((const uint8_t *)prev_block->v + offset));
+        block_XY[i] = with_xor ? XOR_STATE(state[i], LOAD_STATE((const uint8_t *)next_block->v + offset)) : state[i];
+        STORE_STATE((uint8_t *)blockR.v + offset, state[i]);
+    }
+
+    /* the block index and h0 go into blockR only, the words are reloaded into the state */
+    uint32_t the_index[2] = {0, block_index};
+    memcpy(&blockR.v[14], the_index, sizeof(uint64_t));
+    memcpy(&blockR.v[16], hash_zero, 4 * sizeof(uint64_t));
+    for (i = 14 * sizeof(uint64_t) / sizeof(state_word); i <= 19 * sizeof(uint64_t) / sizeof(state_word); ++i) {
+        state[i] = LOAD_STATE((const uint8_t *)blockR.v + i * sizeof(state_word));
+    }
+
+#if defined(__AVX512F__)
+    for (i = 0; i < 2; ++i) {
+        BLAKE2_ROUND_1(
+            state[8 * i + 0], state[8 * i + 1], state[8 * i + 2], state[8 * i + 3],
+            state[8 * i + 4], state[8 * i + 5], state[8 * i + 6], state[8 * i + 7]);
+    }
+    for (i = 0; i < 2; ++i) {
+        BLAKE2_ROUND_2(
+            state[2 * 0 + i], state[2 * 1 + i], state[2 * 2 + i], state[2 * 3 + i],
+            state[2 * 4 + i], state[2 * 5 + i], state[2 * 6 + i], state[2 * 7 + i]);
+    }
+#elif defined(__AVX2__)
+    for (i = 0; i < 4; ++i) {
+        BLAKE2_ROUND_1(
+            state[8 * i + 0], state[8 * i + 4], state[8 * i + 1], state[8 * i + 5],
+            state[8 * i + 2], state[8 * i + 6], state[8 * i + 3], state[8 * i + 7]);
+    }
+    for (i = 0; i < 4; ++i) {
+        BLAKE2_ROUND_2(
+            state[ 0 + i], state[ 4 + i], state[ 8 + i], state[12 + i],
+            state[16 + i], state[20 + i], state[24 + i], state[28 + i]);
+    }
+#else
+    /* columns: words (0,1,...,15), (16,...,31)... then rows: words (0,1,16,17,...,112,113)... */
+    for (i = 0; i < 8; ++i) {
+        BLAKE2_ROUND(
+            state[8 * i + 0], state[8 * i + 1], state[8 * i + 2], state[8 * i + 3],
+            state[8 * i + 4], state[8 * i + 5], state[8 * i + 6], state[8 * i + 7]);
+    }
+    for (i = 0; i < 8; ++i) {
+        BLAKE2_ROUND(
+            state[8 * 0 + i], state[8 * 1 + i], state[8 * 2 + i], state[8 * 3 + i],
+            state[8 * 4 + i], state[8 * 5 + i], state[8 * 6 + i], state[8 * 7 + i]);
+    }
+#endif
+
+    for (i = 0; i < STATE_WORDS; ++i) {
+        STORE_STATE((uint8_t *)next_block->v + i * sizeof(state_word), XOR_STATE(state[i], block_XY[i]));
+    }
+}
+
+#endif /* MTP_HAVE_FILL_BLOCK_OPT */
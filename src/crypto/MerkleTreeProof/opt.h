@@ -0,0 +1,26 @@
+/*
+ * opt.h
+ *
+ * SIMD version of fill_block_mtp, used by ref.h when the compiler targets SSSE3 or later
+ */
+
+#ifndef SRC_OPT_H_
+#define SRC_OPT_H_
+
+#include <stdint.h>
+
+#include "core.h"
+
+/* With plain SSE2 the rotations are shifts and it's no faster than the reference code */
+#if defined(__SSSE3__)
+#define MTP_HAVE_FILL_BLOCK_OPT 1
+
+/*
+ * Same as fill_block_mtp() in ref.h, the BLAKE2 rounds run on SSSE3, AVX2 or AVX-512 registers,
+ * whichever the build targets.
+ */
+void fill_block_mtp_opt(const block *prev_block, const block *ref_block,
+                        block *next_block, int with_xor, uint32_t block_index, const uint8_t *hash_zero);
+#endif
+
+#endif /* SRC_OPT_H_ */
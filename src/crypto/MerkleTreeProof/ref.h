@@ -19,18 +19,13 @@
 #include "blake2/blamka-round-ref.h"
 #include "blake2/blake2-impl.h"
 #include "blake2/blake2.h"
+#include "opt.h"
 
 /*
- * Function fills a new memory block and optionally XORs the old block over the new one.
- * @next_block must be initialized.
- * @param prev_block Pointer to the previous block
- * @param ref_block Pointer to the reference block
- * @param next_block Pointer to the block to be constructed
- * @param with_xor Whether to XOR into the new block (1) or just overwrite (0)
- * @pre all block pointers must be valid
+ * Reference version of fill_block_mtp(), always built so the SIMD version can be checked against it.
  */
-static void fill_block_mtp(const block *prev_block, const block *ref_block,
-                       block *next_block, int with_xor, uint32_t block_index, uint8_t * hash_zero) {
+static inline void fill_block_mtp_ref(const block *prev_block, const block *ref_block,
+                       block *next_block, int with_xor, uint32_t block_index, const uint8_t * hash_zero) {
     block blockR, block_tmp;
     unsigned i;
 
@@ -90,5 +85,23 @@ static void fill_block_mtp(const block *prev_block, const block *ref_block,
     xor_block(next_block, &blockR);
 }
 
+/*
+ * Function fills a new memory block and optionally XORs the old block over the new one.
+ * @next_block must be initialized.
+ * @param prev_block Pointer to the previous block
+ * @param ref_block Pointer to the reference block
+ * @param next_block Pointer to the block to be constructed
+ * @param with_xor Whether to XOR into the new block (1) or just overwrite (0)
+ * @pre all block pointers must be valid
+ */
+static void fill_block_mtp(const block *prev_block, const block *ref_block,
+                       block *next_block, int with_xor, uint32_t block_index, uint8_t * hash_zero) {
+#if defined(MTP_HAVE_FILL_BLOCK_OPT)
+    fill_block_mtp_opt(prev_block, ref_block, next_block, with_xor, block_index, hash_zero);
+#else
+    fill_block_mtp_ref(prev_block, ref_block, next_block, with_xor, block_index, hash_zero);
+#endif
+}
+
 
 #endif /* SRC_REF_H_ */
@@ -7,11 +7,190 @@
 #include <chainparams.h>
 #include <crypto/progpow/helpers.hpp>
 #include <crypto/progpow/lib/ethash/endianness.hpp>
+#include <crypto/progpow/lib/ethash/ethash-internal.hpp>
 #include <crypto/progpow/include/ethash/ethash.hpp>
+#include <crypto/sha256.h>
 #include <hash.h>
 #include <primitives/block.h>
 
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifndef WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Blocks before the end of an epoch from which the context of the next epoch is built in the background
+static const int EPOCH_PREGEN_BLOCKS = ethash::epoch_length / 4;
+
+static const char EPOCH_FILE_MAGIC[8] = {'F', 'I', 'R', 'O', 'E', 'P', 'C', 'H'};
+static const uint32_t EPOCH_FILE_VERSION = 2;
+
+// Header of an epoch file, the light cache or the dataset follows it. The files never leave the node, so
+// they are in native byte order.
+struct EpochFileHeader
+{
+    char magic[8];
+    uint32_t nVersion;
+    int32_t nEpoch;
+    uint32_t fDataset;
+    // only set once the body is on disk
+    uint32_t fComplete;
+    uint64_t nBodySize;
+    // of the body
+    unsigned char checksum[CSHA256::OUTPUT_SIZE];
+};
+static_assert(sizeof(EpochFileHeader) == sizeof(ethash::hash512), "the header must keep the items after it aligned");
+
+/* Memory holding an epoch, mapped from its file or anonymous */
+class EpochMemory
+{
+public:
+    unsigned char* data;
+    size_t size;
+
+    EpochMemory() : data(nullptr), size(0), fMapped(false) {}
+    EpochMemory(const EpochMemory&) = delete;
+    EpochMemory& operator=(const EpochMemory&) = delete;
+    ~EpochMemory() { Release(); }
+
+    // Maps an existing file of nSize bytes, copy on write
+    bool Open(const std::string& path, size_t nSize)
+    {
+#ifndef WIN32
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size != nSize) {
+            close(fd);
+            return false;
+        }
+        return Map(fd, nSize, MAP_PRIVATE);
+#else
+        return false;
+#endif
+    }
+
+    // Creates a file of nSize zero bytes and maps it
+    bool Create(const std::string& path, size_t nSize)
+    {
+#ifndef WIN32
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd == -1)
+            return false;
+        // the blocks must be reserved up front, writing to a mapped hole on a full disk raises SIGBUS
+        if (!Reserve(fd, nSize)) {
+            close(fd);
+            unlink(path.c_str());
+            return false;
+        }
+        return Map(fd, nSize, MAP_SHARED);
+#else
+        return false;
+#endif
+    }
+
+    bool Allocate(size_t nSize)
+    {
+        // zeroed, pages are only committed when touched
+        data = static_cast<unsigned char*>(std::calloc(1, nSize));
+        size = data ? nSize : 0;
+        return data != nullptr;
+    }
+
+    // Writes a mapped file back to disk
+    void Sync()
+    {
+#ifndef WIN32
+        if (fMapped)
+            msync(data, size, MS_SYNC);
+#endif
+    }
+
+    void Release()
+    {
+        if (!data)
+            return;
+#ifndef WIN32
+        if (fMapped)
+            munmap(data, size);
+        else
+#endif
+            std::free(data);
+        data = nullptr;
+        size = 0;
+        fMapped = false;
+    }
+
+private:
+    bool fMapped;
+
+#ifndef WIN32
+    // Allocates the blocks of a new file, where that can't be done the caller uses anonymous memory
+    static bool Reserve(int fd, size_t nSize)
+    {
+#if defined(MAC_OSX)
+        fstore_t fst;
+        fst.fst_flags = F_ALLOCATECONTIG;
+        fst.fst_posmode = F_PEOFPOSMODE;
+        fst.fst_offset = 0;
+        fst.fst_length = (off_t)nSize;
+        fst.fst_bytesalloc = 0;
+        if (fcntl(fd, F_PREALLOCATE, &fst) == -1) {
+            fst.fst_flags = F_ALLOCATEALL;
+            if (fcntl(fd, F_PREALLOCATE, &fst) == -1)
+                return false;
+        }
+        return ftruncate(fd, (off_t)nSize) == 0;
+#elif defined(__linux__)
+        // returns the error instead of setting errno
+        return posix_fallocate(fd, 0, (off_t)nSize) == 0;
+#else
+        return false;
+#endif
+    }
+
+    bool Map(int fd, size_t nSize, int nFlags)
+    {
+        void* addr = mmap(nullptr, nSize, PROT_READ | PROT_WRITE, nFlags, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED)
+            return false;
+        data = static_cast<unsigned char*>(addr);
+        size = nSize;
+        fMapped = true;
+        return true;
+    }
+#endif
+};
+
+class CProgPowEpochCache::LightEpoch
+{
+public:
+    EpochMemory memory;
+    std::unique_ptr<ethash::epoch_context> context;
+};
+
+class CProgPowEpochCache::FullEpoch
+{
+public:
+    // the dataset context uses its light cache
+    LightEpochRef light;
+    EpochMemory memory;
+    std::unique_ptr<ethash::epoch_context_full> context;
+};
+
+static CProgPowEpochCache epochCache;
 
 static inline ethash::hash256 U256ToH256(const uint256& in) {
 
@@ -40,15 +219,8 @@ static inline uint256 H256ToU256(const ethash::hash256& in) {
 
 uint256 progpow_hash_full(const CProgPowHeader& header, uint256& mix_hash)
 {
-    static ethash::epoch_context_ptr epochContext{nullptr,nullptr};
-    if (!epochContext || epochContext->epoch_number != ethash::get_epoch_number(header.nHeight))
-    {
-        epochContext.reset();
-        epochContext = ethash::create_epoch_context(ethash::get_epoch_number(header.nHeight));
-    }
-
     const auto header_h256{U256ToH256(SerializeHash(header))};
-    const auto result = progpow::hash(*epochContext, header.nHeight, header_h256, header.nNonce64);
+    const auto result = CProgPowEpochCache::GetCache()->Hash(header.nHeight, header_h256, header.nNonce64);
     mix_hash = H256ToU256(result.mix_hash);
     return H256ToU256(result.final_hash);
 }
@@ -63,4 +235,311 @@ uint256 progpow_hash_light(const CProgPowHeader& header)
     const auto seed_h256{progpow::hash_seed(header_h256, header.nNonce64)};
     const auto final_h256{progpow::hash_final(seed_h256, mix_h256)};
     return H256ToU256(final_h256);
-}
\ No newline at end of file
+}
+
+static void FinishEpochFile(EpochMemory& memory, int nEpoch, bool fDataset)
+{
+    EpochFileHeader* header = reinterpret_cast<EpochFileHeader*>(memory.data);
+    memcpy(header->magic, EPOCH_FILE_MAGIC, sizeof(header->magic));
+    header->nVersion = EPOCH_FILE_VERSION;
+    header->nEpoch = nEpoch;
+    header->fDataset = fDataset;
+    header->nBodySize = memory.size - sizeof(EpochFileHeader);
+    CSHA256().Write(memory.data + sizeof(EpochFileHeader), header->nBodySize).Finalize(header->checksum);
+
+    // a crash must not leave a file that looks complete
+    memory.Sync();
+    header->fComplete = 1;
+    memory.Sync();
+}
+
+static bool CheckEpochFile(const EpochMemory& memory, int nEpoch, bool fDataset)
+{
+    const EpochFileHeader* header = reinterpret_cast<const EpochFileHeader*>(memory.data);
+    if (memcmp(header->magic, EPOCH_FILE_MAGIC, sizeof(header->magic)) != 0 || header->nVersion != EPOCH_FILE_VERSION ||
+            header->nEpoch != nEpoch || header->fDataset != (uint32_t)fDataset || !header->fComplete ||
+            header->nBodySize != memory.size - sizeof(EpochFileHeader))
+        return false;
+
+    // full hashes of blocks are checked against the dataset, a single bad item would reject valid blocks
+    unsigned char checksum[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(memory.data + sizeof(EpochFileHeader), header->nBodySize).Finalize(checksum);
+    return memcmp(checksum, header->checksum, sizeof(checksum)) == 0;
+}
+
+CProgPowEpochCache::CProgPowEpochCache()
+    : fFullDataset(false),
+      nCurrentEpoch(0),
+      fStop(false)
+{
+}
+
+CProgPowEpochCache::~CProgPowEpochCache()
+{
+    Stop();
+}
+
+bool CProgPowEpochCache::Init(const std::string& strDirIn, bool fFullDatasetIn)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    fFullDataset = fFullDatasetIn;
+    strDir.clear();
+#ifndef WIN32
+    // contexts are only persisted where they can be mapped
+    if (strDirIn.empty())
+        return true;
+    if (mkdir(strDirIn.c_str(), 0700) != 0 && errno != EEXIST)
+        return false;
+    strDir = strDirIn;
+#endif
+    return true;
+}
+
+void CProgPowEpochCache::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fStop = true;
+    }
+    condJobs.notify_all();
+    if (threadWorker.joinable())
+        threadWorker.join();
+}
+
+ethash::result CProgPowEpochCache::Hash(int nHeight, const ethash::hash256& headerHash, uint64_t nNonce)
+{
+    const int nEpoch = ethash::get_epoch_number(nHeight);
+    FullEpochRef full;
+    bool fNewEpoch = false;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (nEpoch > nCurrentEpoch) {
+            // release the contexts the chain has moved away from, hashes still using them keep a reference
+            nCurrentEpoch = nEpoch;
+            mapLight.erase(mapLight.begin(), mapLight.lower_bound(nEpoch - 1));
+            mapFull.erase(mapFull.begin(), mapFull.lower_bound(nEpoch - 1));
+            setJobs.erase(setJobs.begin(), setJobs.lower_bound(std::make_pair(nEpoch - 1, false)));
+            fNewEpoch = true;
+        }
+
+        auto it = mapFull.find(nEpoch);
+        if (it != mapFull.end())
+            full = it->second;
+
+        if (fFullDataset && !full)
+            QueueJob(nEpoch, true);
+        if (nHeight % ethash::epoch_length >= ethash::epoch_length - EPOCH_PREGEN_BLOCKS) {
+            QueueJob(nEpoch + 1, false);
+            if (fFullDataset)
+                QueueJob(nEpoch + 1, true);
+        }
+    }
+
+    if (fNewEpoch)
+        RemoveStaleFiles(nEpoch);
+
+    if (full)
+        return progpow::hash(*full->context, nHeight, headerHash, nNonce);
+
+    LightEpochRef light = GetLightEpoch(nEpoch);
+    return progpow::hash(*light->context, nHeight, headerHash, nNonce);
+}
+
+bool CProgPowEpochCache::HasFullDataset(int nEpoch)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return mapFull.count(nEpoch) > 0;
+}
+
+CProgPowEpochCache::LightEpochRef CProgPowEpochCache::GetLightEpoch(int nEpoch)
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        auto it = mapLight.find(nEpoch);
+        if (it != mapLight.end())
+            return it->second;
+    }
+
+    std::lock_guard<std::mutex> lockBuild(csBuild);
+    {
+        // another thread may have built it in the meantime
+        std::lock_guard<std::mutex> lock(cs);
+        auto it = mapLight.find(nEpoch);
+        if (it != mapLight.end())
+            return it->second;
+    }
+
+    LightEpochRef light = LoadLightEpoch(nEpoch);
+    if (!light)
+        throw std::runtime_error(std::string(__func__) + ": out of memory building the ProgPoW epoch context");
+
+    std::lock_guard<std::mutex> lock(cs);
+    mapLight[nEpoch] = light;
+    return light;
+}
+
+CProgPowEpochCache::LightEpochRef CProgPowEpochCache::LoadLightEpoch(int nEpoch)
+{
+    const int nLightItems = ethash::calculate_light_cache_num_items(nEpoch);
+    const int nFullItems = ethash::calculate_full_dataset_num_items(nEpoch);
+    const size_t nLightCacheSize = ethash::get_light_cache_size(nLightItems);
+    const size_t nSize = sizeof(EpochFileHeader) + nLightCacheSize + progpow::l1_cache_size;
+
+    std::shared_ptr<LightEpoch> epoch = std::make_shared<LightEpoch>();
+    bool fLoaded = false;
+    if (!strDir.empty()) {
+        const std::string path = EpochPath(nEpoch, false);
+        fLoaded = epoch->memory.Open(path, nSize) && CheckEpochFile(epoch->memory, nEpoch, false);
+        if (!fLoaded) {
+            epoch->memory.Release();
+            epoch->memory.Create(path, nSize);
+        }
+    }
+    if (!epoch->memory.data && !epoch->memory.Allocate(nSize))
+        return nullptr;
+
+    ethash::hash512* lightCache = reinterpret_cast<ethash::hash512*>(epoch->memory.data + sizeof(EpochFileHeader));
+    uint32_t* l1Cache = reinterpret_cast<uint32_t*>(epoch->memory.data + sizeof(EpochFileHeader) + nLightCacheSize);
+    epoch->context.reset(new ethash::epoch_context{nEpoch, nLightItems, lightCache, l1Cache, nFullItems});
+
+    if (!fLoaded) {
+        ethash::build_light_cache(lightCache, nLightItems, ethash::calculate_epoch_seed(nEpoch));
+        // the L1 cache holds the first dataset items
+        ethash::hash2048* l1Items = reinterpret_cast<ethash::hash2048*>(l1Cache);
+        for (uint32_t i = 0; i < progpow::l1_cache_size / sizeof(ethash::hash2048); i++)
+            l1Items[i] = ethash::calculate_dataset_item_2048(*epoch->context, i);
+        FinishEpochFile(epoch->memory, nEpoch, false);
+    }
+    return epoch;
+}
+
+CProgPowEpochCache::FullEpochRef CProgPowEpochCache::LoadFullEpoch(const LightEpochRef& light)
+{
+    const ethash::epoch_context& lightContext = *light->context;
+    const int nEpoch = lightContext.epoch_number;
+    const size_t nSize = sizeof(EpochFileHeader) + ethash::get_full_dataset_size(lightContext.full_dataset_num_items);
+    // hashes read the dataset in 2048 bit items
+    const uint32_t nItems = lightContext.full_dataset_num_items / 2;
+
+    std::shared_ptr<FullEpoch> epoch = std::make_shared<FullEpoch>();
+    epoch->light = light;
+    bool fLoaded = false;
+    if (!strDir.empty()) {
+        const std::string path = EpochPath(nEpoch, true);
+        // hashing the whole file takes seconds, it's only loaded by the background thread
+        fLoaded = epoch->memory.Open(path, nSize) && CheckEpochFile(epoch->memory, nEpoch, true);
+        if (!fLoaded) {
+            epoch->memory.Release();
+            epoch->memory.Create(path, nSize);
+        }
+    }
+    if (!epoch->memory.data && !epoch->memory.Allocate(nSize))
+        return nullptr;
+
+    ethash::hash2048* items = reinterpret_cast<ethash::hash2048*>(epoch->memory.data + sizeof(EpochFileHeader));
+    if (!fLoaded) {
+        // generation takes minutes, leave some cores to the rest of the node
+        const unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency() / 2);
+        std::atomic<bool> fAbort(false);
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < nThreads; t++) {
+            threads.emplace_back([&, t]() {
+                for (uint32_t i = t, n = 0; i < nItems && !fAbort; i += nThreads, n++) {
+                    items[i] = ethash::calculate_dataset_item_2048(lightContext, i);
+                    if (n % 4096 == 0 && IsJobStale(nEpoch))
+                        fAbort = true;
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        // an incomplete file is generated again next time
+        if (fAbort)
+            return nullptr;
+        FinishEpochFile(epoch->memory, nEpoch, true);
+    }
+
+    epoch->context.reset(new ethash::epoch_context_full(nEpoch, lightContext.light_cache_num_items,
+        lightContext.light_cache, reinterpret_cast<const uint32_t*>(items), lightContext.full_dataset_num_items,
+        reinterpret_cast<ethash::hash1024*>(items)));
+    return epoch;
+}
+
+bool CProgPowEpochCache::IsJobStale(int nEpoch)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return fStop || nEpoch < nCurrentEpoch;
+}
+
+void CProgPowEpochCache::QueueJob(int nEpoch, bool fDataset)
+{
+    // jobs that failed aren't tried again
+    if (fStop || !setJobs.emplace(nEpoch, fDataset).second)
+        return;
+    if ((fDataset && mapFull.count(nEpoch)) || (!fDataset && mapLight.count(nEpoch)))
+        return;
+
+    queueJobs.emplace_back(nEpoch, fDataset);
+    if (!threadWorker.joinable())
+        threadWorker = std::thread(&CProgPowEpochCache::ThreadWorker, this);
+    condJobs.notify_one();
+}
+
+void CProgPowEpochCache::ThreadWorker()
+{
+    while (true) {
+        std::pair<int, bool> job;
+        {
+            std::unique_lock<std::mutex> lock(cs);
+            condJobs.wait(lock, [this] { return fStop || !queueJobs.empty(); });
+            if (fStop)
+                return;
+            job = queueJobs.front();
+            queueJobs.pop_front();
+            if (job.first < nCurrentEpoch)
+                continue;
+        }
+
+        FullEpochRef full;
+        try {
+            LightEpochRef light = GetLightEpoch(job.first);
+            if (job.second)
+                full = LoadFullEpoch(light);
+        } catch (const std::exception&) {
+            // out of memory, hashes keep using what's there
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(cs);
+        if (full && job.first >= nCurrentEpoch - 1)
+            mapFull[job.first] = full;
+    }
+}
+
+void CProgPowEpochCache::RemoveStaleFiles(int nEpoch)
+{
+#ifndef WIN32
+    if (strDir.empty())
+        return;
+    DIR* dir = opendir(strDir.c_str());
+    if (!dir)
+        return;
+    while (struct dirent* entry = readdir(dir)) {
+        int nFileEpoch;
+        char ext[8];
+        if (sscanf(entry->d_name, "epoch-%d.%7s", &nFileEpoch, ext) == 2 && nFileEpoch < nEpoch - 1)
+            unlink((strDir + "/" + entry->d_name).c_str());
+    }
+    closedir(dir);
+#endif
+}
+
+std::string CProgPowEpochCache::EpochPath(int nEpoch, bool fDataset) const
+{
+    return strDir + "/epoch-" + std::to_string(nEpoch) + (fDataset ? ".dag" : ".light");
+}
+
+CProgPowEpochCache* CProgPowEpochCache::GetCache()
+{
+    return &epochCache;
+}
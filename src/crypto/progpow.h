@@ -11,6 +11,15 @@
 #include <uint256.h>
 #include <serialize.h>
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
 /**
  * Serializer for ProgPow BlockHeader input
 */
@@ -45,4 +54,74 @@ uint256 progpow_hash_full(const CProgPowHeader& header, uint256& mix_hash);
 /* Performs a light progpow hash (DAG loops excluded) provided header has mix_hash */
 uint256 progpow_hash_light(const CProgPowHeader& header);
 
+/** Default for -progpowfulldag */
+static const bool DEFAULT_PROGPOW_FULL_DAG = false;
+
+/**
+ * ProgPoW epoch contexts shared by all threads.
+ *
+ * Building the light cache of an epoch takes seconds, it used to be done again at every epoch change and
+ * every restart. Contexts are kept in files under the data directory which are mapped into memory, so they
+ * survive restarts and the OS can page them out. The context of the next epoch is built in the background
+ * when the chain gets close to it.
+ *
+ * With the full dataset enabled the DAG (1.5GB and up) of the current epoch is generated in the background
+ * too; once it's complete full hashes read dataset items from it instead of computing each one from the
+ * light cache.
+ */
+class CProgPowEpochCache
+{
+public:
+    class LightEpoch;
+    class FullEpoch;
+    typedef std::shared_ptr<const LightEpoch> LightEpochRef;
+    typedef std::shared_ptr<const FullEpoch> FullEpochRef;
+
+    CProgPowEpochCache();
+    ~CProgPowEpochCache();
+
+    // Keeps the contexts in strDirIn, which is created if needed. Without a directory, or if it can't be
+    // created, contexts are only kept in memory. Must be called before the first hash.
+    bool Init(const std::string& strDirIn, bool fFullDatasetIn);
+    // Stops background generation
+    void Stop();
+
+    // Full hash of a header at nHeight
+    ethash::result Hash(int nHeight, const ethash::hash256& headerHash, uint64_t nNonce);
+
+    // Whether the full dataset of an epoch is ready
+    bool HasFullDataset(int nEpoch);
+
+    static CProgPowEpochCache* GetCache();
+
+private:
+    LightEpochRef GetLightEpoch(int nEpoch);
+    LightEpochRef LoadLightEpoch(int nEpoch);
+    FullEpochRef LoadFullEpoch(const LightEpochRef& light);
+    bool IsJobStale(int nEpoch);
+    void QueueJob(int nEpoch, bool fDataset);
+    void RemoveStaleFiles(int nEpoch);
+    void ThreadWorker();
+    std::string EpochPath(int nEpoch, bool fDataset) const;
+
+private:
+    std::string strDir;
+    bool fFullDataset;
+
+    std::mutex cs;
+    // the epoch of the most recent hash, epochs far from it are released
+    int nCurrentEpoch;
+    std::map<int, LightEpochRef> mapLight;
+    std::map<int, FullEpochRef> mapFull;
+
+    // held while a light context is loaded or built, so it's only done once
+    std::mutex csBuild;
+
+    std::condition_variable condJobs;
+    std::deque<std::pair<int, bool>> queueJobs;
+    std::set<std::pair<int, bool>> setJobs;
+    std::thread threadWorker;
+    bool fStop;
+};
+
 #endif // FIRO_PROGPOW_H
\ No newline at end of file
@@ -15,14 +15,101 @@
 #include <memenv.h>
 #include <stdint.h>
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+// Databases that have a profile, and the profile they use unless -dbprofile says otherwise
+static const std::pair<const char*, const char*> DB_DEFAULT_PROFILES[] = {
+    {"chainstate", "lookup"},
+    {"blockindex", "cold"},
+    {"powhash", "lookup"},
+    {"evo", "default"},
+    {"llmq", "write"},
+};
+
+static int nDBMaxOpenFiles = DEFAULT_DB_MAX_OPEN_FILES;
+
+bool CDBProfile::FromName(const std::string& strName, CDBProfile& profileOut)
+{
+    CDBProfile profile;
+    if (strName == "lookup") {
+        profile.nBlockCachePercent = 75;
+    } else if (strName == "cold") {
+        profile.nBlockCachePercent = 25;
+        profile.fCompression = true;
+        profile.nBlockSize = 16 << 10;
+        profile.nMaxFileSize = 8 << 20;
+    } else if (strName == "write") {
+        profile.nBlockCachePercent = 25;
+        profile.nMaxFileSize = 4 << 20;
+    } else if (strName != "default") {
+        return false;
+    }
+    profileOut = profile;
+    return true;
+}
+
+// Parses "<database>:<profile>"
+static bool ParseDBProfileArg(const std::string& strArg, std::string& strDatabaseOut, CDBProfile& profileOut)
+{
+    size_t nPos = strArg.find(':');
+    if (nPos == std::string::npos)
+        return false;
+    strDatabaseOut = strArg.substr(0, nPos);
+    bool fKnown = false;
+    for (const auto& db : DB_DEFAULT_PROFILES)
+        fKnown |= strDatabaseOut == db.first;
+    return fKnown && CDBProfile::FromName(strArg.substr(nPos + 1), profileOut);
+}
+
+CDBProfile GetDBProfile(const std::string& strDatabase)
+{
+    CDBProfile profile;
+    for (const auto& db : DB_DEFAULT_PROFILES) {
+        if (strDatabase == db.first)
+            CDBProfile::FromName(db.second, profile);
+    }
+    if (mapMultiArgs.count("-dbprofile")) {
+        // the last one given for the database wins
+        for (const std::string& strArg : mapMultiArgs.at("-dbprofile")) {
+            std::string strArgDatabase;
+            CDBProfile argProfile;
+            if (ParseDBProfileArg(strArg, strArgDatabase, argProfile) && strArgDatabase == strDatabase)
+                profile = argProfile;
+        }
+    }
+    profile.nMaxOpenFiles = nDBMaxOpenFiles;
+    return profile;
+}
+
+bool CheckDBProfileArgs(std::string& strError)
+{
+    if (!mapMultiArgs.count("-dbprofile"))
+        return true;
+    for (const std::string& strArg : mapMultiArgs.at("-dbprofile")) {
+        std::string strDatabase;
+        CDBProfile profile;
+        if (!ParseDBProfileArg(strArg, strDatabase, profile)) {
+            strError = strprintf(_("Invalid -dbprofile ('%s') specified"), strArg);
+            return false;
+        }
+    }
+    return true;
+}
+
+void SetDBFileDescriptorBudget(int nFiles)
+{
+    int nDatabases = sizeof(DB_DEFAULT_PROFILES) / sizeof(DB_DEFAULT_PROFILES[0]);
+    nDBMaxOpenFiles = std::max(DEFAULT_DB_MAX_OPEN_FILES, std::min(nFiles / nDatabases, MAX_DB_MAX_OPEN_FILES));
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize, const CDBProfile& profile)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
-    options.max_open_files = 64;
+    options.block_cache = leveldb::NewLRUCache(nCacheSize * profile.nBlockCachePercent / 100);
+    options.write_buffer_size = nCacheSize * (100 - profile.nBlockCachePercent) / 200; // up to two write buffers may be held in memory simultaneously
+    options.filter_policy = leveldb::NewBloomFilterPolicy(profile.nBloomFilterBits);
+    options.compression = profile.fCompression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+    options.block_size = profile.nBlockSize;
+    options.max_file_size = profile.nMaxFileSize;
+    options.max_open_files = profile.nMaxOpenFiles;
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
         // on corruption in later versions.
@@ -31,14 +118,14 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
+CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate, const CDBProfile& profile)
 {
     penv = NULL;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, profile);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -20,6 +20,50 @@
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 
+//! Files a database keeps open unless the file descriptor limit leaves room for more
+static const int DEFAULT_DB_MAX_OPEN_FILES = 64;
+//! Upper bound for the above, LevelDB gains little from keeping more tables open
+static const int MAX_DB_MAX_OPEN_FILES = 1000;
+
+/**
+ * LevelDB tuning for the access pattern of a database. The node's databases get a profile each
+ * (see GetDBProfile), which can be overridden with -dbprofile=<database>:<profile>.
+ */
+struct CDBProfile
+{
+    //! percentage of the cache size used as block cache, the rest goes to the write buffers
+    int nBlockCachePercent;
+    int nBloomFilterBits;
+    //! Snappy compression of table blocks, a no-op if LevelDB is built without Snappy
+    bool fCompression;
+    size_t nBlockSize;
+    size_t nMaxFileSize;
+    int nMaxOpenFiles;
+
+    //! The "default" profile, the options every database used before there were profiles
+    CDBProfile() : nBlockCachePercent(50), nBloomFilterBits(10), fCompression(false), nBlockSize(4 << 10),
+                   nMaxFileSize(2 << 20), nMaxOpenFiles(DEFAULT_DB_MAX_OPEN_FILES) {}
+
+    /**
+     * Profiles by name:
+     * - "default"
+     * - "lookup": random point reads, e.g. the UTXO set. Most of the cache is used as block cache.
+     * - "cold":   large values that are mostly read once, e.g. the block index with its mint maps.
+     *             Compressed, larger blocks and files.
+     * - "write":  write heavy, rarely read back, e.g. the llmq database. Most of the cache is used as
+     *             write buffers, larger files.
+     * Returns false if there's no profile with that name.
+     */
+    static bool FromName(const std::string& strName, CDBProfile& profileOut);
+};
+
+//! Returns the profile for the named database: "chainstate", "blockindex", "evo" or "llmq"
+CDBProfile GetDBProfile(const std::string& strDatabase);
+//! Checks the -dbprofile arguments, returns false and sets strError if one is invalid
+bool CheckDBProfileArgs(std::string& strError);
+//! Shares nFiles file descriptors between the databases that have a profile, called once the limit is known
+void SetDBFileDescriptorBudget(int nFiles);
+
 class dbwrapper_error : public std::runtime_error
 {
 public:
@@ -244,8 +288,9 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] profile     LevelDB tuning for the access pattern of the database.
      */
-    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false, const CDBProfile& profile = CDBProfile());
     ~CDBWrapper();
 
     template <typename K>
@@ -258,18 +258,19 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::CalculateQuorum(size_t m
 {
     auto scores = CalculateScores(modifier);
 
-    // sort is descending order
-    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+    // only the top maxSize entries are needed, sorted in descending order
+    auto mid = scores.begin() + std::min(maxSize, scores.size());
+    std::partial_sort(scores.begin(), mid, scores.end(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
         if (a.first == b.first) {
             // this should actually never happen, but we should stay compatible with how the non deterministic MNs did the sorting
-            return a.second->collateralOutpoint < b.second->collateralOutpoint;
+            return b.second->collateralOutpoint < a.second->collateralOutpoint;
         }
-        return a.first < b.first;
+        return b.first < a.first;
     });
 
     // take top maxSize entries and return it
     std::vector<CDeterministicMNCPtr> result;
-    result.resize(std::min(maxSize, scores.size()));
+    result.resize(mid - scores.begin());
     for (size_t i = 0; i < result.size(); i++) {
         result[i] = std::move(scores[i].second);
     }
@@ -499,7 +500,8 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
 }
 
 CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb) :
-    evoDb(_evoDb)
+    evoDb(_evoDb),
+    mnListsCache(MAX_LISTS_CACHE_SIZE)
 {
 }
 
@@ -561,9 +563,6 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
         LogPrintf("CDeterministicMNManager::%s -- DIP3 is enforced now. nHeight=%d\n", __func__, nHeight);
     }
 
-    LOCK(cs);
-    CleanupCache(nHeight);
-
     return true;
 }
 
@@ -912,21 +911,24 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
 
     while (true) {
         // try using cache before reading from disk
-        auto it = mnListsCache.find(pindex->GetBlockHash());
-        if (it != mnListsCache.end()) {
-            snapshot = it->second;
+        if (mnListsCache.get(pindex->GetBlockHash(), snapshot)) {
             break;
         }
 
-        if (evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+        // Snapshots are only written every SNAPSHOT_LIST_PERIOD blocks and for the very first list, which also
+        // has a diff on top of the empty list. Don't hit the DB for snapshots in between.
+        if ((pindex->nHeight % SNAPSHOT_LIST_PERIOD) == 0 &&
+                evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
+            mnListsCache.insert(pindex->GetBlockHash(), snapshot);
             break;
         }
 
         CDeterministicMNListDiff diff;
         if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diff)) {
-            snapshot = CDeterministicMNList(pindex->GetBlockHash(), -1, 0);
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            if (!evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
+                snapshot = CDeterministicMNList(pindex->GetBlockHash(), -1, 0);
+            }
+            mnListsCache.insert(pindex->GetBlockHash(), snapshot);
             break;
         }
 
@@ -934,6 +936,10 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
         pindex = pindex->pprev;
     }
 
+    // Only keep intermediate lists close to the tip, deep queries (e.g. "protx diff") would otherwise push
+    // them out of the cache with lists nobody asks for again
+    int nCacheHeight = tipIndex ? tipIndex->nHeight - LISTS_CACHE_SIZE : 0;
+
     for (const auto& p : listDiff) {
         auto diffIndex = p.first;
         auto& diff = p.second;
@@ -944,7 +950,9 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
             snapshot.SetHeight(diffIndex->nHeight);
         }
 
-        mnListsCache.emplace(diffIndex->GetBlockHash(), snapshot);
+        if (diffIndex->nHeight >= nCacheHeight || &p == &listDiff.back()) {
+            mnListsCache.insert(diffIndex->GetBlockHash(), snapshot);
+        }
     }
 
     return snapshot;
@@ -995,21 +1003,6 @@ bool CDeterministicMNManager::IsDIP3Enforced(int nHeight)
     return nHeight >= Params().GetConsensus().DIP0003EnforcementHeight;
 }
 
-void CDeterministicMNManager::CleanupCache(int nHeight)
-{
-    AssertLockHeld(cs);
-
-    std::vector<uint256> toDelete;
-    for (const auto& p : mnListsCache) {
-        if (p.second.GetHeight() + LISTS_CACHE_SIZE < nHeight) {
-            toDelete.emplace_back(p.first);
-        }
-    }
-    for (const auto& h : toDelete) {
-        mnListsCache.erase(h);
-    }
-}
-
 bool CDeterministicMNManager::UpgradeDiff(CDBBatch& batch, const CBlockIndex* pindexNext, const CDeterministicMNList& curMNList, CDeterministicMNList& newMNList)
 {
     CDataStream oldDiffData(SER_DISK, CLIENT_VERSION);
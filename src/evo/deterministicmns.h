@@ -10,8 +10,10 @@
 #include "dbwrapper.h"
 #include "evodb.h"
 #include "providertx.h"
+#include "saltedhasher.h"
 #include "simplifiedmns.h"
 #include "sync.h"
+#include "unordered_lru_cache.h"
 
 #include "immer/map.hpp"
 #include "immer/map_transient.hpp"
@@ -626,7 +628,10 @@ public:
 class CDeterministicMNManager
 {
     static const int SNAPSHOT_LIST_PERIOD = 576; // once per day
+    // lists of this many blocks below the tip are cached for every block walked
     static const int LISTS_CACHE_SIZE = 576;
+    // upper bound on cached lists, lists share most of their immer nodes so each one only costs its own changes
+    static const int MAX_LISTS_CACHE_SIZE = LISTS_CACHE_SIZE * 2;
 
 public:
     CCriticalSection cs;
@@ -634,7 +639,7 @@ public:
 private:
     CEvoDB& evoDb;
 
-    std::map<uint256, CDeterministicMNList> mnListsCache;
+    unordered_lru_cache<uint256, CDeterministicMNList, StaticSaltedHasher> mnListsCache;
     const CBlockIndex* tipIndex{nullptr};
 
 public:
@@ -663,9 +668,6 @@ public:
     bool UpgradeDiff(CDBBatch& batch, const CBlockIndex* pindexNext, const CDeterministicMNList& curMNList, CDeterministicMNList& newMNList);
     void UpgradeDBIfNeeded();
     static bool IsDIP3Active(int height);
-
-private:
-    void CleanupCache(int nHeight);
 };
 
 extern CDeterministicMNManager* deterministicMNManager;
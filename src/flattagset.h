@@ -0,0 +1,239 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef FIRO_FLATTAGSET_H
+#define FIRO_FLATTAGSET_H
+
+#include "memusage.h"
+#include "uint256.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+/**
+ * Set of used linking tags or serials, each with the id of the group it was spent from.
+ *
+ * Node based maps keep every tag in its own allocation, and the group element or scalar inside holds
+ * another one. This is an open addressing table with linear probing instead. A slot is 16 bytes: the
+ * first 8 bytes of the tag hash, the index of the serialized tag and the group id. A lookup compares
+ * fingerprints in the slots, which share cache lines, and compares the serialized tag only when they
+ * match. The table grows from the stored fingerprints, so tags aren't hashed again like they are when
+ * an unordered_map rehashes. HashFn is the hash the tags are already known by, e.g. GetLTagHash.
+ */
+template <typename T, uint256 (*HashFn)(const T&)>
+class CFlatTagSet
+{
+public:
+    static constexpr size_t SERIALIZED_SIZE = T::memoryRequired();
+    typedef std::array<unsigned char, SERIALIZED_SIZE> SerializedTag;
+
+    CFlatTagSet() : nSize(0) {}
+
+    size_t size() const { return nSize; }
+    bool empty() const { return nSize == 0; }
+    size_t count(const T& tag) const
+    {
+        int nGroupId;
+        return Find(tag, nGroupId) ? 1 : 0;
+    }
+
+    // Adds the tag, or updates its group id if it's there
+    void insert(const T& tag, int nGroupId)
+    {
+        SerializedTag serialized;
+        tag.serialize(serialized.data());
+        uint64_t nFingerprint = Fingerprint(HashFn(tag));
+        size_t nSlot = FindSlot(nFingerprint, serialized);
+        if (nSlot != NOT_FOUND) {
+            slots[nSlot].nGroupId = nGroupId;
+            return;
+        }
+
+        if ((nSize + 1) * MAX_LOAD_DENOMINATOR > slots.size() * MAX_LOAD_NUMERATOR)
+            Rehash(std::max<size_t>(MIN_SLOTS, slots.size() * 2));
+
+        uint32_t nEntry;
+        if (!freeEntries.empty()) {
+            nEntry = freeEntries.back();
+            freeEntries.pop_back();
+            entries[nEntry] = serialized;
+        } else {
+            nEntry = entries.size();
+            entries.push_back(serialized);
+        }
+        Place(Slot{nFingerprint, nEntry, nGroupId});
+        nSize++;
+    }
+
+    bool erase(const T& tag)
+    {
+        SerializedTag serialized;
+        tag.serialize(serialized.data());
+        size_t nSlot = FindSlot(Fingerprint(HashFn(tag)), serialized);
+        if (nSlot == NOT_FOUND)
+            return false;
+
+        freeEntries.push_back(slots[nSlot].nEntry);
+        // shift the following slots of the probe sequence back, no tombstones are left
+        size_t nMask = slots.size() - 1;
+        size_t nNext = nSlot;
+        while (true) {
+            nNext = (nNext + 1) & nMask;
+            if (slots[nNext].nEntry == EMPTY)
+                break;
+            size_t nHome = slots[nNext].nFingerprint & nMask;
+            bool fStays = nSlot <= nNext ? (nSlot < nHome && nHome <= nNext) : (nSlot < nHome || nHome <= nNext);
+            if (fStays)
+                continue;
+            slots[nSlot] = slots[nNext];
+            nSlot = nNext;
+        }
+        slots[nSlot].nEntry = EMPTY;
+        nSize--;
+        return true;
+    }
+
+    bool Find(const T& tag, int& nGroupId) const
+    {
+        if (nSize == 0)
+            return false;
+        SerializedTag serialized;
+        tag.serialize(serialized.data());
+        size_t nSlot = FindSlot(Fingerprint(HashFn(tag)), serialized);
+        if (nSlot == NOT_FOUND)
+            return false;
+        nGroupId = slots[nSlot].nGroupId;
+        return true;
+    }
+
+    // Looks a tag up by its hash, the tag is stored in the first argument
+    bool FindHash(T& tag, const uint256& tagHash) const
+    {
+        if (nSize == 0)
+            return false;
+        uint64_t nFingerprint = Fingerprint(tagHash);
+        size_t nMask = slots.size() - 1;
+        for (size_t nSlot = nFingerprint & nMask; slots[nSlot].nEntry != EMPTY; nSlot = (nSlot + 1) & nMask) {
+            if (slots[nSlot].nFingerprint != nFingerprint)
+                continue;
+            T candidate;
+            candidate.deserialize(entries[slots[nSlot].nEntry].data());
+            if (HashFn(candidate) == tagHash) {
+                tag = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void reserve(size_t n)
+    {
+        size_t nSlots = MIN_SLOTS;
+        while (n * MAX_LOAD_DENOMINATOR > nSlots * MAX_LOAD_NUMERATOR)
+            nSlots *= 2;
+        if (nSlots > slots.size())
+            Rehash(nSlots);
+        entries.reserve(n);
+    }
+
+    void clear()
+    {
+        std::vector<Slot>().swap(slots);
+        std::vector<SerializedTag>().swap(entries);
+        std::vector<uint32_t>().swap(freeEntries);
+        nSize = 0;
+    }
+
+    // Calls fn(tag, group id) for every tag
+    template <typename Fn>
+    void ForEach(Fn fn) const
+    {
+        for (const Slot& slot : slots) {
+            if (slot.nEntry == EMPTY)
+                continue;
+            T tag;
+            tag.deserialize(entries[slot.nEntry].data());
+            fn(tag, slot.nGroupId);
+        }
+    }
+
+    // Calls fn(serialized tag, group id) for every tag, the tags aren't deserialized
+    template <typename Fn>
+    void ForEachSerialized(Fn fn) const
+    {
+        for (const Slot& slot : slots) {
+            if (slot.nEntry != EMPTY)
+                fn(entries[slot.nEntry], slot.nGroupId);
+        }
+    }
+
+    size_t DynamicMemoryUsage() const
+    {
+        return memusage::DynamicUsage(slots) + memusage::DynamicUsage(entries) + memusage::DynamicUsage(freeEntries);
+    }
+
+private:
+    struct Slot {
+        uint64_t nFingerprint;
+        uint32_t nEntry;
+        int32_t nGroupId;
+    };
+
+    static constexpr uint32_t EMPTY = 0xffffffff;
+    static constexpr size_t NOT_FOUND = (size_t)-1;
+    static constexpr size_t MIN_SLOTS = 16;
+    // at most 3/4 of the slots are used
+    static constexpr size_t MAX_LOAD_NUMERATOR = 3;
+    static constexpr size_t MAX_LOAD_DENOMINATOR = 4;
+
+    // a power of two, empty until the first tag is added
+    std::vector<Slot> slots;
+    std::vector<SerializedTag> entries;
+    // entries of erased tags, reused by the next ones
+    std::vector<uint32_t> freeEntries;
+    size_t nSize;
+
+    static uint64_t Fingerprint(const uint256& hash)
+    {
+        uint64_t nFingerprint;
+        memcpy(&nFingerprint, hash.begin(), sizeof(nFingerprint));
+        return nFingerprint;
+    }
+
+    size_t FindSlot(uint64_t nFingerprint, const SerializedTag& serialized) const
+    {
+        if (slots.empty())
+            return NOT_FOUND;
+        size_t nMask = slots.size() - 1;
+        for (size_t nSlot = nFingerprint & nMask; slots[nSlot].nEntry != EMPTY; nSlot = (nSlot + 1) & nMask) {
+            if (slots[nSlot].nFingerprint == nFingerprint && entries[slots[nSlot].nEntry] == serialized)
+                return nSlot;
+        }
+        return NOT_FOUND;
+    }
+
+    void Place(const Slot& slot)
+    {
+        size_t nMask = slots.size() - 1;
+        size_t nSlot = slot.nFingerprint & nMask;
+        while (slots[nSlot].nEntry != EMPTY)
+            nSlot = (nSlot + 1) & nMask;
+        slots[nSlot] = slot;
+    }
+
+    void Rehash(size_t nSlots)
+    {
+        std::vector<Slot> oldSlots;
+        oldSlots.swap(slots);
+        slots.assign(nSlots, Slot{0, EMPTY, 0});
+        for (const Slot& slot : oldSlots) {
+            if (slot.nEntry != EMPTY)
+                Place(slot);
+        }
+    }
+};
+
+#endif // FIRO_FLATTAGSET_H
@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "liblelantus/threadpool.h"
 #include "hdmint/wallet.h"
 #include "validation.h"
 #include "txdb.h"
@@ -156,36 +157,88 @@ void CHDMintWallet::GenerateMintPool(CWalletDB& walletdb, bool forceGenerate, in
     if(nIndex > 0 && nIndex >= nLastCount)
         nStop = nIndex + mintpoolsize;
     LogPrintf("%s : nLastCount=%d nStop=%d\n", __func__, nLastCount, nStop - 1);
+
+    // Keys have to be derived in order, they advance the HD chain
+    std::vector<MintPoolSeed> seeds;
+    seeds.reserve(nStop - nLastCount + 1);
     for (; nLastCount <= nStop; ++nLastCount) {
         if (ShutdownRequested())
             return;
 
-        CKeyID seedId;
-        uint512 mintSeed;
-        if(!CreateMintSeed(walletdb, mintSeed, nLastCount, seedId, false))
+        MintPoolSeed seed;
+        seed.nCount = nLastCount;
+        if(!CreateMintSeed(walletdb, seed.mintSeed, nLastCount, seed.seedId, false))
             continue;
+        seeds.push_back(seed);
+    }
 
-        GroupElement commitmentValue;
-        sigma::PrivateCoin coin(sigma::Params::get_default(), sigma::CoinDenomination::SIGMA_DENOM_1);
-        if(!SeedToMint(mintSeed, commitmentValue, coin)) //for lelantus put just part of commit, for checking we will need to reduce h1^v from lelantus mint
-            continue;
+    SeedsToMints(seeds);
 
-        uint256 hashPubcoin = primitives::GetPubCoinValueHash(commitmentValue);
+    // Write all entries in one transaction, unless the caller already has one open
+    bool fTxn = walletdb.TxnBegin();
+    for (const MintPoolSeed& seed : seeds) {
+        if (!seed.fValid)
+            continue;
 
-        MintPoolEntry mintPoolEntry(hashSeedMaster, seedId, nLastCount);
-        mintPool.Add(std::make_pair(hashPubcoin, mintPoolEntry));
-        walletdb.WritePubcoin(primitives::GetSerialHash(coin.getSerialNumber()), commitmentValue);
-        walletdb.WriteMintPoolPair(hashPubcoin, mintPoolEntry);
+        MintPoolEntry mintPoolEntry(hashSeedMaster, seed.seedId, seed.nCount);
+        mintPool.Add(std::make_pair(seed.hashPubcoin, mintPoolEntry));
+        walletdb.WritePubcoin(seed.hashSerial, seed.commitment);
+        walletdb.WriteMintPoolPair(seed.hashPubcoin, mintPoolEntry);
     }
 
     // write hdchain back to database
-    if (!walletdb.WriteHDChain(pwalletMain->GetHDChain()))
+    if (!walletdb.WriteHDChain(pwalletMain->GetHDChain())) {
+        if (fTxn)
+            walletdb.TxnAbort();
         throw std::runtime_error(std::string(__func__) + ": Writing HD chain model failed");
+    }
 
     // Update local + DB entries for count last generated
     nCountNextGenerate = nLastCount;
     walletdb.WriteMintSeedCount(nCountNextGenerate);
 
+    if (fTxn && !walletdb.TxnCommit())
+        throw std::runtime_error(std::string(__func__) + ": Writing mint pool failed");
+}
+
+/**
+ * Compute the mints of a batch of mint seeds.
+ *
+ * The commitments are independent of each other and each one costs a key pair, a hash to the group and a
+ * Pedersen commitment, so they are computed in parallel. Seeds that fail to convert are marked invalid.
+ *
+ * @param seeds the seeds, their commitment and hashes are set
+ */
+void CHDMintWallet::SeedsToMints(std::vector<MintPoolSeed>& seeds)
+{
+    if (seeds.empty())
+        return;
+
+    std::size_t threadsMaxCount = std::min(seeds.size(), (std::size_t)std::max(boost::thread::hardware_concurrency(), 1u));
+    std::size_t chunkSize = (seeds.size() + threadsMaxCount - 1) / threadsMaxCount;
+    ParallelOpThreadPool<void> threadPool(threadsMaxCount);
+    std::vector<boost::future<void>> parallelTasks;
+    parallelTasks.reserve(threadsMaxCount);
+
+    for (std::size_t begin = 0; begin < seeds.size(); begin += chunkSize) {
+        std::size_t end = std::min(begin + chunkSize, seeds.size());
+        parallelTasks.push_back(threadPool.PostTask([this, &seeds, begin, end]() {
+            // constructing a coin mints a random one, reuse it for the whole chunk as SeedToMint overwrites it
+            sigma::PrivateCoin coin(sigma::Params::get_default(), sigma::CoinDenomination::SIGMA_DENOM_1);
+            for (std::size_t i = begin; i < end; i++) {
+                MintPoolSeed& seed = seeds[i];
+                //for lelantus put just part of commit, for checking we will need to reduce h1^v from lelantus mint
+                seed.fValid = SeedToMint(seed.mintSeed, seed.commitment, coin);
+                if (!seed.fValid)
+                    continue;
+                seed.hashPubcoin = primitives::GetPubCoinValueHash(seed.commitment);
+                seed.hashSerial = primitives::GetSerialHash(coin.getSerialNumber());
+            }
+        }));
+    }
+
+    for (auto& task : parallelTasks)
+        task.get();
 }
 
 /**
@@ -270,6 +323,31 @@ void CHDMintWallet::SyncWithChain(bool fGenerateMintPool, boost::optional<std::l
             listMints = std::list<std::pair<uint256, MintPoolEntry>>();
             mintPool.List(listMints.get());
         }
+
+        // sigma mints are looked up by the hash of their value, which needs a pass over all mints on chain,
+        // so do it once for all the mints not checked yet
+        std::unordered_set<uint256> setUnchecked;
+        for (const std::pair<uint256, MintPoolEntry>& pMint : listMints.get()) {
+            if (!setChecked.count(pMint.first))
+                setUnchecked.insert(pMint.first);
+        }
+        std::unordered_map<uint256, GroupElement> mapSigmaPubCoins;
+        sigma::CSigmaState::GetState()->FindCoinHashes(setUnchecked, mapSigmaPubCoins);
+
+        // lelantus mints are found by their tags, all of them at once
+        uiInterface.UpdateProgressBarLabel("Synchronizing mints...");
+        std::vector<LelantusMintCandidate> lelantusMints;
+        RecoverLelantusMints(walletdb, listMints.get(), setChecked, lelantusMints);
+        if (ShutdownRequested())
+            return;
+        if (!lelantusMints.empty()) {
+            SetLelantusMintsSeen(walletdb, lelantusMints, setAddedTx);
+            for (const LelantusMintCandidate& mint : lelantusMints)
+                setChecked.insert(mint.mintPoolEntry.first);
+            found = true;
+            mintsFound += lelantusMints.size();
+        }
+
         for (std::pair<uint256, MintPoolEntry>& pMint : listMints.get()) {
             if (setChecked.count(pMint.first))
                 continue;
@@ -285,113 +363,8 @@ void CHDMintWallet::SyncWithChain(bool fGenerateMintPool, boost::optional<std::l
             if (tracker.HasPubcoinHash(pMint.first, walletdb))
                 continue;
 
-            uint160 seedId = std::get<1>(pMint.second);
-            CDataStream ss(SER_GETHASH, 0);
-            ss << pMint.first;
-            ss << seedId;
-            uint256 mintTag = Hash(ss.begin(), ss.end());
-
             COutPoint outPoint;
-            if (!pwalletMain->IsLocked() && lelantus::GetOutPointFromMintTag(outPoint, mintTag)) {
-                const uint256& txHash = outPoint.hash;
-                //this mint has already occurred on the chain, increment counter's state to reflect this
-                LogPrintf("%s : Found wallet coin mint=%s count=%d tx=%s\n", __func__, pMint.first.GetHex(), mintCount, txHash.GetHex());
-                found = true;
-
-                uint256 hashBlock;
-                CTransactionRef tx;
-                if (!GetTransaction(txHash, tx, Params().GetConsensus(), hashBlock, true)) {
-                    LogPrintf("%s : failed to get transaction for mint %s!\n", __func__, pMint.first.GetHex());
-                    found = false;
-                    continue;
-                }
-
-                uint64_t amount  = 0;
-                bool fFoundMint = false;
-                for (const CTxOut& out : tx->vout) {
-                    if (!out.scriptPubKey.IsLelantusMint() && !out.scriptPubKey.IsLelantusJMint())
-                        continue;
-                    secp_primitives::GroupElement pubcoin;
-                    try {
-                        if (out.scriptPubKey.IsLelantusMint()) {
-                            amount = out.nValue;
-                            lelantus::ParseLelantusMintScript(out.scriptPubKey, pubcoin);
-                        }  else {
-                            std::vector<unsigned char> encryptedValue;
-                            lelantus::ParseLelantusJMintScript(out.scriptPubKey, pubcoin, encryptedValue);
-                            if(!pwalletMain->DecryptMintAmount(encryptedValue, pubcoin, amount))
-                                continue;
-                        }
-                    } catch (std::invalid_argument&) {
-                        continue;
-                    }
-                    if(amount != 0)
-                        pubcoin += lelantus::Params::get_default()->get_h1() * Scalar(amount).negate();
-                    // See if this is the mint that we are looking for
-                    uint256 hashPubcoin = primitives::GetPubCoinValueHash(pubcoin);
-                    if (pMint.first == hashPubcoin) {
-                        fFoundMint = true;
-                        break;
-                    }
-                }
-
-                if (!fFoundMint) {
-                    LogPrintf("%s : failed to get mint %s from tx %s!\n", __func__, pMint.first.GetHex(), tx->GetHash().GetHex());
-                    found = false;
-                    break;
-                }
-
-                CBlockIndex* pindex = nullptr;
-                if (mapBlockIndex.count(hashBlock))
-                    pindex = mapBlockIndex.at(hashBlock);
-
-                if (!setAddedTx.count(txHash)) {
-                    CBlock block;
-                    CWalletTx wtx(pwalletMain, tx);
-                    if (pindex && ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
-                        SetWalletTransactionBlock(wtx, pindex, block);
-
-                    //Fill out wtx so that a transaction record can be created
-                    wtx.nTimeReceived = pindex->GetBlockTime();
-                    pwalletMain->AddToWallet(wtx, false);
-                    setAddedTx.insert(txHash);
-                }
-
-                if(!SetLelantusMintSeedSeen(walletdb, pMint, pindex->nHeight, txHash, amount))
-                    continue;
-
-                if (tx->IsLelantusJoinSplit()) {
-                    std::vector<Scalar> serials = lelantus::GetLelantusJoinSplitSerialNumbers(*tx, tx->vin[0]);
-                    for (auto& serial : serials) {
-                        CLelantusMintMeta mMeta;
-                        if (!tracker.GetMetaFromSerial(primitives::GetSerialHash(serial), mMeta))
-                            continue;
-
-                        if (mMeta.isUsed)
-                            continue;
-
-                        tracker.SetLelantusPubcoinUsed(mMeta.GetPubCoinValueHash(), tx->GetHash());
-
-                        // add CLelantusSpendEntry
-                        CLelantusSpendEntry spend;
-                        spend.coinSerial = serial;
-                        spend.hashTx = tx->GetHash();
-                        spend.pubCoin = mMeta.GetPubCoinValue();
-                        spend.id = mMeta.nId;
-                        spend.amount = mMeta.amount;
-                        if (!walletdb.WriteLelantusSpendSerialEntry(spend)) {
-                            throw std::runtime_error(_("Failed to write coin serial number into wallet"));
-                        }
-                    }
-                }
-
-                // Only update if the current hashSeedMaster matches the mints'
-                if(hashSeedMaster == mintHashSeedMaster && mintCount >= GetCount()){
-                    SetCount(++mintCount);
-                    UpdateCountDB(walletdb);
-                    LogPrint("zero", "%s: updated count to %d\n", __func__, nCountNextUse);
-                }
-            } if (sigma::GetOutPoint(outPoint, pMint.first)) {
+            if (mapSigmaPubCoins.count(pMint.first) && sigma::GetOutPoint(outPoint, mapSigmaPubCoins.at(pMint.first))) {
                 const uint256& txHash = outPoint.hash;
                 //this mint has already occurred on the chain, increment counter's state to reflect this
                 LogPrintf("%s : Found wallet coin mint=%s count=%d tx=%s\n", __func__, pMint.first.GetHex(), mintCount, txHash.GetHex());
@@ -474,6 +447,252 @@ void CHDMintWallet::SyncWithChain(bool fGenerateMintPool, boost::optional<std::l
     } while (found || mintsFound > 0);
 }
 
+/**
+ * Find the Lelantus mints of the mint pool on chain.
+ *
+ * The state knows the pubcoin of each mint by its tag, so only the output holding it is decrypted rather
+ * than every JMint of the transaction. Transactions are read here, reading them takes cs_main. The amounts
+ * are decrypted in parallel afterwards and each mint is checked against the hash the mint pool has for it.
+ *
+ * @param walletdb wallet database
+ * @param listMints mint pool entries to look for
+ * @param setChecked entries already looked for, skipped
+ * @param recovered the mints found, in the order of listMints
+ */
+void CHDMintWallet::RecoverLelantusMints(CWalletDB& walletdb, const std::list<std::pair<uint256, MintPoolEntry>>& listMints, const std::set<uint256>& setChecked, std::vector<LelantusMintCandidate>& recovered)
+{
+    recovered.clear();
+    if (pwalletMain->IsLocked())
+        return;
+
+    lelantus::CLelantusState *lelantusState = lelantus::CLelantusState::GetState();
+    std::map<uint256, std::pair<CTransactionRef, uint256>> mapTxs;
+    std::vector<LelantusMintCandidate> candidates;
+    for (const std::pair<uint256, MintPoolEntry>& pMint : listMints) {
+        if (ShutdownRequested())
+            return;
+        if (setChecked.count(pMint.first) || tracker.HasPubcoinHash(pMint.first, walletdb))
+            continue;
+
+        uint160 seedId = std::get<1>(pMint.second);
+        CDataStream ss(SER_GETHASH, 0);
+        ss << pMint.first;
+        ss << seedId;
+        uint256 mintTag = Hash(ss.begin(), ss.end());
+
+        GroupElement pubCoinValue;
+        COutPoint outPoint;
+        if (!lelantusState->HasCoinTag(pubCoinValue, mintTag) || !lelantus::GetOutPoint(outPoint, pubCoinValue))
+            continue;
+
+        auto itTx = mapTxs.find(outPoint.hash);
+        if (itTx == mapTxs.end()) {
+            uint256 hashBlock;
+            CTransactionRef tx;
+            if (!GetTransaction(outPoint.hash, tx, Params().GetConsensus(), hashBlock, true)) {
+                LogPrintf("%s : failed to get transaction for mint %s!\n", __func__, pMint.first.GetHex());
+                continue;
+            }
+            itTx = mapTxs.insert(std::make_pair(outPoint.hash, std::make_pair(tx, hashBlock))).first;
+        }
+
+        LelantusMintCandidate candidate;
+        candidate.mintPoolEntry = pMint;
+        candidate.tx = itTx->second.first;
+        candidate.hashBlock = itTx->second.second;
+        bool fFoundOutput = false;
+        for (const CTxOut& out : candidate.tx->vout) {
+            try {
+                if (out.scriptPubKey.IsLelantusMint()) {
+                    lelantus::ParseLelantusMintScript(out.scriptPubKey, candidate.pubcoin);
+                    candidate.encryptedValue.clear();
+                    candidate.amount = out.nValue;
+                } else if (out.scriptPubKey.IsLelantusJMint()) {
+                    lelantus::ParseLelantusJMintScript(out.scriptPubKey, candidate.pubcoin, candidate.encryptedValue);
+                    candidate.amount = 0;
+                } else {
+                    continue;
+                }
+            } catch (std::invalid_argument&) {
+                continue;
+            }
+            if (candidate.pubcoin == pubCoinValue) {
+                fFoundOutput = true;
+                break;
+            }
+        }
+
+        if (!fFoundOutput) {
+            LogPrintf("%s : failed to get mint %s from tx %s!\n", __func__, pMint.first.GetHex(), candidate.tx->GetHash().GetHex());
+            continue;
+        }
+        candidates.push_back(std::move(candidate));
+    }
+
+    if (candidates.empty())
+        return;
+
+    // derived once, deriving each key from the seed is what made decrypting the amounts slow
+    CExtKey mintValueKey;
+    {
+        LOCK(pwalletMain->cs_wallet);
+        mintValueKey = pwalletMain->GetKeypathChainKey(BIP44_MINT_VALUE_INDEX);
+    }
+    DecryptLelantusMints(mintValueKey, candidates);
+
+    for (LelantusMintCandidate& candidate : candidates) {
+        if (!candidate.fValid) {
+            LogPrintf("%s : failed to get mint %s from tx %s!\n", __func__, candidate.mintPoolEntry.first.GetHex(), candidate.tx->GetHash().GetHex());
+            continue;
+        }
+        recovered.push_back(std::move(candidate));
+    }
+}
+
+/**
+ * Decrypt the amounts of Lelantus mints found on chain and check them.
+ *
+ * Takes no locks, the mints are split across threads. A mint is valid if its pubcoin without the amount
+ * hashes to the pubcoin hash of its mint pool entry.
+ *
+ * @param mintValueKey the key amounts are encrypted with keys derived from
+ * @param candidates the mints, their amount and fValid are set
+ */
+void CHDMintWallet::DecryptLelantusMints(const CExtKey& mintValueKey, std::vector<LelantusMintCandidate>& candidates)
+{
+    if (candidates.empty())
+        return;
+
+    std::size_t threadsMaxCount = std::min(candidates.size(), (std::size_t)std::max(boost::thread::hardware_concurrency(), 1u));
+    std::size_t chunkSize = (candidates.size() + threadsMaxCount - 1) / threadsMaxCount;
+    ParallelOpThreadPool<void> threadPool(threadsMaxCount);
+    std::vector<boost::future<void>> parallelTasks;
+    parallelTasks.reserve(threadsMaxCount);
+
+    const GroupElement& h1 = lelantus::Params::get_default()->get_h1();
+    for (std::size_t begin = 0; begin < candidates.size(); begin += chunkSize) {
+        std::size_t end = std::min(begin + chunkSize, candidates.size());
+        parallelTasks.push_back(threadPool.PostTask([&mintValueKey, &candidates, &h1, begin, end]() {
+            for (std::size_t i = begin; i < end; i++) {
+                LelantusMintCandidate& candidate = candidates[i];
+                candidate.fValid = false;
+                if (!candidate.encryptedValue.empty() && !CWallet::DecryptMintAmount(mintValueKey, candidate.encryptedValue, candidate.pubcoin, candidate.amount))
+                    continue;
+
+                GroupElement pubcoin = candidate.pubcoin;
+                if (candidate.amount != 0)
+                    pubcoin += h1 * Scalar(candidate.amount).negate();
+                candidate.fValid = primitives::GetPubCoinValueHash(pubcoin) == candidate.mintPoolEntry.first;
+            }
+        }));
+    }
+
+    for (auto& task : parallelTasks)
+        task.get();
+}
+
+/**
+ * Add Lelantus mints found on chain to the wallet and the mint tracker.
+ *
+ * The mints are written in one wallet database transaction. Wallet transactions, spent states and the keys of
+ * a refilled mint pool are written through database handles of their own, which would wait on the open
+ * transaction, so the mint transactions are added before it and the rest after it is committed.
+ *
+ * @param walletdb wallet database
+ * @param mints the mints RecoverLelantusMints found
+ * @param setAddedTx transactions already added to the wallet
+ */
+void CHDMintWallet::SetLelantusMintsSeen(CWalletDB& walletdb, const std::vector<LelantusMintCandidate>& mints, std::set<uint256>& setAddedTx)
+{
+    std::vector<CBlockIndex*> vIndex;
+    vIndex.reserve(mints.size());
+    for (const LelantusMintCandidate& mint : mints) {
+        const uint256& txHash = mint.tx->GetHash();
+        //this mint has already occurred on the chain, increment counter's state to reflect this
+        LogPrintf("%s : Found wallet coin mint=%s count=%d tx=%s\n", __func__, mint.mintPoolEntry.first.GetHex(), std::get<2>(mint.mintPoolEntry.second), txHash.GetHex());
+
+        CBlockIndex* pindex = nullptr;
+        if (mapBlockIndex.count(mint.hashBlock))
+            pindex = mapBlockIndex.at(mint.hashBlock);
+        vIndex.push_back(pindex);
+
+        if (!pindex || setAddedTx.count(txHash))
+            continue;
+
+        CBlock block;
+        CWalletTx wtx(pwalletMain, mint.tx);
+        if (ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+            SetWalletTransactionBlock(wtx, pindex, block);
+
+        //Fill out wtx so that a transaction record can be created
+        wtx.nTimeReceived = pindex->GetBlockTime();
+        pwalletMain->AddToWallet(wtx, false);
+        setAddedTx.insert(txHash);
+    }
+
+    std::vector<CWalletTx> spendWtxs;
+    std::vector<std::pair<uint256, uint256>> usedPubcoins;
+    // the spent states are set after the batch, a joinsplit with several of the mints is handled once
+    std::set<uint256> setSpendTx;
+    bool fCountUpdated = false;
+    bool fTxn = walletdb.TxnBegin();
+    for (std::size_t i = 0; i < mints.size(); i++) {
+        const LelantusMintCandidate& mint = mints[i];
+        const CTransactionRef& tx = mint.tx;
+        if (!vIndex[i])
+            continue;
+
+        if (!SetLelantusMintSeedSeen(walletdb, mint.mintPoolEntry, vIndex[i]->nHeight, tx->GetHash(), mint.amount, &spendWtxs))
+            continue;
+
+        if (tx->IsLelantusJoinSplit() && setSpendTx.insert(tx->GetHash()).second) {
+            std::vector<Scalar> serials = lelantus::GetLelantusJoinSplitSerialNumbers(*tx, tx->vin[0]);
+            for (auto& serial : serials) {
+                CLelantusMintMeta mMeta;
+                if (!tracker.GetMetaFromSerial(primitives::GetSerialHash(serial), mMeta))
+                    continue;
+
+                if (mMeta.isUsed)
+                    continue;
+
+                usedPubcoins.push_back(std::make_pair(mMeta.GetPubCoinValueHash(), tx->GetHash()));
+
+                // add CLelantusSpendEntry
+                CLelantusSpendEntry spend;
+                spend.coinSerial = serial;
+                spend.hashTx = tx->GetHash();
+                spend.pubCoin = mMeta.GetPubCoinValue();
+                spend.id = mMeta.nId;
+                spend.amount = mMeta.amount;
+                if (!walletdb.WriteLelantusSpendSerialEntry(spend)) {
+                    throw std::runtime_error(_("Failed to write coin serial number into wallet"));
+                }
+            }
+        }
+
+        // Only update if the current hashSeedMaster matches the mints'. The mint pool is refilled after the
+        // transaction, generating keys writes them through handles of their own
+        int32_t mintCount = std::get<2>(mint.mintPoolEntry.second);
+        if(hashSeedMaster == std::get<0>(mint.mintPoolEntry.second) && mintCount >= GetCount()){
+            SetCount(++mintCount);
+            walletdb.WriteMintCount(nCountNextUse);
+            fCountUpdated = true;
+            LogPrint("zero", "%s: updated count to %d\n", __func__, nCountNextUse);
+        }
+    }
+
+    if (fTxn && !walletdb.TxnCommit())
+        throw std::runtime_error(std::string(__func__) + ": Writing recovered mints failed");
+
+    if (fCountUpdated)
+        UpdateCountDB(walletdb);
+
+    for (const CWalletTx& wtx : spendWtxs)
+        pwalletMain->AddToWallet(wtx, false);
+    for (const auto& usedPubcoin : usedPubcoins)
+        tracker.SetLelantusPubcoinUsed(usedPubcoin.first, usedPubcoin.second);
+}
+
 /**
  * Add the mint from the chain to the mint tracker.
  *
@@ -564,7 +783,7 @@ bool CHDMintWallet::SetMintSeedSeen(CWalletDB& walletdb, std::pair<uint256,MintP
     return true;
 }
 
-bool CHDMintWallet::SetLelantusMintSeedSeen(CWalletDB& walletdb, std::pair<uint256,MintPoolEntry> mintPoolEntryPair, int nHeight, const uint256& txid, uint64_t amount)
+bool CHDMintWallet::SetLelantusMintSeedSeen(CWalletDB& walletdb, std::pair<uint256,MintPoolEntry> mintPoolEntryPair, int nHeight, const uint256& txid, uint64_t amount, std::vector<CWalletTx>* pSpendWtxs)
 {
     // Regenerate the mint
     uint256 hashPubcoin = mintPoolEntryPair.first;
@@ -637,7 +856,10 @@ bool CHDMintWallet::SetLelantusMintSeedSeen(CWalletDB& walletdb, std::pair<uint2
             SetWalletTransactionBlock(wtx, pindex, block);
 
         wtx.nTimeReceived = pindex->nTime;
-        pwalletMain->AddToWallet(wtx, false);
+        if (pSpendWtxs)
+            pSpendWtxs->push_back(wtx);
+        else
+            pwalletMain->AddToWallet(wtx, false);
         used = true;
     } else {
         lelantus::CLelantusState *lelantusState = lelantus::CLelantusState::GetState();
@@ -17,6 +17,35 @@ class CHDMint;
 static const unsigned int DEFAULT_MINTPOOL_SIZE = 20;
 static const unsigned int MAX_MINTPOOL_SIZE = 200;
 
+// A mint seed of the mint pool and the mint derived from it
+struct MintPoolSeed
+{
+    int32_t nCount;
+    CKeyID seedId;
+    uint512 mintSeed;
+
+    bool fValid = false;
+    GroupElement commitment;
+    uint256 hashPubcoin;
+    uint256 hashSerial;
+};
+
+// A Lelantus mint of the mint pool found on chain, the amount of JMints is decrypted later
+struct LelantusMintCandidate
+{
+    std::pair<uint256, MintPoolEntry> mintPoolEntry;
+    CTransactionRef tx;
+    uint256 hashBlock;
+    // the pubcoin of the output, including the amount
+    GroupElement pubcoin;
+    // empty for mints, their amount is known
+    std::vector<unsigned char> encryptedValue;
+    uint64_t amount = 0;
+
+    // the amount matches the pubcoin the mint pool has
+    bool fValid = false;
+};
+
 class CHDMintWallet
 {
 private:
@@ -48,7 +77,8 @@ public:
     std::pair<uint256,uint256> RegenerateMintPoolEntry(CWalletDB& walletdb, const uint160& mintHashSeedMaster, CKeyID& seedId, const int32_t& nCount);
     void GenerateMintPool(CWalletDB& walletdb, bool forceGenerate = false, int32_t nIndex = 0);
     bool SetMintSeedSeen(CWalletDB& walletdb, std::pair<uint256,MintPoolEntry> mintPoolEntryPair, int nHeight, const uint256& txid, const sigma::CoinDenomination& denom);
-    bool SetLelantusMintSeedSeen(CWalletDB& walletdb, std::pair<uint256,MintPoolEntry> mintPoolEntryPair, int nHeight, const uint256& txid, uint64_t amount);
+    bool SetLelantusMintSeedSeen(CWalletDB& walletdb, std::pair<uint256,MintPoolEntry> mintPoolEntryPair, int nHeight, const uint256& txid, uint64_t amount, std::vector<CWalletTx>* pSpendWtxs = nullptr);
+    static void DecryptLelantusMints(const CExtKey& mintValueKey, std::vector<LelantusMintCandidate>& candidates);
     bool SeedToMint(const uint512& mintSeed, GroupElement& bnValue, sigma::PrivateCoin& coin);
     bool SeedToLelantusMint(const uint512& mintSeed, lelantus::PrivateCoin& coin);
 
@@ -64,6 +94,9 @@ public:
 private:
     CKeyID GetMintSeedID(CWalletDB& walletdb, int32_t nCount);
     bool CreateMintSeed(CWalletDB& walletdb, uint512& mintSeed, const int32_t& n, CKeyID& seedId, bool nWriteChain = true);
+    void SeedsToMints(std::vector<MintPoolSeed>& seeds);
+    void RecoverLelantusMints(CWalletDB& walletdb, const std::list<std::pair<uint256, MintPoolEntry>>& listMints, const std::set<uint256>& setChecked, std::vector<LelantusMintCandidate>& recovered);
+    void SetLelantusMintsSeen(CWalletDB& walletdb, const std::vector<LelantusMintCandidate>& mints, std::set<uint256>& setAddedTx);
 };
 
 #endif //FIRO_HDMINTWALLET_H
@@ -19,7 +19,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <atomic>
+#include <condition_variable>
 #include <future>
+#include <mutex>
 
 #include <event2/event.h>
 #include <event2/http.h>
@@ -37,6 +40,8 @@
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
+/** Bytes of a chunked reply that may wait in the output buffer before the worker waits for it to drain */
+static const size_t MAX_CHUNKED_REPLY_BUFFER = 4 * 1024 * 1024;
 
 /** HTTP request work item */
 class HTTPWorkItem : public HTTPClosure
@@ -177,6 +182,8 @@ struct evhttp* eventHTTP = 0;
 static std::vector<CSubNet> rpc_allow_subnets;
 //! Work queue for handling longer requests off the event loop thread
 static WorkQueue<HTTPClosure>* workQueue = 0;
+//! Set when the server is interrupted, workers stop waiting for chunked replies to drain
+static std::atomic<bool> fHTTPInterrupted(false);
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
@@ -449,6 +456,7 @@ bool StartHTTPServer()
     LogPrint("http", "Starting HTTP server\n");
     int rpcThreads = std::max((long)GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
     LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
+    fHTTPInterrupted = false;
     std::packaged_task<bool(event_base*, evhttp*)> task(ThreadHTTP);
     threadResult = task.get_future();
     threadHTTP = std::thread(std::move(task), eventBase, eventHTTP);
@@ -473,6 +481,7 @@ void InterruptHTTPServer()
     }
     if (workQueue)
         workQueue->Interrupt();
+    fHTTPInterrupted = true;
 }
 
 void StopHTTPServer()
@@ -539,12 +548,57 @@ void HTTPEvent::trigger(struct timeval* tv)
     else
         evtimer_add(ev, tv); // trigger after timeval passed
 }
+/** State of a chunked reply, shared between the worker thread and the event loop */
+struct HTTPChunkedReply
+{
+    std::mutex cs;
+    std::condition_variable cond;
+    /** Set from the event loop once the connection has been closed */
+    std::atomic<bool> fClosed;
+    /** Bytes queued since the output buffer was last drained */
+    size_t nBuffered;
+
+    HTTPChunkedReply() : fClosed(false), nBuffered(0) {}
+
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fClosed = true;
+        cond.notify_all();
+    }
+
+    void Drained()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nBuffered = 0;
+        cond.notify_all();
+    }
+};
+
+/** Called by evhttp when the connection of a chunked reply goes away */
+static void http_chunked_close_cb(struct evhttp_connection* conn, void* arg)
+{
+    static_cast<HTTPChunkedReply*>(arg)->Close();
+}
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+/** Called by evhttp once the output buffer of a chunked reply has been written out */
+static void http_chunked_drained_cb(struct evhttp_connection* conn, void* arg)
+{
+    static_cast<HTTPChunkedReply*>(arg)->Drained();
+}
+#endif
+
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
                                                        replySent(false)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
+    if (chunkedReply && !replySent) {
+        // The handler bailed out in the middle of a chunked reply
+        WriteReplyEnd();
+    }
     if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
@@ -610,6 +664,106 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = 0; // transferred back to main thread
 }
 
+static void http_release_shared_reply(const void* data, size_t datalen, void* extra)
+{
+    delete static_cast<std::shared_ptr<const std::vector<unsigned char>>*>(extra);
+}
+
+void HTTPRequest::WriteReply(int nStatus, std::shared_ptr<const std::vector<unsigned char>> reply)
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    // the reference held by the evbuffer is released once the reply has been sent
+    auto* ref = new std::shared_ptr<const std::vector<unsigned char>>(std::move(reply));
+    if (evbuffer_add_reference(evb, (*ref)->data(), (*ref)->size(), http_release_shared_reply, ref) != 0)
+        http_release_shared_reply(nullptr, 0, ref);
+    HTTPEvent* ev = new HTTPEvent(eventBase, true,
+        std::bind(evhttp_send_reply, req, nStatus, (const char*)NULL, (struct evbuffer *)NULL));
+    ev->trigger(0);
+    replySent = true;
+    req = 0; // transferred back to main thread
+}
+
+void HTTPRequest::WriteReplyStart(int nStatus)
+{
+    assert(!replySent && !chunkedReply && req);
+    chunkedReply = std::make_shared<HTTPChunkedReply>();
+    // All evhttp calls have to be made from the main http thread. Events are
+    // processed in the order they were triggered, so the chunks go out in order.
+    struct evhttp_request* r = req;
+    std::shared_ptr<HTTPChunkedReply> reply = chunkedReply;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [r, nStatus, reply]() {
+        evhttp_connection* conn = evhttp_request_get_connection(r);
+        if (!conn) {
+            reply->Close();
+            return;
+        }
+        evhttp_connection_set_closecb(conn, http_chunked_close_cb, reply.get());
+        evhttp_send_reply_start(r, nStatus, NULL);
+    });
+    ev->trigger(0);
+}
+
+bool HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(!replySent && chunkedReply && req);
+    if (strChunk.empty())
+        return !chunkedReply->fClosed;
+    {
+        // Don't get further ahead of a slow client than the buffer allows, the
+        // data would pile up in memory. Shutdown stops the event loop, after
+        // which the buffer never drains.
+        std::unique_lock<std::mutex> lock(chunkedReply->cs);
+        while (!chunkedReply->fClosed && chunkedReply->nBuffered >= MAX_CHUNKED_REPLY_BUFFER) {
+            if (fHTTPInterrupted)
+                return false;
+            chunkedReply->cond.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        if (chunkedReply->fClosed)
+            return false;
+        chunkedReply->nBuffered += strChunk.size();
+    }
+    struct evhttp_request* r = req;
+    std::shared_ptr<HTTPChunkedReply> reply = chunkedReply;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [r, reply, strChunk]() {
+        if (reply->fClosed)
+            return;
+        struct evbuffer* evb = evbuffer_new();
+        assert(evb);
+        evbuffer_add(evb, strChunk.data(), strChunk.size());
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+        evhttp_send_reply_chunk_with_cb(r, evb, http_chunked_drained_cb, reply.get());
+#else
+        // no notification when the buffer drains, don't hold the worker back
+        evhttp_send_reply_chunk(r, evb);
+        reply->Drained();
+#endif
+        evbuffer_free(evb);
+    });
+    ev->trigger(0);
+    return true;
+}
+
+void HTTPRequest::WriteReplyEnd()
+{
+    assert(!replySent && chunkedReply && req);
+    struct evhttp_request* r = req;
+    std::shared_ptr<HTTPChunkedReply> reply = chunkedReply;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [r, reply]() {
+        // Once the connection is gone evhttp has already released the request
+        if (reply->fClosed)
+            return;
+        evhttp_connection* conn = evhttp_request_get_connection(r);
+        if (conn)
+            evhttp_connection_set_closecb(conn, NULL, NULL);
+        evhttp_send_reply_end(r);
+    });
+    ev->trigger(0);
+    replySent = true;
+    req = 0; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -8,6 +8,8 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -17,6 +19,7 @@ struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPChunkedReply;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -55,6 +58,7 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    std::shared_ptr<HTTPChunkedReply> chunkedReply;
 
 public:
     HTTPRequest(struct evhttp_request* req);
@@ -110,6 +114,41 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Write HTTP reply from a shared buffer without copying it, the buffer is
+     * kept alive until libevent is done sending it.
+     * @note Like the above, do not call any other HTTPRequest methods after calling this.
+     */
+    void WriteReply(int nStatus, std::shared_ptr<const std::vector<unsigned char>> reply);
+
+    /**
+     * Start a chunked HTTP reply (Transfer-Encoding: chunked).
+     * nStatus is the HTTP status code to send. The body is then sent piecewise
+     * with WriteReplyChunk and finished with WriteReplyEnd.
+     *
+     * @note Use this instead of WriteReply for large bodies that are produced
+     * incrementally, so that they don't have to be kept in memory as a whole.
+     */
+    void WriteReplyStart(int nStatus);
+
+    /**
+     * Queue a chunk of the reply body for sending.
+     * Blocks while the client is more than a few MB behind, so the reply
+     * never piles up in memory.
+     * Returns false if the client has gone away or the server is shutting
+     * down, in which case the caller should stop producing data and call
+     * WriteReplyEnd.
+     */
+    bool WriteReplyChunk(const std::string& strChunk);
+
+    /**
+     * Finish a chunked reply started by WriteReplyStart.
+     *
+     * @note Like WriteReply, this gives the request back to the main thread,
+     * do not call any other HTTPRequest methods after calling this.
+     */
+    void WriteReplyEnd();
 };
 
 /** Event handler closure.
@@ -0,0 +1,307 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "indexbuilder.h"
+
+#include "chainparams.h"
+#include "coins.h"
+#include "lelantus.h"
+#include "sigma.h"
+#include "spark/state.h"
+#include "undo.h"
+#include "util.h"
+#include "validation.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+#include <boost/thread.hpp>
+
+namespace {
+
+struct AddressIndexCompare
+{
+    bool operator()(const std::pair<CAddressIndexKey, CAmount>& a, const std::pair<CAddressIndexKey, CAmount>& b) const {
+        return std::tie(a.first.type, a.first.hashBytes, a.first.blockHeight, a.first.txindex, a.first.txhash, a.first.index, a.first.spending) <
+               std::tie(b.first.type, b.first.hashBytes, b.first.blockHeight, b.first.txindex, b.first.txhash, b.first.index, b.first.spending);
+    }
+};
+
+struct AddressUnspentKeyCompare
+{
+    bool operator()(const CAddressUnspentKey& a, const CAddressUnspentKey& b) const {
+        return std::tie(a.type, a.hashBytes, a.txhash, a.index) < std::tie(b.type, b.hashBytes, b.txhash, b.index);
+    }
+};
+
+// What ConnectBlock adds to the total supply: the outputs of the coinbase that aren't fees
+bool GetSupplyChange(const CBlock& block, const CCoinsViewCache& view, CAmount& nSupplyChange)
+{
+    CAmount nFees = 0;
+    for (const CTransactionRef& ptx : block.vtx) {
+        const CTransaction& tx = *ptx;
+        try {
+            if (tx.IsSigmaSpend())
+                nFees += sigma::GetSigmaSpendInput(tx) - tx.GetValueOut();
+            if (tx.IsLelantusJoinSplit())
+                nFees += lelantus::ParseLelantusJoinSplit(tx)->getFee();
+            if (tx.IsSparkSpend())
+                nFees += spark::ParseSparkSpend(tx).getFee();
+        } catch (const std::exception& e) {
+            return error("%s: failed to get the fee of %s: %s", __func__, tx.GetHash().ToString(), e.what());
+        }
+        if (!tx.IsCoinBase() && !tx.HasNoRegularInputs())
+            nFees += view.GetValueIn(tx) - tx.GetValueOut();
+    }
+    nSupplyChange = block.vtx[0]->GetValueOut() - nFees;
+    return true;
+}
+
+}
+
+CIndexBuilder::BlockPos::BlockPos(const CBlockIndex* pindexIn)
+    : pindex(pindexIn),
+      hash(pindexIn->GetBlockHash()),
+      hashPrev(pindexIn->pprev->GetBlockHash()),
+      nHeight(pindexIn->nHeight),
+      nTime(pindexIn->nTime),
+      blockPos(pindexIn->GetBlockPos()),
+      undoPos(pindexIn->GetUndoPos()) {
+}
+
+CIndexBuilder::CIndexBuilder(bool fAddressIndexIn, bool fSpentIndexIn, bool fTimestampIndexIn, int nThreads)
+    : pindexBest(nullptr),
+      threadPool(std::max(nThreads, 1)) {
+    progress.fAddressIndex = fAddressIndexIn;
+    progress.fSpentIndex = fSpentIndexIn;
+    progress.fTimestampIndex = fTimestampIndexIn;
+}
+
+bool CIndexBuilder::ReadBlockEntries(const BlockPos& pos, bool fConnect, BlockEntries& entries) const {
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pos.blockPos, pos.nHeight, Params().GetConsensus()))
+        return error("%s: failed to read block %s", __func__, pos.hash.ToString());
+    CBlockUndo blockUndo;
+    if (!UndoReadFromDisk(blockUndo, pos.undoPos, pos.hashPrev))
+        return error("%s: failed to read undo data of block %s", __func__, pos.hash.ToString());
+    if (blockUndo.vtxundo.size() + 1 != block.vtx.size())
+        return error("%s: block %s and undo data inconsistent", __func__, pos.hash.ToString());
+
+    // the outputs the block spends, as they were before it was connected
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        if (tx.HasNoRegularInputs())
+            continue;
+        const CTxUndo& txundo = blockUndo.vtxundo[i - 1];
+        if (txundo.vprevout.size() != tx.vin.size())
+            return error("%s: transaction %s and undo data inconsistent", __func__, tx.GetHash().ToString());
+        for (size_t j = 0; j < tx.vin.size(); j++)
+            view.AddCoin(tx.vin[j].prevout, Coin(txundo.vprevout[j]), true);
+    }
+
+    CDbIndexHelper dbIndexHelper(progress.fAddressIndex, progress.fSpentIndex, progress.fAddressIndex);
+    if (fConnect) {
+        for (size_t i = 0; i < block.vtx.size(); i++)
+            dbIndexHelper.ConnectTransaction(*block.vtx[i], pos.nHeight, i, view);
+    } else {
+        // in the order of DisconnectBlock
+        for (int i = block.vtx.size() - 1; i >= 0; i--) {
+            dbIndexHelper.DisconnectTransactionOutputs(*block.vtx[i], pos.nHeight, i, view);
+            dbIndexHelper.DisconnectTransactionInputs(*block.vtx[i], pos.nHeight, i, view);
+        }
+    }
+
+    if (progress.fAddressIndex) {
+        entries.addressIndex = dbIndexHelper.getAddressIndex();
+        entries.addressUnspentIndex = dbIndexHelper.getAddressUnspentIndex();
+        entries.addressBalances = dbIndexHelper.getAddressBalances();
+        if (!GetSupplyChange(block, view, entries.nSupplyChange))
+            return false;
+    }
+    if (progress.fSpentIndex)
+        entries.spentIndex = dbIndexHelper.getSpentIndex();
+    return true;
+}
+
+bool CIndexBuilder::IndexBlocks(const std::vector<BlockPos>& blocks) {
+    std::vector<BlockEntries> entries(blocks.size());
+    size_t nChunkSize = (blocks.size() + threadPool.GetNumberOfThreads() - 1) / threadPool.GetNumberOfThreads();
+    std::vector<boost::future<bool>> tasks;
+    for (size_t begin = 0; begin < blocks.size(); begin += nChunkSize) {
+        size_t end = std::min(begin + nChunkSize, blocks.size());
+        tasks.push_back(threadPool.PostTask([this, &blocks, &entries, begin, end]() {
+            for (size_t i = begin; i < end; i++) {
+                if (!ReadBlockEntries(blocks[i], true, entries[i]))
+                    return false;
+            }
+            return true;
+        }));
+    }
+    bool fOk = true;
+    for (boost::future<bool>& task : tasks)
+        fOk &= task.get();
+    if (!fOk)
+        return false;
+
+    // One sorted run of every index. Unspent entries are replayed in block order, an output created and spent
+    // in the run is only erased.
+    CDbIndexHelper::AddressIndex addressIndex;
+    std::map<CAddressUnspentKey, CAddressUnspentValue, AddressUnspentKeyCompare> mapUnspent;
+    CDbIndexHelper::SpentIndex spentIndex;
+    CDbIndexHelper::AddressBalances addressBalances;
+    CAmount nSupplyChange = 0;
+    for (BlockEntries& block : entries) {
+        addressIndex.insert(addressIndex.end(), block.addressIndex.begin(), block.addressIndex.end());
+        for (const auto& unspent : block.addressUnspentIndex)
+            mapUnspent[unspent.first] = unspent.second;
+        spentIndex.insert(spentIndex.end(), block.spentIndex.begin(), block.spentIndex.end());
+        for (const auto& balance : block.addressBalances)
+            addressBalances[balance.first] += balance.second;
+        nSupplyChange += block.nSupplyChange;
+        block = BlockEntries();
+    }
+    std::sort(addressIndex.begin(), addressIndex.end(), AddressIndexCompare());
+    std::sort(spentIndex.begin(), spentIndex.end(),
+        [](const std::pair<CSpentIndexKey, CSpentIndexValue>& a, const std::pair<CSpentIndexKey, CSpentIndexValue>& b) {
+            return CSpentIndexKeyCompare()(a.first, b.first);
+        });
+
+    if (progress.fAddressIndex) {
+        if (!pblocktree->WriteAddressIndex(addressIndex))
+            return error("%s: failed to write address index", __func__);
+        CDbIndexHelper::AddressUnspentIndex addressUnspentIndex(mapUnspent.begin(), mapUnspent.end());
+        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex))
+            return error("%s: failed to write address unspent index", __func__);
+    }
+    if (progress.fSpentIndex && !pblocktree->UpdateSpentIndex(spentIndex))
+        return error("%s: failed to write spent index", __func__);
+    if (progress.fTimestampIndex) {
+        for (const BlockPos& pos : blocks) {
+            if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pos.nTime, pos.hash)))
+                return error("%s: failed to write timestamp index", __func__);
+        }
+    }
+
+    progress.hashBest = blocks.back().hash;
+    if (!pblocktree->WriteIndexBuilderProgress(progress, addressBalances, nSupplyChange))
+        return error("%s: failed to write progress", __func__);
+    pindexBest = blocks.back().pindex;
+    return true;
+}
+
+bool CIndexBuilder::Rewind(const CBlockIndex* pindexFork) {
+    AssertLockHeld(cs_main);
+    LogPrintf("%s: rewinding the index builder from %s to %s\n", __func__,
+              pindexBest->GetBlockHash().ToString(), pindexFork->GetBlockHash().ToString());
+
+    // like DisconnectBlock, the address entries are erased and the totals taken back
+    while (pindexBest != pindexFork) {
+        BlockEntries entries;
+        if (!ReadBlockEntries(BlockPos(pindexBest), false, entries))
+            return false;
+        if (progress.fAddressIndex) {
+            if (!pblocktree->EraseAddressIndex(entries.addressIndex))
+                return error("%s: failed to delete address index", __func__);
+            if (!pblocktree->UpdateAddressUnspentIndex(entries.addressUnspentIndex))
+                return error("%s: failed to write address unspent index", __func__);
+        }
+        pindexBest = pindexBest->pprev;
+        progress.hashBest = pindexBest->GetBlockHash();
+        if (!pblocktree->WriteIndexBuilderProgress(progress, entries.addressBalances, -entries.nSupplyChange))
+            return error("%s: failed to write progress", __func__);
+    }
+    return true;
+}
+
+bool CIndexBuilder::Finish() {
+    AssertLockHeld(cs_main);
+    if (progress.fAddressIndex) {
+        if (!pblocktree->WriteFlag("addressindex", true) || !pblocktree->WriteFlag("addressbalanceindex", true))
+            return error("%s: failed to write flags", __func__);
+        fAddressIndex = fAddressBalanceIndex = true;
+    }
+    if (progress.fSpentIndex) {
+        if (!pblocktree->WriteFlag("spentindex", true))
+            return error("%s: failed to write flags", __func__);
+        fSpentIndex = true;
+    }
+    if (progress.fTimestampIndex) {
+        if (!pblocktree->WriteFlag("timestampindex", true))
+            return error("%s: failed to write flags", __func__);
+        fTimestampIndex = true;
+    }
+    pblocktree->EraseIndexBuilderProgress();
+    LogPrintf("%s: indexes built up to block %s at height %d\n", __func__, pindexBest->GetBlockHash().ToString(), pindexBest->nHeight);
+    return true;
+}
+
+bool CIndexBuilder::Run() {
+    {
+        LOCK(cs_main);
+        CIndexBuilderProgress stored;
+        if (pblocktree->ReadIndexBuilderProgress(stored) && stored.fAddressIndex == progress.fAddressIndex &&
+                stored.fSpentIndex == progress.fSpentIndex && stored.fTimestampIndex == progress.fTimestampIndex) {
+            BlockMap::const_iterator it = mapBlockIndex.find(stored.hashBest);
+            if (it != mapBlockIndex.end()) {
+                pindexBest = it->second;
+                LogPrintf("%s: resuming at height %d\n", __func__, pindexBest->nHeight);
+            }
+        }
+        if (!pindexBest) {
+            // ConnectBlock doesn't index the genesis block
+            pindexBest = chainActive.Genesis();
+            progress.hashBest = pindexBest->GetBlockHash();
+            if (!pblocktree->ResetIndexBuilder(progress))
+                return error("%s: failed to reset the index builder", __func__);
+        }
+    }
+
+    while (true) {
+        boost::this_thread::interruption_point();
+
+        std::vector<BlockPos> blocks;
+        {
+            LOCK(cs_main);
+            if (!chainActive.Contains(pindexBest) && !Rewind(chainActive.FindFork(pindexBest)))
+                return false;
+            if (pindexBest == chainActive.Tip())
+                return Finish();
+
+            for (int nHeight = pindexBest->nHeight + 1; nHeight <= chainActive.Height() && blocks.size() < INDEX_BUILDER_RUN_BLOCKS; nHeight++) {
+                const CBlockIndex* pindex = chainActive[nHeight];
+                if (!(pindex->nStatus & BLOCK_HAVE_DATA) || !(pindex->nStatus & BLOCK_HAVE_UNDO))
+                    return error("%s: block %s isn't available", __func__, pindex->GetBlockHash().ToString());
+                blocks.push_back(BlockPos(pindex));
+            }
+        }
+
+        if (!IndexBlocks(blocks))
+            return false;
+        LogPrint("indexbuilder", "%s: indexed up to height %d\n", __func__, pindexBest->nHeight);
+    }
+}
+
+void StartIndexBuilder(boost::thread_group& threadGroup) {
+    bool fBuildAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) && !fAddressIndex;
+    bool fBuildSpentIndex = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) && !fSpentIndex;
+    bool fBuildTimestampIndex = GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX) && !fTimestampIndex;
+    if (!fBuildAddressIndex && !fBuildSpentIndex && !fBuildTimestampIndex)
+        return;
+    if (fPruneMode || fHavePruned) {
+        LogPrintf("%s: blocks are pruned, the indexes can only be built with -reindex\n", __func__);
+        return;
+    }
+
+    LogPrintf("%s: building%s%s%s in the background\n", __func__, fBuildAddressIndex ? " -addressindex" : "",
+              fBuildSpentIndex ? " -spentindex" : "", fBuildTimestampIndex ? " -timestampindex" : "");
+    std::function<void()> buildIndexes = [=]() {
+        CIndexBuilder builder(fBuildAddressIndex, fBuildSpentIndex, fBuildTimestampIndex, GetNumCores());
+        if (!builder.Run())
+            LogPrintf("StartIndexBuilder: building the indexes failed, they stay disabled\n");
+    };
+    threadGroup.create_thread(boost::bind(&TraceThread<std::function<void()> >, "indexbuild", buildIndexes));
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef FIRO_INDEXBUILDER_H
+#define FIRO_INDEXBUILDER_H
+
+#include "chain.h"
+#include "liblelantus/threadpool.h"
+#include "txdb.h"
+
+#include <vector>
+
+namespace boost {
+class thread_group;
+}
+
+// Number of blocks the index builder reads at once, their entries are sorted and written together
+static const size_t INDEX_BUILDER_RUN_BLOCKS = 1000;
+
+/**
+ * Builds the address, spent and timestamp indexes of the active chain in the background.
+ *
+ * ConnectBlock keeps these indexes once they are enabled, enabling one on a node that already has the chain
+ * used to need a -reindex that connects every block again. The builder only reads blocks and their undo data,
+ * which has all the spent outputs the entries need. Runs of blocks are read and indexed on several threads,
+ * the entries of a run are sorted and written in large batches. When the builder caught up with the tip it
+ * enables the indexes under cs_main, ConnectBlock keeps them from the next block on. Blocks that were
+ * disconnected while it ran are rewound like DisconnectBlock does. Its progress is kept in the block index
+ * database and it resumes after a restart.
+ */
+class CIndexBuilder
+{
+public:
+    CIndexBuilder(bool fAddressIndexIn, bool fSpentIndexIn, bool fTimestampIndexIn, int nThreads);
+
+    // Indexes the active chain and enables the indexes. Returns false on errors, interruptions are thrown.
+    bool Run();
+
+private:
+    // where to find a block, so that it can be read without cs_main
+    struct BlockPos {
+        explicit BlockPos(const CBlockIndex* pindexIn);
+
+        const CBlockIndex* pindex;
+        uint256 hash;
+        uint256 hashPrev;
+        int nHeight;
+        unsigned int nTime;
+        CDiskBlockPos blockPos;
+        CDiskBlockPos undoPos;
+    };
+
+    struct BlockEntries {
+        CDbIndexHelper::AddressIndex addressIndex;
+        CDbIndexHelper::AddressUnspentIndex addressUnspentIndex;
+        CDbIndexHelper::SpentIndex spentIndex;
+        CDbIndexHelper::AddressBalances addressBalances;
+        CAmount nSupplyChange = 0;
+    };
+
+    // The entries ConnectBlock would write for the block, or DisconnectBlock would erase
+    bool ReadBlockEntries(const BlockPos& pos, bool fConnect, BlockEntries& entries) const;
+    bool IndexBlocks(const std::vector<BlockPos>& blocks);
+    // The following need cs_main
+    bool Rewind(const CBlockIndex* pindexFork);
+    bool Finish();
+
+    CIndexBuilderProgress progress;
+    const CBlockIndex* pindexBest;
+    ParallelOpThreadPool<bool> threadPool;
+};
+
+// Starts building the indexes that are enabled by the arguments but missing from the block index database
+void StartIndexBuilder(boost::thread_group& threadGroup);
+
+#endif // FIRO_INDEXBUILDER_H
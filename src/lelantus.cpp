@@ -1097,6 +1097,17 @@ bool GetOutPointFromMintTag(COutPoint& outPoint, const uint256 &pubCoinTag) {
 }
 
 bool BuildLelantusStateFromIndex(CChain *chain) {
+    // Counted first, the maps would rehash every coin again each time they grow. Rehashing a coin means
+    // serializing and hashing it.
+    size_t nMints = 0, nSpends = 0;
+    for (CBlockIndex *blockIndex = chain->Genesis(); blockIndex; blockIndex=chain->Next(blockIndex))
+    {
+        for (auto const &pubCoins : blockIndex->lelantusMintedPubCoins)
+            nMints += pubCoins.second.size();
+        nSpends += blockIndex->lelantusSpentSerials.size();
+    }
+    lelantusState.Reserve(nMints, nSpends);
+
     for (CBlockIndex *blockIndex = chain->Genesis(); blockIndex; blockIndex=chain->Next(blockIndex))
     {
         lelantusState.AddBlock(blockIndex);
@@ -1156,17 +1167,17 @@ void CLelantusState::Containers::RemoveMint(lelantus::PublicCoin const & pubCoin
 
 void CLelantusState::Containers::AddSpend(Scalar const & serial, int coinGroupId) {
     if (mintMetaInfo.count(coinGroupId) > 0) {
-        usedCoinSerials[serial] = coinGroupId;
+        usedCoinSerials.insert(serial, coinGroupId);
         spendMetaInfo[coinGroupId] += 1;
         CheckSurgeCondition();
     }
 }
 
 void CLelantusState::Containers::RemoveSpend(Scalar const & serial) {
-    auto iter = usedCoinSerials.find(serial);
-    if (iter != usedCoinSerials.end()) {
-        spendMetaInfo[iter->second] -= 1;
-        usedCoinSerials.erase(iter);
+    int coinGroupId;
+    if (usedCoinSerials.Find(serial, coinGroupId)) {
+        spendMetaInfo[coinGroupId] -= 1;
+        usedCoinSerials.erase(serial);
         CheckSurgeCondition();
     }
 }
@@ -1189,7 +1200,7 @@ std::unordered_map<uint256, lelantus::PublicCoin>&  CLelantusState::Containers::
     return tagToPublicCoin;
 }
 
-std::unordered_map<Scalar, int> const & CLelantusState::Containers::GetSpends() const {
+UsedSerialSet const & CLelantusState::Containers::GetSpends() const {
     return usedCoinSerials;
 }
 
@@ -1197,6 +1208,12 @@ bool CLelantusState::Containers::IsSurgeCondition() const {
     return surgeCondition;
 }
 
+void CLelantusState::Containers::Reserve(size_t nMints, size_t nSpends) {
+    mintedPubCoins.reserve(mintedPubCoins.size() + nMints);
+    tagToPublicCoin.reserve(tagToPublicCoin.size() + nMints);
+    usedCoinSerials.reserve(usedCoinSerials.size() + nSpends);
+}
+
 void CLelantusState::Containers::Reset() {
     mintedPubCoins.clear();
     usedCoinSerials.clear();
@@ -1364,6 +1381,10 @@ void CLelantusState::AddBlock(CBlockIndex *index) {
     }
 }
 
+void CLelantusState::Reserve(size_t nMints, size_t nSpends) {
+    containers.Reserve(nMints, nSpends);
+}
+
 void CLelantusState::RemoveBlock(CBlockIndex *index) {
     // roll back coin group updates
     for (auto &coins : index->lelantusMintedPubCoins)
@@ -1450,13 +1471,7 @@ bool CLelantusState::IsUsedCoinSerial(const Scalar &coinSerial) {
 }
 
 bool CLelantusState::IsUsedCoinSerialHash(Scalar &coinSerial, const uint256 &coinSerialHash) {
-    for ( auto it = GetSpends().begin(); it != GetSpends().end(); ++it ){
-        if(primitives::GetSerialHash(it->first)==coinSerialHash){
-            coinSerial = it->first;
-            return true;
-        }
-    }
-    return false;
+    return containers.GetSpends().FindHash(coinSerial, coinSerialHash);
 }
 
 bool CLelantusState::HasCoin(const lelantus::PublicCoin& pubCoin) {
@@ -1750,7 +1765,7 @@ mint_info_container const & CLelantusState::GetMints() const {
     return containers.GetMints();
 }
 
-std::unordered_map<Scalar, int> const & CLelantusState::GetSpends() const {
+UsedSerialSet const & CLelantusState::GetSpends() const {
     return containers.GetSpends();
 }
 
@@ -13,11 +13,15 @@
 #include <unordered_map>
 #include <functional>
 #include "coin_containers.h"
+#include "flattagset.h"
+#include "primitives/mint_spend.h"
 
 namespace lelantus_mintspend { class lelantus_mintspend_test; }
 
 namespace lelantus {
 
+typedef CFlatTagSet<Scalar, primitives::GetSerialHash> UsedSerialSet;
+
 // Lelantus transaction info, added to the CBlock to ensure zerocoin mint/spend transactions got their info stored into index
 class CLelantusTxInfo {
 public:
@@ -169,6 +173,9 @@ public:
     // Disconnect block from the chain rolling back mints and spends
     void RemoveBlock(CBlockIndex *index);
 
+    // Makes room for this many more mints and spends, before many blocks are added
+    void Reserve(size_t nMints, size_t nSpends);
+
     // Query coin group with given id
     bool GetCoinGroupInfo(int group_id, LelantusCoinGroupInfo &result);
 
@@ -240,7 +247,7 @@ public:
     int GetLatestCoinID() const;
 
     mint_info_container const & GetMints() const;
-    std::unordered_map<Scalar, int> const & GetSpends() const;
+    UsedSerialSet const & GetSpends() const;
     std::unordered_map<int, LelantusCoinGroupInfo> const & GetCoinGroups() const ;
     std::unordered_map<Scalar, uint256, sigma::CScalarHash> const & GetMempoolCoinSerials() const;
 
@@ -276,10 +283,11 @@ private:
         void AddExtendedMints(int group, size_t mints);
         void RemoveExtendedMints(int group);
 
+        void Reserve(size_t nMints, size_t nSpends);
         void Reset();
 
         mint_info_container const & GetMints() const;
-        std::unordered_map<Scalar, int> const & GetSpends() const;
+        UsedSerialSet const & GetSpends() const;
         std::unordered_map<uint256, lelantus::PublicCoin>& GetTagToPublicCoin();
         bool IsSurgeCondition() const;
     private:
@@ -287,7 +295,7 @@ private:
         // Used for checking if the given coin already exists.
         mint_info_container mintedPubCoins;
         // Set of all used coin serials.
-        std::unordered_map<Scalar, int> usedCoinSerials;
+        UsedSerialSet usedCoinSerials;
 
         //this map keeps hash(G^s*H0^r|seedId) to G^s*H0^r*H1^v
         std::unordered_map<uint256, lelantus::PublicCoin> tagToPublicCoin;
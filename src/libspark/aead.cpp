@@ -2,10 +2,35 @@
 
 namespace spark {
 
+// OpenSSL cipher context that is set up once per thread and only rekeyed per operation
+class AEADContext {
+public:
+	AEADContext(bool encrypt) {
+		this->ctx = EVP_CIPHER_CTX_new();
+		if (encrypt) {
+			EVP_EncryptInit_ex(this->ctx, EVP_chacha20_poly1305(), NULL, NULL, NULL);
+		} else {
+			EVP_DecryptInit_ex(this->ctx, EVP_chacha20_poly1305(), NULL, NULL, NULL);
+		}
+	}
+
+	~AEADContext() {
+		EVP_CIPHER_CTX_free(this->ctx);
+	}
+
+	AEADContext(const AEADContext&) = delete;
+	AEADContext& operator=(const AEADContext&) = delete;
+
+	EVP_CIPHER_CTX* ctx;
+};
+
+// For our application, we can safely use a zero nonce since keys are never reused
+static const unsigned char ZERO_IV[AEAD_IV_SIZE] = {};
+
 // Perform authenticated encryption with ChaCha20-Poly1305 using key commitment
 // NOTE: This uses a fixed zero nonce, which is safe when used in Spark as directed
 // It is NOT safe in general to do this!
-AEADEncryptedData AEAD::encrypt(const GroupElement& prekey, const std::string additional_data, CDataStream& data) {
+AEADEncryptedData AEAD::encrypt(const GroupElement& prekey, const std::string& additional_data, CDataStream& data) {
 	// Set up the result structure
 	AEADEncryptedData result;
 
@@ -16,18 +41,13 @@ AEADEncryptedData AEAD::encrypt(const GroupElement& prekey, const std::string ad
 	// Internal size tracker; we know the size of the data already, and can ignore
 	int TEMP;
 
-	// For our application, we can safely use a zero nonce since keys are never reused
-	std::vector<unsigned char> iv;
-	iv.resize(AEAD_IV_SIZE);
-
 	// Set up the cipher
-	EVP_CIPHER_CTX* ctx;
-	ctx = EVP_CIPHER_CTX_new();
-	EVP_EncryptInit_ex(ctx, EVP_chacha20_poly1305(), NULL, key.data(), iv.data());
+	static thread_local AEADContext context(true);
+	EVP_CIPHER_CTX* ctx = context.ctx;
+	EVP_EncryptInit_ex(ctx, NULL, NULL, key.data(), ZERO_IV);
 
 	// Include the associated data
-	std::vector<unsigned char> additional_data_bytes(additional_data.begin(), additional_data.end());
-	EVP_EncryptUpdate(ctx, NULL, &TEMP, additional_data_bytes.data(), additional_data_bytes.size());
+	EVP_EncryptUpdate(ctx, NULL, &TEMP, reinterpret_cast<const unsigned char *>(additional_data.data()), additional_data.size());
 
 	// Encrypt the plaintext
 	result.ciphertext.resize(data.size());
@@ -38,17 +58,14 @@ AEADEncryptedData AEAD::encrypt(const GroupElement& prekey, const std::string ad
 	result.tag.resize(AEAD_TAG_SIZE);
 	EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, AEAD_TAG_SIZE, result.tag.data());
 
-	// Clean up
-	EVP_CIPHER_CTX_free(ctx);
-
 	return result;
 }
 
-// Perform authenticated decryption with ChaCha20-Poly1305 using key commitment
+// Perform authenticated decryption with ChaCha20-Poly1305 using key commitment into a caller-provided stream
 // NOTE: This uses a fixed zero nonce, which is safe when used in Spark as directed
 // It is NOT safe in general to do this!
-CDataStream AEAD::decrypt_and_verify(const GroupElement& prekey, const std::string additional_data, AEADEncryptedData& data) {
-	// Assert that the key commitment is valid
+void AEAD::decrypt_and_verify(const GroupElement& prekey, const std::string& additional_data, const AEADEncryptedData& data, CDataStream& result) {
+	// Assert that the key commitment is valid, this rejects coins that are not ours before any decryption
 	std::vector<unsigned char> key_commitment = SparkUtils::commit_aead(prekey);
 	if (key_commitment != data.key_commitment) {
 		throw std::runtime_error("Bad AEAD key commitment");
@@ -57,39 +74,35 @@ CDataStream AEAD::decrypt_and_verify(const GroupElement& prekey, const std::stri
 	// Derive the key
 	std::vector<unsigned char> key = SparkUtils::kdf_aead(prekey);
 
-	// Set up the result
-	CDataStream result(SER_NETWORK, PROTOCOL_VERSION);
-
 	// Internal size tracker; we know the size of the data already, and can ignore
 	int TEMP;
 
-	// For our application, we can safely use a zero nonce since keys are never reused
-	std::vector<unsigned char> iv;
-	iv.resize(AEAD_IV_SIZE);
-
 	// Set up the cipher
-	EVP_CIPHER_CTX* ctx;
-	ctx = EVP_CIPHER_CTX_new();
-	EVP_DecryptInit_ex(ctx, EVP_chacha20_poly1305(), NULL, key.data(), iv.data());
+	static thread_local AEADContext context(false);
+	EVP_CIPHER_CTX* ctx = context.ctx;
+	EVP_DecryptInit_ex(ctx, NULL, NULL, key.data(), ZERO_IV);
 
 	// Include the associated data
-	std::vector<unsigned char> additional_data_bytes(additional_data.begin(), additional_data.end());
-	EVP_DecryptUpdate(ctx, NULL, &TEMP, additional_data_bytes.data(), additional_data_bytes.size());
+	EVP_DecryptUpdate(ctx, NULL, &TEMP, reinterpret_cast<const unsigned char *>(additional_data.data()), additional_data.size());
 
 	// Decrypt the ciphertext
+	result.clear();
 	result.resize(data.ciphertext.size());
 	EVP_DecryptUpdate(ctx, reinterpret_cast<unsigned char *>(result.data()), &TEMP, data.ciphertext.data(), data.ciphertext.size());
-	
+
 	// Set the expected tag
-	EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, AEAD_TAG_SIZE, data.tag.data());
+	EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, AEAD_TAG_SIZE, const_cast<unsigned char *>(data.tag.data()));
 
-	// Decrypt and clean up
-	int ret = EVP_DecryptFinal_ex(ctx, NULL, &TEMP);
-	EVP_CIPHER_CTX_free(ctx);
-	if (ret != 1) {
+	// Decrypt
+	if (EVP_DecryptFinal_ex(ctx, NULL, &TEMP) != 1) {
+		result.clear();
 		throw std::runtime_error("Bad AEAD authentication");
 	}
+}
 
+CDataStream AEAD::decrypt_and_verify(const GroupElement& prekey, const std::string& additional_data, AEADEncryptedData& data) {
+	CDataStream result(SER_NETWORK, PROTOCOL_VERSION);
+	decrypt_and_verify(prekey, additional_data, data, result);
 	return result;
 }
 
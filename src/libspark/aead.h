@@ -34,8 +34,10 @@ struct AEADEncryptedData {
 
 class AEAD {
 public:
-	static AEADEncryptedData encrypt(const GroupElement& prekey, const std::string additional_data, CDataStream& data);
-	static CDataStream decrypt_and_verify(const GroupElement& prekey, const std::string associated_data, AEADEncryptedData& data);
+	static AEADEncryptedData encrypt(const GroupElement& prekey, const std::string& additional_data, CDataStream& data);
+	// Decrypts into result, reusing its buffer
+	static void decrypt_and_verify(const GroupElement& prekey, const std::string& associated_data, const AEADEncryptedData& data, CDataStream& result);
+	static CDataStream decrypt_and_verify(const GroupElement& prekey, const std::string& associated_data, AEADEncryptedData& data);
 };
 
 }
@@ -128,7 +128,8 @@ IdentifiedCoinData Coin::identify(const IncomingViewKey& incoming_view_key) {
 
 		try {
 			// Decrypt recipient data
-			CDataStream stream = AEAD::decrypt_and_verify(this->K*incoming_view_key.get_s1(), "Mint coin data", this->r_);
+			CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+			AEAD::decrypt_and_verify(this->K*incoming_view_key.get_s1(), "Mint coin data", this->r_, stream);
 			stream >> r;
 		} catch (const std::exception &) {
 			throw std::runtime_error("Unable to identify coin");
@@ -149,7 +150,8 @@ IdentifiedCoinData Coin::identify(const IncomingViewKey& incoming_view_key) {
 
 		try {
 			// Decrypt recipient data
-			CDataStream stream = AEAD::decrypt_and_verify(this->K*incoming_view_key.get_s1(), "Spend coin data", this->r_);
+			CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+			AEAD::decrypt_and_verify(this->K*incoming_view_key.get_s1(), "Spend coin data", this->r_, stream);
 			stream >> r;
 		} catch (const std::exception &) {
 			throw std::runtime_error("Unable to identify coin");
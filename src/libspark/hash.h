@@ -1,6 +1,6 @@
 #ifndef FIRO_SPARK_HASH_H
 #define FIRO_SPARK_HASH_H
-#include <openssl/evp.h>
+#include "../crypto/sha512.h"
 #include "util.h"
 
 namespace spark {
@@ -9,8 +9,7 @@ using namespace secp_primitives;
 
 class Hash {
 public:
-	Hash(const std::string label);
-	~Hash();
+	Hash(const std::string& label);
 	void include(CDataStream& data);
 	std::vector<unsigned char> finalize();
 	Scalar finalize_scalar();
@@ -18,7 +17,7 @@ public:
 
 private:
 	void include_size(std::size_t size);
-	EVP_MD_CTX* ctx;
+	CSHA512 state;
 };
 
 }
@@ -1,20 +1,19 @@
 #ifndef FIRO_SPARK_KDF_H
 #define FIRO_SPARK_KDF_H
-#include <openssl/evp.h>
+#include "../crypto/sha512.h"
 #include "util.h"
 
 namespace spark {
 
 class KDF {
 public:
-	KDF(const std::string label, std::size_t derived_key_size);
-	~KDF();
+	KDF(const std::string& label, std::size_t derived_key_size);
 	void include(CDataStream& data);
 	std::vector<unsigned char> finalize();
 
 private:
 	void include_size(std::size_t size);
-	EVP_MD_CTX* ctx;
+	CSHA512 state;
 	std::size_t derived_key_size;
 };
 
@@ -169,6 +169,19 @@ BOOST_AUTO_TEST_CASE(converging)
     BOOST_CHECK_NE(transcript_1.challenge("x"), transcript_2.challenge("x"));
 }
 
+BOOST_AUTO_TEST_CASE(known_answer)
+{
+    // Challenges are consensus critical, pin them to fixed values
+    Transcript transcript("Spam");
+    transcript.add("Scalar", Scalar(uint64_t(12345)));
+    transcript.add("Group", GroupElement().set_base_g() * Scalar(uint64_t(67890)));
+    transcript.add("Scalars", std::vector<Scalar>{Scalar(uint64_t(1)), Scalar(uint64_t(2))});
+    transcript.add("Data", std::vector<unsigned char>{'E', 'g', 'g', 's'});
+
+    BOOST_CHECK_EQUAL(transcript.challenge("x").GetHex(), "290cacac560fd13ac8607441458d5d1ad7820b429b81564b59a0e76922c01bbd");
+    BOOST_CHECK_EQUAL(transcript.challenge("y").GetHex(), "9d5cba03276041823fd16354c7588d28ae28c75e29aa110564ad7ff4f3c51fe4");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
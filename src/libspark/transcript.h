@@ -1,31 +1,30 @@
 #ifndef FIRO_SPARK_TRANSCRIPT_H
 #define FIRO_SPARK_TRANSCRIPT_H
-#include <openssl/evp.h>
+#include "../crypto/sha512.h"
 #include "util.h"
 
 namespace spark {
 
 using namespace secp_primitives;
 
+// Fiat-Shamir transcript over SHA-512, the state is a plain CSHA512 so copying a transcript is a cheap value copy
 class Transcript {
 public:
-    Transcript(const std::string);
-    Transcript& operator=(const Transcript&);
-    ~Transcript();
-    void add(const std::string, const Scalar&);
-    void add(const std::string, const std::vector<Scalar>&);
-    void add(const std::string, const GroupElement&);
-    void add(const std::string, const std::vector<GroupElement>&);
-    void add(const std::string, const std::vector<unsigned char>&);
-    void add(const std::string label, const std::vector<std::vector<unsigned char>>& data);
-    Scalar challenge(const std::string);
+    Transcript(const std::string& domain);
+    void add(const std::string& label, const Scalar& scalar);
+    void add(const std::string& label, const std::vector<Scalar>& scalars);
+    void add(const std::string& label, const GroupElement& group_element);
+    void add(const std::string& label, const std::vector<GroupElement>& group_elements);
+    void add(const std::string& label, const std::vector<unsigned char>& data);
+    void add(const std::string& label, const std::vector<std::vector<unsigned char>>& data);
+    Scalar challenge(const std::string& label);
 
 private:
     void size(const std::size_t size_);
-    void include_flag(const unsigned char);
-    void include_label(const std::string);
-    void include_data(const std::vector<unsigned char>&);
-    EVP_MD_CTX* ctx;
+    void include_flag(const unsigned char flag);
+    void include_label(const std::string& label);
+    void include_data(const unsigned char* data, const std::size_t size_);
+    CSHA512 state;
 };
 
 }
@@ -1,4 +1,5 @@
 #include "util.h"
+#include <openssl/evp.h>
 
 namespace spark {
 
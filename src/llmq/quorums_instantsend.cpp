@@ -48,6 +48,14 @@ CTransaction AdaptPrivateTx(CTransaction const & tx);
 
 ////////////////
 
+CInstantSendDb::CInstantSendDb(CDBWrapper& _db, size_t nCacheSize) :
+    db(_db),
+    islockCache(nCacheSize),
+    txidCache(nCacheSize),
+    outpointCache(nCacheSize)
+{
+}
+
 void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock)
 {
     CDBBatch batch(db);
@@ -59,19 +67,19 @@ void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstant
     db.WriteBatch(batch);
 
     auto p = std::make_shared<CInstantSendLock>(islock);
-    islockCache.insert(hash, p);
-    txidCache.insert(islock.txid, hash);
+    islockCache.Insert(hash, p);
+    txidCache.Insert(islock.txid, hash);
     for (auto& in : islock.inputs) {
-        outpointCache.insert(in, hash);
+        outpointCache.Insert(in, hash);
     }
 }
 
-void CInstantSendDb::RemoveInstantSendLock(CDBBatch& batch, const uint256& hash, CInstantSendLockPtr islock)
+CInstantSendLockPtr CInstantSendDb::RemoveInstantSendLock(CDBBatch& batch, const uint256& hash, CInstantSendLockPtr islock)
 {
     if (!islock) {
         islock = GetInstantSendLockByHash(hash);
         if (!islock) {
-            return;
+            return nullptr;
         }
     }
 
@@ -80,11 +88,15 @@ void CInstantSendDb::RemoveInstantSendLock(CDBBatch& batch, const uint256& hash,
     for (auto& in : islock->inputs) {
         batch.Erase(std::make_tuple(std::string("is_in"), in));
     }
+    return islock;
+}
 
-    islockCache.erase(hash);
-    txidCache.erase(islock->txid);
-    for (auto& in : islock->inputs) {
-        outpointCache.erase(in);
+void CInstantSendDb::UncacheInstantSendLock(const uint256& hash, const CInstantSendLock& islock)
+{
+    islockCache.Erase(hash);
+    txidCache.Erase(islock.txid);
+    for (auto& in : islock.inputs) {
+        outpointCache.Erase(in);
     }
 }
 
@@ -145,6 +157,9 @@ std::unordered_map<uint256, CInstantSendLockPtr> CInstantSendDb::RemoveConfirmed
     }
 
     db.WriteBatch(batch);
+    for (auto& p : ret) {
+        UncacheInstantSendLock(p.first, *p.second);
+    }
 
     return ret;
 }
@@ -207,38 +222,24 @@ size_t CInstantSendDb::GetInstantSendLockCount()
 
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByHash(const uint256& hash)
 {
-    CInstantSendLockPtr ret;
-    if (islockCache.get(hash, ret)) {
+    return islockCache.Get(hash, [&]() {
+        auto ret = std::make_shared<CInstantSendLock>();
+        if (!db.Read(std::make_tuple(std::string("is_i"), hash), *ret)) {
+            ret = nullptr;
+        }
         return ret;
-    }
-
-    ret = std::make_shared<CInstantSendLock>();
-    bool exists = db.Read(std::make_tuple(std::string("is_i"), hash), *ret);
-    if (!exists) {
-        ret = nullptr;
-    }
-    islockCache.insert(hash, ret);
-    return ret;
+    });
 }
 
 uint256 CInstantSendDb::GetInstantSendLockHashByTxid(const uint256& txid)
 {
-    uint256 islockHash;
-
-    bool found = txidCache.get(txid, islockHash);
-    if (found && islockHash.IsNull()) {
-        return uint256();
-    }
-
-    if (!found) {
-        found = db.Read(std::make_tuple(std::string("is_tx"), txid), islockHash);
-        txidCache.insert(txid, islockHash);
-    }
-
-    if (!found) {
-        return uint256();
-    }
-    return islockHash;
+    return txidCache.Get(txid, [&]() {
+        uint256 islockHash;
+        if (!db.Read(std::make_tuple(std::string("is_tx"), txid), islockHash)) {
+            islockHash.SetNull();
+        }
+        return islockHash;
+    });
 }
 
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256& txid)
@@ -252,18 +253,14 @@ CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256& txid
 
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByInput(const COutPoint& outpoint)
 {
-    uint256 islockHash;
-    bool found = outpointCache.get(outpoint, islockHash);
-    if (found && islockHash.IsNull()) {
-        return nullptr;
-    }
-
-    if (!found) {
-        found = db.Read(std::make_tuple(std::string("is_in"), outpoint), islockHash);
-        outpointCache.insert(outpoint, islockHash);
-    }
-
-    if (!found) {
+    uint256 islockHash = outpointCache.Get(outpoint, [&]() {
+        uint256 hash;
+        if (!db.Read(std::make_tuple(std::string("is_in"), outpoint), hash)) {
+            hash.SetNull();
+        }
+        return hash;
+    });
+    if (islockHash.IsNull()) {
         return nullptr;
     }
     return GetInstantSendLockByHash(islockHash);
@@ -307,6 +304,7 @@ std::vector<uint256> CInstantSendDb::RemoveChainedInstantSendLocks(const uint256
     stack.emplace_back(txid);
 
     CDBBatch batch(db);
+    std::vector<std::pair<uint256, CInstantSendLockPtr>> removed;
     while (!stack.empty()) {
         auto children = GetInstantSendLocksByParent(stack.back());
         stack.pop_back();
@@ -319,6 +317,7 @@ std::vector<uint256> CInstantSendDb::RemoveChainedInstantSendLocks(const uint256
 
             RemoveInstantSendLock(batch, childIslockHash, childIsLock);
             WriteInstantSendLockArchived(batch, childIslockHash, nHeight);
+            removed.emplace_back(childIslockHash, childIsLock);
             result.emplace_back(childIslockHash);
 
             if (added.emplace(childIsLock->txid).second) {
@@ -327,11 +326,17 @@ std::vector<uint256> CInstantSendDb::RemoveChainedInstantSendLocks(const uint256
         }
     }
 
-    RemoveInstantSendLock(batch, islockHash, nullptr);
+    auto islock = RemoveInstantSendLock(batch, islockHash, nullptr);
+    if (islock) {
+        removed.emplace_back(islockHash, islock);
+    }
     WriteInstantSendLockArchived(batch, islockHash, nHeight);
     result.emplace_back(islockHash);
 
     db.WriteBatch(batch);
+    for (auto& p : removed) {
+        UncacheInstantSendLock(p.first, *p.second);
+    }
 
     return result;
 }
@@ -339,7 +344,7 @@ std::vector<uint256> CInstantSendDb::RemoveChainedInstantSendLocks(const uint256
 ////////////////
 
 CInstantSendManager::CInstantSendManager(CDBWrapper& _llmqDb) :
-    db(_llmqDb)
+    db(_llmqDb, (size_t)std::max<int64_t>(1, GetArg("-islockcachesize", DEFAULT_ISLOCK_CACHE_SIZE)))
 {
     workInterrupt.reset();
 }
@@ -819,7 +824,8 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
 {
     auto llmqType = Params().GetConsensus().llmqForInstantSend;
 
-    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true, 8);
+    // no sub-batching, invalid ISLOCKs are found by bisecting the batch, so large batches stay cheap
+    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true);
     std::unordered_map<uint256, std::pair<CQuorumCPtr, CRecoveredSig>> recSigs;
 
     for (const auto& p : pend) {
@@ -1467,8 +1473,12 @@ bool CInstantSendManager::AlreadyHave(const CInv& inv)
         return true;
     }
 
+    if (db.GetInstantSendLockByHash(inv.hash) != nullptr || db.HasArchivedInstantSendLock(inv.hash)) {
+        return true;
+    }
+
     LOCK(cs);
-    return db.GetInstantSendLockByHash(inv.hash) != nullptr || pendingInstantSendLocks.count(inv.hash) != 0 || db.HasArchivedInstantSendLock(inv.hash);
+    return pendingInstantSendLocks.count(inv.hash) != 0;
 }
 
 bool CInstantSendManager::GetInstantSendLockByHash(const uint256& hash, llmq::CInstantSendLock& ret)
@@ -1477,7 +1487,6 @@ bool CInstantSendManager::GetInstantSendLockByHash(const uint256& hash, llmq::CI
         return false;
     }
 
-    LOCK(cs);
     auto islock = db.GetInstantSendLockByHash(hash);
     if (!islock) {
         return false;
@@ -1492,7 +1501,6 @@ bool CInstantSendManager::IsLocked(const uint256& txHash)
         return false;
     }
 
-    LOCK(cs);
     return db.GetInstantSendLockByTxid(txHash) != nullptr;
 }
 
@@ -1509,7 +1517,6 @@ CInstantSendLockPtr CInstantSendManager::GetConflictingLock(const CTransaction&
 
     CTransaction const & tx{(tx_.IsLelantusJoinSplit() || tx_.IsSparkSpend()) ? isutils::AdaptPrivateTx(tx_) : tx_};
 
-    LOCK(cs);
     for (const auto& in : tx.vin) {
         auto otherIsLock = db.GetInstantSendLockByInput(in.prevout);
         if (!otherIsLock) {
@@ -1525,7 +1532,6 @@ CInstantSendLockPtr CInstantSendManager::GetConflictingLock(const CTransaction&
 
 size_t CInstantSendManager::GetInstantSendLockCount()
 {
-    LOCK(cs);
     return db.GetInstantSendLockCount();
 }
 
@@ -8,9 +8,13 @@
 #include "quorums_signing.h"
 
 #include "coins.h"
-#include "unordered_lru_cache.h"
 #include "primitives/transaction.h"
+#include "saltedhasher.h"
+#include "unordered_lru_cache.h"
 
+#include <array>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -40,20 +44,99 @@ public:
 
 typedef std::shared_ptr<CInstantSendLock> CInstantSendLockPtr;
 
+// Default number of entries kept by each of the islock caches, can be changed with -islockcachesize
+static const size_t DEFAULT_ISLOCK_CACHE_SIZE = 10000;
+
+/**
+ * LRU cache split into shards that each have their own lock, so that lookups only wait for concurrent accesses to the
+ * same shard. Misses are loaded with the shard locked, so a reader can't put back a value that a writer replaced
+ * after committing it to the DB. Each shard keeps up to twice its share of the capacity before truncating.
+ */
+template<typename Key, typename Value, typename Hasher>
+class CShardedLRUCache
+{
+private:
+    static const size_t SHARD_COUNT = 16;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unique_ptr<unordered_lru_cache<Key, Value, Hasher>> cache;
+    };
+
+    std::array<Shard, SHARD_COUNT> shards;
+    Hasher hasher;
+
+    Shard& GetShard(const Key& key) { return shards[hasher(key) % SHARD_COUNT]; }
+
+public:
+    explicit CShardedLRUCache(size_t nMaxSize)
+    {
+        size_t nShardSize = std::max<size_t>(1, nMaxSize / SHARD_COUNT);
+        for (auto& shard : shards) {
+            shard.cache.reset(new unordered_lru_cache<Key, Value, Hasher>(nShardSize));
+        }
+    }
+
+    // Returns the cached value for key, or the one load() returns, which is cached then
+    template<typename Loader>
+    Value Get(const Key& key, Loader load)
+    {
+        auto& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Value value;
+        if (!shard.cache->get(key, value)) {
+            value = load();
+            shard.cache->insert(key, value);
+        }
+        return value;
+    }
+
+    void Insert(const Key& key, const Value& value)
+    {
+        auto& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.cache->insert(key, value);
+    }
+
+    void Erase(const Key& key)
+    {
+        auto& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.cache->erase(key);
+    }
+
+    size_t Size()
+    {
+        size_t size = 0;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            size += shard.cache->size();
+        }
+        return size;
+    }
+};
+
 class CInstantSendDb
 {
 private:
     CDBWrapper& db;
 
-    unordered_lru_cache<uint256, CInstantSendLockPtr, StaticSaltedHasher, 10000> islockCache;
-    unordered_lru_cache<uint256, uint256, StaticSaltedHasher, 10000> txidCache;
-    unordered_lru_cache<COutPoint, uint256, SaltedOutpointHasher, 10000> outpointCache;
+    /**
+     * Caches of the "is_i", "is_tx" and "is_in" entries, absent entries are cached as null. They are only updated
+     * after the DB is, so lookups don't need CInstantSendManager::cs.
+     */
+    CShardedLRUCache<uint256, CInstantSendLockPtr, StaticSaltedHasher> islockCache;
+    CShardedLRUCache<uint256, uint256, StaticSaltedHasher> txidCache;
+    CShardedLRUCache<COutPoint, uint256, SaltedOutpointHasher> outpointCache;
+
+    // Returns the removed islock, its entries must be uncached once the batch is written
+    CInstantSendLockPtr RemoveInstantSendLock(CDBBatch& batch, const uint256& hash, CInstantSendLockPtr islock);
+    void UncacheInstantSendLock(const uint256& hash, const CInstantSendLock& islock);
 
 public:
-    CInstantSendDb(CDBWrapper& _db) : db(_db) {}
+    CInstantSendDb(CDBWrapper& _db, size_t nCacheSize = DEFAULT_ISLOCK_CACHE_SIZE);
 
     void WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock);
-    void RemoveInstantSendLock(CDBBatch& batch, const uint256& hash, CInstantSendLockPtr islock);
 
     void WriteInstantSendLockMined(const uint256& hash, int nHeight);
     void RemoveInstantSendLockMined(const uint256& hash, int nHeight);
@@ -122,6 +205,7 @@ public:
 
     void SyncTransaction(const CTransaction& tx, const CBlockIndex *pindex, int posInBlock);
 
+    // IsLocked, GetConflictingLock and GetInstantSendLockByHash don't take cs, so they don't wait for the worker thread
     bool IsLocked(const uint256& txHash);
     bool GetInstantSendLockByHash(const uint256& hash, CInstantSendLock& ret);
 
@@ -182,7 +182,24 @@ void CSigSharesNodeState::RemoveSession(const uint256& signHash)
 
 //////////////////////
 
-CSigSharesManager::CSigSharesManager()
+UniValue CSigSharesStats::ToJson() const
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("pendingSigShares", (int64_t)pendingSigShares));
+    ret.push_back(Pair("sigShares", (int64_t)sigShares));
+    ret.push_back(Pair("signSessions", (int64_t)signSessions));
+    ret.push_back(Pair("verifyRounds", (int64_t)verifyRounds));
+    ret.push_back(Pair("verifiedSigShares", (int64_t)verifiedSigShares));
+    ret.push_back(Pair("avgVerifyTime", verifyRounds ? totalVerifyTime / (int64_t)verifyRounds : 0));
+    ret.push_back(Pair("lastVerifyTime", lastVerifyTime));
+    ret.push_back(Pair("recoveredSigs", (int64_t)recoveredSigs));
+    ret.push_back(Pair("avgRecoveryTime", recoveredSigs ? totalRecoveryTime / (int64_t)recoveredSigs : 0));
+    ret.push_back(Pair("lastRecoveryTime", lastRecoveryTime));
+    return ret;
+}
+
+CSigSharesManager::CSigSharesManager(CBLSWorker& _blsWorker) :
+    blsWorker(_blsWorker)
 {
     workInterrupt.reset();
 }
@@ -582,7 +599,9 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
 
     // It's ok to perform insecure batched verification here as we verify against the quorum public key shares,
     // which are not craftable by individual entities, making the rogue public key attack impossible
-    CBLSBatchVerifier<NodeId, SigShareKey> batchVerifier(false, true);
+    // Shares are batched per quorum and the batches are verified in parallel on the BLS worker pool
+    typedef CBLSBatchVerifier<NodeId, SigShareKey> BatchVerifier;
+    std::unordered_map<std::pair<Consensus::LLMQType, uint256>, BatchVerifier, StaticSaltedHasher> batchVerifiers;
 
     size_t verifyCount = 0;
     for (auto& p : sigSharesByNodes) {
@@ -602,7 +621,8 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
                 break;
             }
 
-            auto quorum = quorums.at(std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash));
+            auto quorumKey = std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash);
+            auto quorum = quorums.at(quorumKey);
             auto pubKeyShare = quorum->GetPubKeyShare(sigShare.quorumMember);
 
             if (!pubKeyShare.IsValid()) {
@@ -612,22 +632,52 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
                 assert(false);
             }
 
-            batchVerifier.PushMessage(nodeId, sigShare.GetKey(), sigShare.GetSignHash(), sigShare.sigShare.Get(), pubKeyShare);
+            auto it = batchVerifiers.find(quorumKey);
+            if (it == batchVerifiers.end()) {
+                it = batchVerifiers.emplace(std::piecewise_construct, std::forward_as_tuple(quorumKey), std::forward_as_tuple(false, true)).first;
+            }
+            it->second.PushMessage(nodeId, sigShare.GetKey(), sigShare.GetSignHash(), sigShare.sigShare.Get(), pubKeyShare);
             verifyCount++;
         }
     }
 
     cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    if (batchVerifiers.size() == 1) {
+        batchVerifiers.begin()->second.Verify();
+    } else {
+        std::vector<std::future<void>> futures;
+        futures.reserve(batchVerifiers.size());
+        for (auto& p : batchVerifiers) {
+            BatchVerifier* batchVerifier = &p.second;
+            futures.emplace_back(blsWorker.Async([batchVerifier]() {
+                batchVerifier->Verify();
+            }));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+    }
     verifyTimer.stop();
 
-    LogPrint("llmq-sigs", "CSigSharesManager::%s -- verified sig shares. count=%d, vt=%d, nodes=%d\n", __func__, verifyCount, verifyTimer.count(), sigSharesByNodes.size());
+    std::set<NodeId> badSources;
+    for (auto& p : batchVerifiers) {
+        badSources.insert(p.second.badSources.begin(), p.second.badSources.end());
+    }
+
+    int64_t verifyTime = verifyTimer.count<std::chrono::microseconds>();
+    statVerifyRounds++;
+    statVerifiedSigShares += verifyCount;
+    statTotalVerifyTime += verifyTime;
+    statLastVerifyTime = verifyTime;
 
+    LogPrint("llmq-sigs", "CSigSharesManager::%s -- verified sig shares. count=%d, vt=%d, nodes=%d, quorums=%d\n", __func__, verifyCount, verifyTime / 1000, sigSharesByNodes.size(), batchVerifiers.size());
+
+    std::unordered_map<uint256, std::pair<CQuorumCPtr, CSigShare>, StaticSaltedHasher> recoveries;
     for (auto& p : sigSharesByNodes) {
         auto nodeId = p.first;
         auto& v = p.second;
 
-        if (batchVerifier.badSources.count(nodeId)) {
+        if (badSources.count(nodeId)) {
             LogPrintf("CSigSharesManager::%s -- invalid sig shares from other node, banning peer=%d\n",
                      __func__, nodeId);
             // this will also cause re-requesting of the shares that were sent by this node
@@ -635,9 +685,11 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
             continue;
         }
 
-        ProcessPendingSigSharesFromNode(nodeId, v, quorums, connman);
+        ProcessPendingSigSharesFromNode(nodeId, v, quorums, recoveries, connman);
     }
 
+    TryRecoverSigs(recoveries, connman);
+
     return true;
 }
 
@@ -645,6 +697,7 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
 void CSigSharesManager::ProcessPendingSigSharesFromNode(NodeId nodeId,
         const std::vector<CSigShare>& sigShares,
         const std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& quorums,
+        std::unordered_map<uint256, std::pair<CQuorumCPtr, CSigShare>, StaticSaltedHasher>& retRecoveries,
         CConnman& connman)
 {
     auto& nodeState = nodeStates[nodeId];
@@ -652,7 +705,10 @@ void CSigSharesManager::ProcessPendingSigSharesFromNode(NodeId nodeId,
     cxxtimer::Timer t(true);
     for (auto& sigShare : sigShares) {
         auto quorumKey = std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash);
-        ProcessSigShare(nodeId, sigShare, connman, quorums.at(quorumKey));
+        auto& quorum = quorums.at(quorumKey);
+        if (ProcessSigShare(nodeId, sigShare, connman, quorum)) {
+            retRecoveries.emplace(sigShare.GetSignHash(), std::make_pair(quorum, sigShare));
+        }
     }
     t.stop();
 
@@ -661,7 +717,7 @@ void CSigSharesManager::ProcessPendingSigSharesFromNode(NodeId nodeId,
 }
 
 // sig shares are already verified when entering this method
-void CSigSharesManager::ProcessSigShare(NodeId nodeId, const CSigShare& sigShare, CConnman& connman, const CQuorumCPtr& quorum)
+bool CSigSharesManager::ProcessSigShare(NodeId nodeId, const CSigShare& sigShare, CConnman& connman, const CQuorumCPtr& quorum)
 {
     auto llmqType = quorum->params.type;
 
@@ -674,14 +730,14 @@ void CSigSharesManager::ProcessSigShare(NodeId nodeId, const CSigShare& sigShare
     }
 
     if (quorumSigningManager->HasRecoveredSigForId(llmqType, sigShare.id)) {
-        return;
+        return false;
     }
 
     {
         LOCK(cs);
 
         if (!sigShares.Add(sigShare.GetKey(), sigShare)) {
-            return;
+            return false;
         }
         sigSharesToAnnounce.Add(sigShare.GetKey(), true);
 
@@ -706,9 +762,7 @@ void CSigSharesManager::ProcessSigShare(NodeId nodeId, const CSigShare& sigShare
         }
     }
 
-    if (canTryRecovery) {
-        TryRecoverSig(quorum, sigShare.id, sigShare.msgHash, connman);
-    }
+    return canTryRecovery;
 }
 
 void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash, CConnman& connman)
@@ -717,6 +771,51 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
         return;
     }
 
+    CRecoveredSig rs;
+    if (RecoverSig(quorum, id, msgHash, rs)) {
+        quorumSigningManager->ProcessRecoveredSig(-1, rs, quorum, connman);
+    }
+}
+
+void CSigSharesManager::TryRecoverSigs(const std::unordered_map<uint256, std::pair<CQuorumCPtr, CSigShare>, StaticSaltedHasher>& recoveries, CConnman& connman)
+{
+    if (recoveries.size() <= 1) {
+        for (auto& p : recoveries) {
+            TryRecoverSig(p.second.first, p.second.second.id, p.second.second.msgHash, connman);
+        }
+        return;
+    }
+
+    // Recover different sessions in parallel. Only the BLS work runs on the pool, the recovered sigs are
+    // processed here as listeners might use the pool themselves
+    std::vector<std::pair<const std::pair<CQuorumCPtr, CSigShare>*, CRecoveredSig>> results;
+    results.reserve(recoveries.size());
+    for (auto& p : recoveries) {
+        if (!quorumSigningManager->HasRecoveredSigForId(p.second.first->params.type, p.second.second.id)) {
+            results.emplace_back(&p.second, CRecoveredSig());
+        }
+    }
+
+    std::vector<std::future<bool>> futures;
+    futures.reserve(results.size());
+    for (auto& r : results) {
+        auto* result = &r;
+        futures.emplace_back(blsWorker.Async([this, result]() {
+            auto& quorum = result->first->first;
+            auto& sigShare = result->first->second;
+            return RecoverSig(quorum, sigShare.id, sigShare.msgHash, result->second);
+        }));
+    }
+
+    for (size_t i = 0; i < results.size(); i++) {
+        if (futures[i].get()) {
+            quorumSigningManager->ProcessRecoveredSig(-1, results[i].second, results[i].first->first, connman);
+        }
+    }
+}
+
+bool CSigSharesManager::RecoverSig(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash, CRecoveredSig& rs)
+{
     std::vector<CBLSSignature> sigSharesForRecovery;
     std::vector<CBLSId> idsForRecovery;
     {
@@ -727,7 +826,7 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
         auto signHash = CLLMQUtils::BuildSignHash(quorum->params.type, quorum->qc.quorumHash, id, msgHash);
         auto sigShares = this->sigShares.GetAllForSignHash(signHash);
         if (!sigShares) {
-            return;
+            return false;
         }
 
         sigSharesForRecovery.reserve((size_t) quorum->params.threshold);
@@ -740,7 +839,7 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
 
         // check if we can recover the final signature
         if (sigSharesForRecovery.size() < quorum->params.threshold) {
-            return;
+            return false;
         }
     }
 
@@ -750,13 +849,17 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
     if (!recoveredSig.Recover(sigSharesForRecovery, idsForRecovery)) {
         LogPrintf("CSigSharesManager::%s -- failed to recover signature. id=%s, msgHash=%s, time=%d\n", __func__,
                   id.ToString(), msgHash.ToString(), t.count());
-        return;
+        return false;
     }
 
+    int64_t recoveryTime = t.count<std::chrono::microseconds>();
+    statRecoveredSigs++;
+    statTotalRecoveryTime += recoveryTime;
+    statLastRecoveryTime = recoveryTime;
+
     LogPrint("llmq-sigs", "CSigSharesManager::%s -- recovered signature. id=%s, msgHash=%s, time=%d\n", __func__,
               id.ToString(), msgHash.ToString(), t.count());
 
-    CRecoveredSig rs;
     rs.llmqType = quorum->params.type;
     rs.quorumHash = quorum->qc.quorumHash;
     rs.id = id;
@@ -774,11 +877,11 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
             // this should really not happen as we have verified all signature shares before
             LogPrintf("CSigSharesManager::%s -- own recovered signature is invalid. id=%s, msgHash=%s\n", __func__,
                       id.ToString(), msgHash.ToString());
-            return;
+            return false;
         }
     }
 
-    quorumSigningManager->ProcessRecoveredSig(-1, rs, quorum, connman);
+    return true;
 }
 
 void CSigSharesManager::CollectSigSharesToRequest(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToRequest)
@@ -1335,6 +1438,27 @@ void CSigSharesManager::BanNode(NodeId nodeId)
     nodeState.banned = true;
 }
 
+void CSigSharesManager::GetStats(CSigSharesStats& stats)
+{
+    {
+        LOCK(cs);
+        stats.pendingSigShares = 0;
+        for (auto& p : nodeStates) {
+            stats.pendingSigShares += p.second.pendingIncomingSigShares.Size();
+        }
+        stats.sigShares = sigShares.Size();
+        stats.signSessions = timeSeenForSessions.size();
+    }
+
+    stats.verifyRounds = statVerifyRounds;
+    stats.verifiedSigShares = statVerifiedSigShares;
+    stats.totalVerifyTime = statTotalVerifyTime;
+    stats.lastVerifyTime = statLastVerifyTime;
+    stats.recoveredSigs = statRecoveredSigs;
+    stats.totalRecoveryTime = statTotalRecoveryTime;
+    stats.lastRecoveryTime = statLastRecoveryTime;
+}
+
 void CSigSharesManager::WorkThreadMain()
 {
     int64_t lastSendTime = 0;
@@ -1431,7 +1555,9 @@ void CSigSharesManager::Sign(const CQuorumCPtr& quorum, const uint256& id, const
 
     LogPrint("llmq-sigs", "CSigSharesManager::%s -- signed sigShare. signHash=%s, id=%s, msgHash=%s, llmqType=%d, quorum=%s, time=%s\n", __func__,
               signHash.ToString(), sigShare.id.ToString(), sigShare.msgHash.ToString(), quorum->params.type, quorum->qc.quorumHash.ToString(), t.count());
-    ProcessSigShare(-1, sigShare, *g_connman, quorum);
+    if (ProcessSigShare(-1, sigShare, *g_connman, quorum)) {
+        TryRecoverSig(quorum, sigShare.id, sigShare.msgHash, *g_connman);
+    }
 }
 
 // causes all known sigShares to be re-announced
@@ -6,6 +6,7 @@
 #define DASH_QUORUMS_SIGNING_SHARES_H
 
 #include "bls/bls.h"
+#include "bls/bls_worker.h"
 #include "chainparams.h"
 #include "net.h"
 #include "random.h"
@@ -14,6 +15,7 @@
 #include "sync.h"
 #include "tinyformat.h"
 #include "uint256.h"
+#include "univalue.h"
 
 #include "llmq/quorums.h"
 
@@ -328,6 +330,25 @@ public:
     void RemoveSession(const uint256& signHash);
 };
 
+// Counters exposed through "quorum sigsharesstats", times are in microseconds
+struct CSigSharesStats
+{
+    size_t pendingSigShares{0};
+    size_t sigShares{0};
+    size_t signSessions{0};
+
+    uint64_t verifyRounds{0};
+    uint64_t verifiedSigShares{0};
+    int64_t totalVerifyTime{0};
+    int64_t lastVerifyTime{0};
+
+    uint64_t recoveredSigs{0};
+    int64_t totalRecoveryTime{0};
+    int64_t lastRecoveryTime{0};
+
+    UniValue ToJson() const;
+};
+
 class CSigSharesManager : public CRecoveredSigsListener
 {
     static const int64_t SESSION_NEW_SHARES_TIMEOUT = 60;
@@ -363,8 +384,19 @@ private:
     int64_t lastCleanupTime{0};
     std::atomic<uint32_t> recoveredSigsCounter{0};
 
+    // verification of shares from different quorums and recovery of different sessions is spread over this pool
+    CBLSWorker& blsWorker;
+
+    std::atomic<uint64_t> statVerifyRounds{0};
+    std::atomic<uint64_t> statVerifiedSigShares{0};
+    std::atomic<int64_t> statTotalVerifyTime{0};
+    std::atomic<int64_t> statLastVerifyTime{0};
+    std::atomic<uint64_t> statRecoveredSigs{0};
+    std::atomic<int64_t> statTotalRecoveryTime{0};
+    std::atomic<int64_t> statLastRecoveryTime{0};
+
 public:
-    CSigSharesManager();
+    CSigSharesManager(CBLSWorker& _blsWorker);
     ~CSigSharesManager();
 
     void StartWorkerThread();
@@ -382,6 +414,8 @@ public:
 
     void HandleNewRecoveredSig(const CRecoveredSig& recoveredSig);
 
+    void GetStats(CSigSharesStats& stats);
+
 private:
     // all of these return false when the currently processed message should be aborted (as each message actually contains multiple messages)
     bool ProcessMessageSigSesAnn(CNode* pfrom, const CSigSesAnn& ann, CConnman& connman);
@@ -400,10 +434,15 @@ private:
     void ProcessPendingSigSharesFromNode(NodeId nodeId,
             const std::vector<CSigShare>& sigShares,
             const std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& quorums,
+            std::unordered_map<uint256, std::pair<CQuorumCPtr, CSigShare>, StaticSaltedHasher>& retRecoveries,
             CConnman& connman);
 
-    void ProcessSigShare(NodeId nodeId, const CSigShare& sigShare, CConnman& connman, const CQuorumCPtr& quorum);
+    // returns true if enough shares are known to try recovery for the share's session
+    bool ProcessSigShare(NodeId nodeId, const CSigShare& sigShare, CConnman& connman, const CQuorumCPtr& quorum);
     void TryRecoverSig(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash, CConnman& connman);
+    void TryRecoverSigs(const std::unordered_map<uint256, std::pair<CQuorumCPtr, CSigShare>, StaticSaltedHasher>& recoveries, CConnman& connman);
+    // only does the BLS work of recovery, safe to call from the BLS worker pool
+    bool RecoverSig(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash, CRecoveredSig& rs);
 
 private:
     bool GetSessionInfoByRecvId(NodeId nodeId, uint32_t sessionId, CSigSharesNodeState::SessionInfo& retInfo);
@@ -7,17 +7,80 @@
 
 #include "chainparams.h"
 #include "random.h"
+#include "unordered_lru_cache.h"
 #include "validation.h"
 
+#include "evo/evodb.h"
+
 namespace llmq
 {
 
+static const std::string DB_QUORUM_MEMBERS = "q_m";
+
+static const size_t QUORUM_MEMBERS_CACHE_SIZE = 100;
+
+static CCriticalSection cs_members;
+static unordered_lru_cache<std::pair<Consensus::LLMQType, uint256>, std::vector<CDeterministicMNCPtr>, StaticSaltedHasher> quorumMembersCache(QUORUM_MEMBERS_CACHE_SIZE);
+
+// Members are only a function of the quorum type and block, so they are stored as proTxHashes in evoDB and
+// resolved against the list of the quorum block when read back, which skips scoring every MN again
+static bool ReadQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum, std::vector<CDeterministicMNCPtr>& members)
+{
+    std::vector<uint256> proTxHashes;
+    if (!evoDb || !evoDb->Read(std::make_pair(DB_QUORUM_MEMBERS, std::make_pair((uint8_t)llmqType, pindexQuorum->GetBlockHash())), proTxHashes)) {
+        return false;
+    }
+
+    auto mnList = deterministicMNManager->GetListForBlock(pindexQuorum);
+    members.clear();
+    members.reserve(proTxHashes.size());
+    for (const auto& proTxHash : proTxHashes) {
+        auto dmn = mnList.GetMN(proTxHash);
+        if (!dmn) {
+            return false;
+        }
+        members.emplace_back(dmn);
+    }
+    return true;
+}
+
+static void WriteQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum, const std::vector<CDeterministicMNCPtr>& members)
+{
+    if (!evoDb) {
+        return;
+    }
+
+    std::vector<uint256> proTxHashes;
+    proTxHashes.reserve(members.size());
+    for (const auto& dmn : members) {
+        proTxHashes.emplace_back(dmn->proTxHash);
+    }
+    // not bound to block processing, so this bypasses the evoDB transaction like CQuorum::WriteContributions
+    evoDb->GetRawDB().Write(std::make_pair(DB_QUORUM_MEMBERS, std::make_pair((uint8_t)llmqType, pindexQuorum->GetBlockHash())), proTxHashes);
+}
+
 std::vector<CDeterministicMNCPtr> CLLMQUtils::GetAllQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum)
 {
-    auto& params = Params().GetConsensus().llmqs.at(llmqType);
-    auto allMns = deterministicMNManager->GetListForBlock(pindexQuorum);
-    auto modifier = ::SerializeHash(std::make_pair((uint8_t) llmqType, pindexQuorum->GetBlockHash()));
-    return allMns.CalculateQuorum(params.size, modifier);
+    auto cacheKey = std::make_pair(llmqType, pindexQuorum->GetBlockHash());
+    std::vector<CDeterministicMNCPtr> members;
+    {
+        LOCK(cs_members);
+        if (quorumMembersCache.get(cacheKey, members)) {
+            return members;
+        }
+    }
+
+    if (!ReadQuorumMembers(llmqType, pindexQuorum, members)) {
+        auto& params = Params().GetConsensus().llmqs.at(llmqType);
+        auto allMns = deterministicMNManager->GetListForBlock(pindexQuorum);
+        auto modifier = ::SerializeHash(std::make_pair((uint8_t) llmqType, pindexQuorum->GetBlockHash()));
+        members = allMns.CalculateQuorum(params.size, modifier);
+        WriteQuorumMembers(llmqType, pindexQuorum, members);
+    }
+
+    LOCK(cs_members);
+    quorumMembersCache.insert(cacheKey, members);
+    return members;
 }
 
 uint256 CLLMQUtils::BuildCommitmentHash(uint8_t llmqType, const uint256& blockHash, const std::vector<bool>& validMembers, const CBLSPublicKey& pubKey, const uint256& vvecHash)
@@ -29,6 +29,7 @@
 #include "masternode-sync.h"
 #include "llmq/quorums_instantsend.h"
 #include "evo/mnauth.h"
+#include "ctpl.h"
 
 #ifdef WIN32
 #include <string.h>
@@ -36,6 +37,10 @@
 #include <fcntl.h>
 #endif
 
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/miniwget.h>
@@ -910,7 +915,7 @@ size_t CConnman::SocketSendData(CNode *pnode) const
     size_t nSentSize = 0;
 
     while (it != pnode->vSendMsg.end()) {
-        const auto &data = *it;
+        const auto &data = it->Get();
         assert(data.size() > pnode->nSendOffset);
         int nBytes = 0;
         {
@@ -931,6 +936,8 @@ size_t CConnman::SocketSendData(CNode *pnode) const
                 it++;
             } else {
                 // could not send full message; stop sending more
+                // the socket buffer is full, wait for it to become writable again
+                pnode->fCanSendData = false;
                 break;
             }
         } else {
@@ -941,6 +948,8 @@ size_t CConnman::SocketSendData(CNode *pnode) const
                 {
                     LogPrintf("socket send error %s\n", NetworkErrorString(nErr));
                     pnode->CloseSocketDisconnect();
+                } else {
+                    pnode->fCanSendData = false;
                 }
             }
             // couldn't send anything at all
@@ -1270,6 +1279,10 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
 
     LogPrint("net", "connection from %s accepted\n", addr.ToString());
 
+#ifdef USE_EPOLL
+    RegisterSocketEvents(pnode);
+#endif
+
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
@@ -1365,6 +1378,8 @@ void CNode::CloseDandelionConnections(const CNode* const pnode)
 void CConnman::ThreadSocketHandler()
 {
     unsigned int nPrevNodeCount = 0;
+    // set when a node still has buffered socket data to handle, so that the next wait does not block
+    bool fMoreWork = false;
     while (!interruptNet)
     {
         //
@@ -1444,73 +1459,84 @@ void CConnman::ThreadSocketHandler()
         FD_ZERO(&fdsetRecv);
         FD_ZERO(&fdsetSend);
         FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
-
-        BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket) {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = std::max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
-        }
+        bool fListenReady = false;
 
+#ifdef USE_EPOLL
+        if (socketEventsMode == SOCKETEVENTS_EPOLL) {
+            SocketEventsEpoll(fMoreWork, fListenReady);
+            if (interruptNet)
+                return;
+        } else
+#endif
         {
-            LOCK(cs_vNodes);
-            BOOST_FOREACH(CNode* pnode, vNodes)
+            SOCKET hSocketMax = 0;
+            bool have_fds = false;
+
+            BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket) {
+                FD_SET(hListenSocket.socket, &fdsetRecv);
+                hSocketMax = std::max(hSocketMax, hListenSocket.socket);
+                have_fds = true;
+            }
+
             {
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is space left in the receive buffer, select() for
-                //   receiving data.
-                // * Hand off all complete messages to the processor, to be handled without
-                //   blocking here.
-
-                bool select_recv = !pnode->fPauseRecv;
-                bool select_send;
+                LOCK(cs_vNodes);
+                BOOST_FOREACH(CNode* pnode, vNodes)
                 {
-                    LOCK(pnode->cs_vSend);
-                    select_send = !pnode->vSendMsg.empty();
-                }
+                    // Implement the following logic:
+                    // * If there is data to send, select() for sending data. As this only
+                    //   happens when optimistic write failed, we choose to first drain the
+                    //   write buffer in this case before receiving more. This avoids
+                    //   needlessly queueing received data, if the remote peer is not themselves
+                    //   receiving data. This means properly utilizing TCP flow control signalling.
+                    // * Otherwise, if there is space left in the receive buffer, select() for
+                    //   receiving data.
+                    // * Hand off all complete messages to the processor, to be handled without
+                    //   blocking here.
+
+                    bool select_recv = !pnode->fPauseRecv;
+                    bool select_send;
+                    {
+                        LOCK(pnode->cs_vSend);
+                        select_send = !pnode->vSendMsg.empty();
+                    }
 
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
+                    LOCK(pnode->cs_hSocket);
+                    if (pnode->hSocket == INVALID_SOCKET)
+                        continue;
 
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = std::max(hSocketMax, pnode->hSocket);
-                have_fds = true;
+                    FD_SET(pnode->hSocket, &fdsetError);
+                    hSocketMax = std::max(hSocketMax, pnode->hSocket);
+                    have_fds = true;
 
-                if (select_send) {
-                    FD_SET(pnode->hSocket, &fdsetSend);
-                    continue;
-                }
-                if (select_recv) {
-                    FD_SET(pnode->hSocket, &fdsetRecv);
+                    if (select_send) {
+                        FD_SET(pnode->hSocket, &fdsetSend);
+                        continue;
+                    }
+                    if (select_recv) {
+                        FD_SET(pnode->hSocket, &fdsetRecv);
+                    }
                 }
             }
-        }
 
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-        if (interruptNet)
-            return;
+            int nSelect = select(have_fds ? hSocketMax + 1 : 0,
+                                 &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+            if (interruptNet)
+                return;
 
-        if (nSelect == SOCKET_ERROR)
-        {
-            if (have_fds)
+            if (nSelect == SOCKET_ERROR)
             {
-                int nErr = WSAGetLastError();
-                LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
+                if (have_fds)
+                {
+                    int nErr = WSAGetLastError();
+                    LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
+                    for (unsigned int i = 0; i <= hSocketMax; i++)
+                        FD_SET(i, &fdsetRecv);
+                }
+                FD_ZERO(&fdsetSend);
+                FD_ZERO(&fdsetError);
+                if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
+                    return;
             }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
-                return;
         }
 
         //
@@ -1518,7 +1544,7 @@ void CConnman::ThreadSocketHandler()
         //
         BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket)
         {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
+            if (hListenSocket.socket != INVALID_SOCKET && (fListenReady || FD_ISSET(hListenSocket.socket, &fdsetRecv)))
             {
                 AcceptConnection(hListenSocket);
             }
@@ -1534,6 +1560,7 @@ void CConnman::ThreadSocketHandler()
             BOOST_FOREACH(CNode* pnode, vNodesCopy)
                 pnode->AddRef();
         }
+        fMoreWork = false;
         BOOST_FOREACH(CNode* pnode, vNodesCopy)
         {
             if (interruptNet)
@@ -1545,7 +1572,23 @@ void CConnman::ThreadSocketHandler()
             bool recvSet = false;
             bool sendSet = false;
             bool errorSet = false;
-            {
+            if (socketEventsMode == SOCKETEVENTS_EPOLL) {
+                {
+                    LOCK(pnode->cs_hSocket);
+                    if (pnode->hSocket == INVALID_SOCKET)
+                        continue;
+                }
+                // same rules as for select(), drain the send buffer before receiving more
+                bool fHasSendData;
+                {
+                    LOCK(pnode->cs_vSend);
+                    fHasSendData = !pnode->vSendMsg.empty();
+                    sendSet = fHasSendData && pnode->fCanSendData;
+                }
+                recvSet = !fHasSendData && !pnode->fPauseRecv && pnode->fHasRecvData;
+                errorSet = pnode->fSocketError;
+                pnode->fSocketError = false;
+            } else {
                 LOCK(pnode->cs_hSocket);
                 if (pnode->hSocket == INVALID_SOCKET)
                     continue;
@@ -1566,6 +1609,10 @@ void CConnman::ThreadSocketHandler()
                                 continue;
                             nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
                         }
+                        // with edge-triggered events, keep reading until the socket buffer is drained
+                        pnode->fHasRecvData = nBytes == (int)sizeof(pchBuf);
+                        if (pnode->fHasRecvData && !pnode->fPauseRecv)
+                            fMoreWork = true;
                         if (nBytes > 0)
                         {
                             bool notify = false;
@@ -1664,6 +1711,67 @@ void CConnman::ThreadSocketHandler()
     }
 }
 
+#ifdef USE_EPOLL
+void CConnman::RegisterSocketEvents(CNode* pnode)
+{
+    if (socketEventsMode != SOCKETEVENTS_EPOLL)
+        return;
+
+    LOCK(pnode->cs_hSocket);
+    if (pnode->hSocket == INVALID_SOCKET)
+        return;
+
+    // The socket is registered only once and removed from the epoll set by the kernel when it gets closed. Nodes are
+    // only deleted by the socket handler thread after their socket was closed, so the pointer stays valid for all
+    // events returned by epoll_wait
+    epoll_event e;
+    e.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLERR | EPOLLHUP | EPOLLET;
+    e.data.ptr = pnode;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, pnode->hSocket, &e) != 0) {
+        LogPrintf("epoll_ctl failed for peer=%d: %s\n", pnode->id, NetworkErrorString(WSAGetLastError()));
+        pnode->fDisconnect = true;
+    }
+}
+
+void CConnman::SocketEventsEpoll(bool fOnlyPoll, bool& fListenReady)
+{
+    const size_t MAX_EVENTS = 1024;
+    epoll_event events[MAX_EVENTS];
+
+    // frequency to poll pnode->vSend is the same as with select()
+    int nEvents = epoll_wait(epollFd, events, MAX_EVENTS, fOnlyPoll ? 0 : 50);
+    if (nEvents < 0) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEINTR) {
+            LogPrintf("epoll_wait error %s\n", NetworkErrorString(nErr));
+            interruptNet.sleep_for(std::chrono::milliseconds(50));
+        }
+        return;
+    }
+
+    for (int i = 0; i < nEvents; i++) {
+        auto& e = events[i];
+        if (e.data.ptr == nullptr) {
+            // listen sockets are registered level-triggered without a node
+            fListenReady = true;
+            continue;
+        }
+
+        CNode* pnode = static_cast<CNode*>(e.data.ptr);
+        if (e.events & (EPOLLIN | EPOLLRDHUP)) {
+            pnode->fHasRecvData = true;
+        }
+        if (e.events & (EPOLLERR | EPOLLHUP)) {
+            pnode->fSocketError = true;
+        }
+        if (e.events & EPOLLOUT) {
+            LOCK(pnode->cs_vSend);
+            pnode->fCanSendData = true;
+        }
+    }
+}
+#endif
+
 void CConnman::WakeMessageHandler()
 {
     {
@@ -2323,6 +2431,9 @@ bool CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
         pnode->fAddnode = true;
 
     GetNodeSignals().InitializeNode(pnode, *this);
+#ifdef USE_EPOLL
+    RegisterSocketEvents(pnode);
+#endif
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
@@ -2355,6 +2466,28 @@ void CConnman::ThreadMessageHandler()
             if (pnode->fDisconnect)
                 continue;
 
+            // Wait for the worker to finish before touching this node again
+            if (pnode->fProcessingConcurrently)
+                continue;
+
+            if (msgProcPool && GetNodeSignals().CanProcessMessagesConcurrently(pnode)) {
+                // Hand off messages which only read chain state (e.g. serving getdata or getheaders), so that a slow
+                // request of one peer does not stall message processing for all others
+                pnode->fProcessingConcurrently = true;
+                pnode->AddRef();
+                msgProcPool->push([this, pnode](int threadId) {
+                    GetNodeSignals().ProcessMessages(pnode, *this, flagInterruptMsgProc);
+                    pnode->fProcessingConcurrently = false;
+                    {
+                        LOCK(cs_vNodes);
+                        pnode->Release();
+                    }
+                    // the message handler might have skipped this node, so let it process the node's next message
+                    WakeMessageHandler();
+                });
+                continue;
+            }
+
             // Receive messages
             bool fMoreNodeWork = GetNodeSignals().ProcessMessages(pnode, *this, flagInterruptMsgProc);
             fMoreWork |= (fMoreNodeWork && !pnode->fPauseSend);
@@ -2655,6 +2788,8 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In) : nSeed0(nSeed0In), nSe
     nBestHeight = 0;
     clientInterface = NULL;
     flagInterruptMsgProc = false;
+    socketEventsMode = SOCKETEVENTS_SELECT;
+    epollFd = -1;
 }
 
 NodeId CConnman::GetNewNodeId()
@@ -2679,6 +2814,26 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
     nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
     nReceiveFloodSize = connOptions.nReceiveFloodSize;
 
+    socketEventsMode = connOptions.socketEventsMode;
+#ifdef USE_EPOLL
+    if (socketEventsMode == SOCKETEVENTS_EPOLL) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd == -1) {
+            strNodeError = strprintf("epoll_create1 failed: %s", NetworkErrorString(WSAGetLastError()));
+            return false;
+        }
+        BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket) {
+            epoll_event e;
+            e.events = EPOLLIN;
+            e.data.ptr = nullptr;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, hListenSocket.socket, &e) != 0) {
+                strNodeError = strprintf("epoll_ctl failed for listen socket: %s", NetworkErrorString(WSAGetLastError()));
+                return false;
+            }
+        }
+    }
+#endif
+
     nMaxOutboundLimit = connOptions.nMaxOutboundLimit;
     nMaxOutboundTimeframe = connOptions.nMaxOutboundTimeframe;
 
@@ -2766,6 +2921,10 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
     threadOpenMasternodeConnections = std::thread(&TraceThread<std::function<void()> >, "mncon", std::function<void()>(std::bind(&CConnman::ThreadOpenMasternodeConnections, this)));
 
     // Process messages
+    if (connOptions.nMsgProcThreads > 0) {
+        msgProcPool.reset(new ctpl::thread_pool(connOptions.nMsgProcThreads));
+        RenameThreadPool(*msgProcPool, "firo-msgproc");
+    }
     threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand", std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
 
     // Dandelion shuffle
@@ -2827,6 +2986,11 @@ void CConnman::Stop()
 {
     if (threadMessageHandler.joinable())
         threadMessageHandler.join();
+    if (msgProcPool) {
+        // wait for the workers, they hold references to nodes
+        msgProcPool->stop(true);
+        msgProcPool.reset();
+    }
     if (threadOpenMasternodeConnections.joinable())
         threadOpenMasternodeConnections.join();
     if (threadOpenConnections.joinable())
@@ -2864,6 +3028,12 @@ void CConnman::Stop()
     vNodes.clear();
     vNodesDisconnected.clear();
     vhListenSocket.clear();
+#ifdef USE_EPOLL
+    if (epollFd != -1) {
+        close(epollFd);
+        epollFd = -1;
+    }
+#endif
     delete semOutbound;
     semOutbound = NULL;
     delete semAddnode;
@@ -3435,6 +3605,10 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     fZnode = false;
     fPauseRecv = false;
     fPauseSend = false;
+    fHasRecvData = false;
+    fSocketError = false;
+    fCanSendData = true;
+    fProcessingConcurrently = false;
     nProcessQueueSize = 0;
     pendingMNVerification = nullptr;
 
@@ -3520,13 +3694,14 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
 
 void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg, bool allowOptimisticSend)
 {
-    size_t nMessageSize = msg.data.size();
+    const std::vector<unsigned char>& payload = msg.sharedPayload ? msg.sharedPayload->data : msg.data;
+    size_t nMessageSize = payload.size();
     size_t nTotalSize = nMessageSize + CMessageHeader::HEADER_SIZE;
     LogPrint("net", "sending %s (%d bytes) peer=%d\n",  SanitizeString(msg.command.c_str()), nMessageSize, pnode->id);
 
     std::vector<unsigned char> serializedHeader;
     serializedHeader.reserve(CMessageHeader::HEADER_SIZE);
-    uint256 hash = Hash(msg.data.data(), msg.data.data() + nMessageSize);
+    uint256 hash = msg.sharedPayload ? msg.sharedPayload->hash : Hash(payload.data(), payload.data() + nMessageSize);
     CMessageHeader hdr(Params().MessageStart(), msg.command.c_str(), nMessageSize);
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
@@ -3543,9 +3718,11 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg, bool allowOpti
 
         if (pnode->nSendSize > nSendBufferMaxSize)
             pnode->fPauseSend = true;
-        pnode->vSendMsg.push_back(std::move(serializedHeader));
-        if (nMessageSize)
-            pnode->vSendMsg.push_back(std::move(msg.data));
+        pnode->vSendMsg.emplace_back(std::move(serializedHeader));
+        if (nMessageSize && msg.sharedPayload)
+            pnode->vSendMsg.emplace_back(std::move(msg.sharedPayload));
+        else if (nMessageSize)
+            pnode->vSendMsg.emplace_back(std::move(msg.data));
 
         // If write queue empty, attempt "optimistic write"
         if (optimisticSend == true)
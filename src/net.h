@@ -112,6 +112,17 @@ static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
 
+/** Default number of threads for processing messages which only read chain state, 0 processes all messages on the
+ *  message handler thread */
+static const int DEFAULT_MSGPROC_THREADS = 0;
+static const int MAX_MSGPROC_THREADS = 16;
+
+#ifdef USE_EPOLL
+static const std::string DEFAULT_SOCKETEVENTS = "epoll";
+#else
+static const std::string DEFAULT_SOCKETEVENTS = "select";
+#endif
+
 static const ServiceFlags REQUIRED_SERVICES = NODE_NETWORK;
 
 // NOTE: When adjusting this, update rpcnet:setban's help ("24h")
@@ -133,6 +144,16 @@ class CTransaction;
 class CNodeStats;
 class CClientUIInterface;
 
+/** A message payload that is serialized once and sent to many peers, e.g. a recent block */
+struct CSharedNetPayload
+{
+    std::vector<unsigned char> data;
+    uint256 hash; // Hash() of data, the message checksum is taken from it
+
+    explicit CSharedNetPayload(std::vector<unsigned char>&& dataIn) : data(std::move(dataIn)), hash(Hash(data.begin(), data.end())) {}
+};
+typedef std::shared_ptr<const CSharedNetPayload> CSharedNetPayloadRef;
+
 struct CSerializedNetMsg
 {
     CSerializedNetMsg() = default;
@@ -143,9 +164,23 @@ struct CSerializedNetMsg
     CSerializedNetMsg& operator=(const CSerializedNetMsg&) = delete;
 
     std::vector<unsigned char> data;
+    // if set it's sent instead of data, without copying it
+    CSharedNetPayloadRef sharedPayload;
     std::string command;
 };
 
+/** An entry of a node's send queue, either owned by the node or a payload shared with other nodes */
+struct CNetSendBuffer
+{
+    std::vector<unsigned char> data;
+    CSharedNetPayloadRef sharedPayload;
+
+    explicit CNetSendBuffer(std::vector<unsigned char>&& dataIn) : data(std::move(dataIn)) {}
+    explicit CNetSendBuffer(CSharedNetPayloadRef&& sharedPayloadIn) : sharedPayload(std::move(sharedPayloadIn)) {}
+
+    const std::vector<unsigned char>& Get() const { return sharedPayload ? sharedPayload->data : data; }
+};
+
 
 class CConnman
 {
@@ -158,6 +193,11 @@ public:
         CONNECTIONS_ALL = (CONNECTIONS_IN | CONNECTIONS_OUT),
     };
 
+    enum SocketEventsMode {
+        SOCKETEVENTS_SELECT,
+        SOCKETEVENTS_EPOLL,
+    };
+
     struct Options
     {
         ServiceFlags nLocalServices = NODE_NONE;
@@ -172,6 +212,8 @@ public:
         unsigned int nReceiveFloodSize = 0;
         uint64_t nMaxOutboundTimeframe = 0;
         uint64_t nMaxOutboundLimit = 0;
+        SocketEventsMode socketEventsMode = SOCKETEVENTS_SELECT;
+        int nMsgProcThreads = 0;
     };
     CConnman(uint64_t seed0, uint64_t seed1);
     ~CConnman();
@@ -430,6 +472,13 @@ private:
     void ThreadMessageHandler();
     void AcceptConnection(const ListenSocket& hListenSocket);
     void ThreadSocketHandler();
+#ifdef USE_EPOLL
+    // Registers the node's socket once, readiness is then tracked in the node's edge-triggered flags
+    void RegisterSocketEvents(CNode* pnode);
+    // Waits for socket events and updates the readiness flags of the nodes. fListenReady is set if a listen
+    // socket has connections to accept
+    void SocketEventsEpoll(bool fOnlyPoll, bool& fListenReady);
+#endif
     void ThreadDNSAddressSeed();
     void ThreadOpenMasternodeConnections();
     void ThreadDandelionShuffle();
@@ -489,6 +538,8 @@ private:
     unsigned int nReceiveFloodSize;
 
     std::vector<ListenSocket> vhListenSocket;
+    SocketEventsMode socketEventsMode;
+    int epollFd;
     std::atomic<bool> fNetworkActive;
     banmap_t setBanned;
     CCriticalSection cs_setBanned;
@@ -537,6 +588,8 @@ private:
     std::condition_variable condMsgProc;
     std::mutex mutexMsgProc;
     std::atomic<bool> flagInterruptMsgProc;
+    // processes messages which don't mutate chain state, see CNodeSignals::CanProcessMessagesConcurrently
+    std::unique_ptr<ctpl::thread_pool> msgProcPool;
 
     CThreadInterrupt interruptNet;
 
@@ -574,6 +627,8 @@ struct CNodeSignals
 {
     boost::signals2::signal<bool (CNode*, CConnman&, std::atomic<bool>&), CombinerAll> ProcessMessages;
     boost::signals2::signal<bool (CNode*, CConnman&, std::atomic<bool>&), CombinerAll> SendMessages;
+    // Returns true if the node's next ProcessMessages call may run on a worker thread, concurrently with other nodes
+    boost::signals2::signal<bool (CNode*), CombinerAll> CanProcessMessagesConcurrently;
     boost::signals2::signal<void (CNode*, CConnman&)> InitializeNode;
     boost::signals2::signal<void (NodeId, bool&)> FinalizeNode;
 };
@@ -719,7 +774,7 @@ public:
     size_t nSendSize; // total size of all vSendMsg entries
     size_t nSendOffset; // offset inside the first vSendMsg already sent
     uint64_t nSendBytes;
-    std::deque<std::vector<unsigned char>> vSendMsg;
+    std::deque<CNetSendBuffer> vSendMsg;
     CCriticalSection cs_vSend;
     CCriticalSection cs_hSocket;
     CCriticalSection cs_vRecv;
@@ -778,6 +833,15 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv;
     std::atomic_bool fPauseSend;
+
+    // Edge-triggered socket readiness, only used with -socketevents=epoll. fHasRecvData and fSocketError are only
+    // accessed by the socket handler thread, fCanSendData is protected by cs_vSend
+    bool fHasRecvData;
+    bool fSocketError;
+    bool fCanSendData;
+    // Set while the node's messages are processed on a worker of the message processing pool. The message handler
+    // thread skips the node until the worker is done, which keeps the node's messages in order
+    std::atomic_bool fProcessingConcurrently;
 protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
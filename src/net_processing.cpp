@@ -7,6 +7,7 @@
 
 #include "addrman.h"
 #include "arith_uint256.h"
+#include "blockcache.h"
 #include "blockencodings.h"
 #include "chainparams.h"
 #include "consensus/validation.h"
@@ -597,6 +598,7 @@ void RegisterNodeSignals(CNodeSignals& nodeSignals)
 {
     nodeSignals.ProcessMessages.connect(&ProcessMessages);
     nodeSignals.SendMessages.connect(&SendMessages);
+    nodeSignals.CanProcessMessagesConcurrently.connect(&CanProcessMessagesConcurrently);
     nodeSignals.InitializeNode.connect(&InitializeNode);
     nodeSignals.FinalizeNode.connect(&FinalizeNode);
 }
@@ -605,6 +607,7 @@ void UnregisterNodeSignals(CNodeSignals& nodeSignals)
 {
     nodeSignals.ProcessMessages.disconnect(&ProcessMessages);
     nodeSignals.SendMessages.disconnect(&SendMessages);
+    nodeSignals.CanProcessMessagesConcurrently.disconnect(&CanProcessMessagesConcurrently);
     nodeSignals.InitializeNode.disconnect(&InitializeNode);
     nodeSignals.FinalizeNode.disconnect(&FinalizeNode);
 }
@@ -806,12 +809,12 @@ void PeerLogicValidation::SyncTransaction(const CTransaction& tx, const CBlockIn
 
 static CCriticalSection cs_most_recent_block;
 static std::shared_ptr<const CBlock> most_recent_block;
-static std::shared_ptr<const CBlockHeaderAndShortTxIDs> most_recent_compact_block;
 static uint256 most_recent_block_hash;
 
 void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) {
-    std::shared_ptr<const CBlockHeaderAndShortTxIDs> pcmpctblock = std::make_shared<const CBlockHeaderAndShortTxIDs> (*pblock, true);
     const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    CSerializedBlockCache* blockCache = CSerializedBlockCache::GetCache();
+    blockCache->AddBlock(pblock);
 
     LOCK(cs_main);
 
@@ -827,11 +830,14 @@ void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std:
         LOCK(cs_most_recent_block);
         most_recent_block_hash = hashBlock;
         most_recent_block = pblock;
-        most_recent_compact_block = pcmpctblock;
     }
 
+    // Serialized once for all peers. The block was just added to the cache, it may not be on disk yet
+    CSharedNetPayloadRef pcmpctblock = blockCache->GetSerializedCompactBlock(pindex, true, false, Params().GetConsensus());
+    if (!pcmpctblock)
+        return;
+
     connman->ForEachNode([this, &pcmpctblock, pindex, &msgMaker, fWitnessEnabled, &hashBlock](CNode* pnode) {
-        // TODO: Avoid the repeated-serialization here
         if (pnode->nVersion < INVALID_CB_NO_BAN_VERSION || pnode->fDisconnect)
             return;
         ProcessBlockAvailability(pnode->GetId());
@@ -843,7 +849,7 @@ void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std:
 
             LogPrint("net", "%s sending header-and-ids %s to peer=%d\n", "PeerLogicValidation::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->id);
-            connman->PushMessage(pnode, msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+            connman->PushMessage(pnode, msgMaker.MakeShared(NetMsgType::CMPCTBLOCK, pcmpctblock));
             state.pindexBestHeaderSent = pindex;
         }
     });
@@ -1086,30 +1092,34 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                 // it's available before trying to send.
                 if (send && (mi->second->nStatus & BLOCK_HAVE_DATA))
                 {
-                    // Send block from disk
-                    CBlock block;
-                    if (!ReadBlockFromDisk(block, (*mi).second, consensusParams))
+                    // Send block from the serialized block cache, it reads from disk on a miss
+                    CSerializedBlockCache* blockCache = CSerializedBlockCache::GetCache();
+                    std::shared_ptr<const CBlock> pblock = blockCache->GetBlock((*mi).second, false, consensusParams);
+                    if (!pblock)
                         assert(!"cannot load block from disk");
                     // Strip MTP data if past specific point of time
-                    if (!block.IsProgPow() && block.IsMTP() && GetTime() >= consensusParams.nMTPStripDataTime) {
+                    bool fStripMTP = false;
+                    if (!pblock->IsProgPow() && pblock->IsMTP() && GetTime() >= consensusParams.nMTPStripDataTime) {
                         if (pfrom->nVersion >= MTPDATA_STRIPPED_VERSION) {
-                            if (block.mtpHashData)
-                                block.mtpHashData->StripMTPData();
+                            fStripMTP = true;
                         }
                         else {
                             // node is not ready for a block with stripped MTP data. Skip the block if MTP
                             // data has already been stripped locally
-                            if (!block.mtpHashData || block.mtpHashData->IsMTPDataStripped())
+                            if (!pblock->mtpHashData || pblock->mtpHashData->IsMTPDataStripped())
                                 continue;
                         }
                     }
 
                     if (inv.type == MSG_BLOCK)
-                        connman.PushMessage(pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::BLOCK, block));
+                        connman.PushMessage(pfrom, msgMaker.MakeShared(NetMsgType::BLOCK, blockCache->GetSerializedBlock((*mi).second, SERIALIZE_TRANSACTION_NO_WITNESS, fStripMTP, consensusParams)));
                     else if (inv.type == MSG_WITNESS_BLOCK)
-                        connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCK, block));
+                        connman.PushMessage(pfrom, msgMaker.MakeShared(NetMsgType::BLOCK, blockCache->GetSerializedBlock((*mi).second, 0, fStripMTP, consensusParams)));
                     else if (inv.type == MSG_FILTERED_BLOCK)
                     {
+                        if (fStripMTP)
+                            pblock = blockCache->GetBlock((*mi).second, true, consensusParams);
+                        const CBlock& block = *pblock;
                         bool sendMerkleBlock = false;
                         CMerkleBlock merkleBlock;
                         {
@@ -1142,11 +1152,10 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                         // instead we respond with the full, non-compact block.
                         bool fPeerWantsWitness = State(pfrom->GetId())->fWantsCmpctWitness;
                         int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-                        if (CanDirectFetch(consensusParams) && mi->second->nHeight >= chainActive.Height() - MAX_CMPCTBLOCK_DEPTH) {
-                            CBlockHeaderAndShortTxIDs cmpctblock(block, fPeerWantsWitness);
-                            connman.PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
-                        } else
-                            connman.PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCK, block));
+                        if (CanDirectFetch(consensusParams) && mi->second->nHeight >= chainActive.Height() - MAX_CMPCTBLOCK_DEPTH)
+                            connman.PushMessage(pfrom, msgMaker.MakeShared(NetMsgType::CMPCTBLOCK, blockCache->GetSerializedCompactBlock((*mi).second, fPeerWantsWitness, fStripMTP, consensusParams)));
+                        else
+                            connman.PushMessage(pfrom, msgMaker.MakeShared(NetMsgType::BLOCK, blockCache->GetSerializedBlock((*mi).second, nSendFlags, fStripMTP, consensusParams)));
                     }
 
                     // Trigger the peer node to send a getblocks request for the next batch of inventory
@@ -1981,11 +1990,10 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
-        CBlock block;
-        bool ret = ReadBlockFromDisk(block, it->second, chainparams.GetConsensus());
-        assert(ret);
+        std::shared_ptr<const CBlock> pblock = CSerializedBlockCache::GetCache()->GetBlock(it->second, false, chainparams.GetConsensus());
+        assert(pblock);
 
-        SendBlockTransactions(block, req, pfrom, connman);
+        SendBlockTransactions(*pblock, req, pfrom, connman);
     }
 
 
@@ -3081,6 +3089,39 @@ static bool SendRejectsAndCheckIfBanned(CNode* pnode, CConnman& connman)
     return false;
 }
 
+// Requests which are answered from chain state/block files without changing them. GETBLOCKS is not included as it
+// calls ActivateBestChain
+static bool IsReadOnlyCommand(const std::string& strCommand)
+{
+    return strCommand == NetMsgType::GETDATA ||
+           strCommand == NetMsgType::GETHEADERS ||
+           strCommand == NetMsgType::GETBLOCKTXN ||
+           strCommand == NetMsgType::GETMNLISTDIFF ||
+           strCommand == NetMsgType::QSIGSHARESINV ||
+           strCommand == NetMsgType::QGETSIGSHARES;
+}
+
+bool CanProcessMessagesConcurrently(CNode* pfrom)
+{
+    // handshake messages set up the node state and must be processed in order with everything else
+    if (!pfrom->fSuccessfullyConnected)
+        return false;
+
+    // continue serving a previous getdata
+    if (!pfrom->vRecvGetData.empty())
+        return true;
+
+    std::string strCommand;
+    {
+        LOCK(pfrom->cs_vProcessMsg);
+        if (pfrom->vProcessMsg.empty())
+            return false;
+        strCommand = pfrom->vProcessMsg.front().hdr.GetCommand();
+    }
+
+    return IsReadOnlyCommand(strCommand);
+}
+
 bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
 {
     const CChainParams& chainparams = Params();
@@ -3112,6 +3153,10 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
             LOCK(pfrom->cs_vProcessMsg);
             if (pfrom->vProcessMsg.empty())
                 return false;
+            // A node is handed to a worker to serve its getdata queue or a read only request, anything else
+            // is left to the message handler thread
+            if (pfrom->fProcessingConcurrently && !IsReadOnlyCommand(pfrom->vProcessMsg.front().hdr.GetCommand()))
+                return true;
             // Just take one message
             msgs.splice(msgs.begin(), pfrom->vProcessMsg, pfrom->vProcessMsg.begin());
             pfrom->nProcessQueueSize -= msgs.front().vRecv.size() + CMessageHeader::HEADER_SIZE;
@@ -3406,28 +3451,9 @@ bool SendMessages(CNode* pto, CConnman& connman, const std::atomic<bool>& interr
                     LogPrint("net", "%s sending header-and-ids %s to peer=%d\n", __func__,
                             vHeaders.front().GetHash().ToString(), pto->id);
 
-                    int nSendFlags = state.fWantsCmpctWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-
-                    bool fGotBlockFromCache = false;
-                    {
-                        LOCK(cs_most_recent_block);
-                        if (most_recent_block_hash == pBestIndex->GetBlockHash()) {
-                            if (state.fWantsCmpctWitness)
-                                connman.PushMessage(pto, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, *most_recent_compact_block));
-                            else {
-                                CBlockHeaderAndShortTxIDs cmpctblock(*most_recent_block, state.fWantsCmpctWitness);
-                                connman.PushMessage(pto, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
-                            }
-                            fGotBlockFromCache = true;
-                        }
-                    }
-                    if (!fGotBlockFromCache) {
-                        CBlock block;
-                        bool ret = ReadBlockFromDisk(block, pBestIndex, consensusParams);
-                        assert(ret);
-                        CBlockHeaderAndShortTxIDs cmpctblock(block, state.fWantsCmpctWitness);
-                        connman.PushMessage(pto, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
-                    }
+                    CSharedNetPayloadRef cmpctblock = CSerializedBlockCache::GetCache()->GetSerializedCompactBlock(pBestIndex, state.fWantsCmpctWitness, false, consensusParams);
+                    assert(cmpctblock);
+                    connman.PushMessage(pto, msgMaker.MakeShared(NetMsgType::CMPCTBLOCK, cmpctblock));
                     state.pindexBestHeaderSent = pBestIndex;
                 } else if (state.fPreferHeaders) {
                     if (vHeaders.size() > 1) {
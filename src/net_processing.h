@@ -61,6 +61,8 @@ bool IsBanned(NodeId nodeid);
 
 /** Process protocol messages received from a given node */
 bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& interrupt);
+/** Whether the next ProcessMessages call for the node only reads chain state and may run concurrently with other nodes */
+bool CanProcessMessagesConcurrently(CNode* pfrom);
 /**
  * Send queued protocol messages to be sent to a give node.
  *
@@ -29,6 +29,15 @@ public:
         return Make(0, std::move(sCommand), std::forward<Args>(args)...);
     }
 
+    // The payload is shared, not copied, so it's serialized only once for all peers it's sent to
+    CSerializedNetMsg MakeShared(std::string sCommand, CSharedNetPayloadRef payload) const
+    {
+        CSerializedNetMsg msg;
+        msg.command = std::move(sCommand);
+        msg.sharedPayload = std::move(payload);
+        return msg;
+    }
+
 private:
     const int nVersion;
 };
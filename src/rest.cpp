@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "blockcache.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "primitives/block.h"
@@ -15,12 +16,16 @@
 #include "txmempool.h"
 #include "utilstrencodings.h"
 #include "version.h"
+#include "spark/sectorcache.h"
+#include "spark/state.h"
 
 #include <boost/algorithm/string.hpp>
 
 #include <univalue.h>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const size_t SPARKSET_CHUNK_COINS = 1000; //minimum number of spark coins collected per chunk, cs_main is released in between
+static const size_t SPARKSET_CHUNK_BYTES = 1024 * 1024; //size of the chunks a cached full spark set is sent in
 
 enum RetFormat {
     RF_UNDEF,
@@ -213,7 +218,9 @@ static bool rest_block(HTTPRequest* req,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
-    CBlock block;
+    // Both the encoding and the parsed block come from the serialized block cache shared with the P2P code
+    CSharedNetPayloadRef serializedBlock;
+    std::shared_ptr<const CBlock> pblock;
     CBlockIndex* pblockindex = NULL;
     {
         LOCK(cs_main);
@@ -224,30 +231,32 @@ static bool rest_block(HTTPRequest* req,
         if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+        CSerializedBlockCache* blockCache = CSerializedBlockCache::GetCache();
+        if (rf == RF_JSON)
+            pblock = blockCache->GetBlock(pblockindex, false, Params().GetConsensus());
+        else
+            serializedBlock = blockCache->GetSerializedBlock(pblockindex, RPCSerializationFlags(), false, Params().GetConsensus());
+        if (!pblock && !serializedBlock)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
 
-    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ssBlock << block;
-
     switch (rf) {
     case RF_BINARY: {
-        std::string binaryBlock = ssBlock.str();
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        // aliases the cached payload, it's handed to libevent without a copy
+        req->WriteReply(HTTP_OK, std::shared_ptr<const std::vector<unsigned char>>(serializedBlock, &serializedBlock->data));
         return true;
     }
 
     case RF_HEX: {
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
+        std::string strHex = HexStr(serializedBlock->data.begin(), serializedBlock->data.end()) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
     }
 
     case RF_JSON: {
-        UniValue objBlock = blockToJSON(block, pblockindex, showTxDetails);
+        UniValue objBlock = blockToJSON(*pblock, pblockindex, showTxDetails);
         std::string strJSON = objBlock.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strJSON);
@@ -591,6 +600,108 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+static bool rest_sparkset(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Use /rest/sparkset/<group>/<fromblock>.<ext>.");
+
+    if (!GetBoolArg("-mobile", false))
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Please rerun Firo with -mobile");
+
+    int coinGroupId = atoi(path[0]);
+    if (coinGroupId < 1)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid coin group: " + path[0]);
+
+    // all zeroes (or any hash not in the set) returns the full set
+    uint256 fromBlock;
+    if (!ParseHashStr(path[1], fromBlock))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + path[1]);
+    const std::string fromBlockHex = fromBlock.GetHex();
+
+    if (rf != RF_BINARY && rf != RF_HEX)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
+
+    spark::CSparkState* sparkState = spark::CSparkState::GetState();
+    spark::CSparkSectorCache* sectorCache = spark::CSparkSectorCache::GetCache();
+    uint256 blockHash;
+    std::vector<unsigned char> setHash;
+    std::vector<std::pair<CBlockIndex*, int>> blocks;
+    spark::CSparkSectorCache::SectorPtr frozen;
+    uint64_t setSize = 0;
+    {
+        LOCK(cs_main);
+        sparkState->GetBlocksForRecovery(
+                &chainActive,
+                chainActive.Height() - (ZC_MINT_CONFIRMATIONS - 1),
+                coinGroupId,
+                fromBlockHex,
+                blockHash,
+                setHash,
+                blocks);
+        for (const auto& block : blocks) {
+            auto it = block.first->sparkMintedCoins.find(block.second);
+            if (it != block.first->sparkMintedCoins.end())
+                setSize += it->second.size();
+        }
+        // the full set of a complete group may be cached as a whole
+        if (fromBlock.IsNull() && !blocks.empty())
+            sectorCache->GetFrozenSet(coinGroupId, blockHash, frozen);
+    }
+
+    // Stream layout: block hash, set hash, number of coins, followed by the coins serialized the same
+    // way as in getsparkanonymityset. The set is pinned to blockHash, so new blocks don't shift it while
+    // streaming. If blockHash gets disconnected meanwhile the stream ends early with fewer coins.
+    CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
+    ssHeader << blockHash << setHash << COMPACTSIZE(setSize);
+
+    req->WriteHeader("Content-Type", rf == RF_BINARY ? "application/octet-stream" : "text/plain");
+    req->WriteReplyStart(HTTP_OK);
+    bool fConnected = req->WriteReplyChunk(rf == RF_BINARY ? ssHeader.str() : HexStr(ssHeader.begin(), ssHeader.end()));
+
+    if (frozen) {
+        // never changes, no lock needed
+        const std::vector<unsigned char>& data = frozen->serialized;
+        for (size_t pos = 0; fConnected && pos < data.size(); pos += SPARKSET_CHUNK_BYTES) {
+            auto begin = data.begin() + pos;
+            auto end = data.begin() + std::min(pos + SPARKSET_CHUNK_BYTES, data.size());
+            fConnected = req->WriteReplyChunk(rf == RF_BINARY ? std::string(begin, end) : HexStr(begin, end));
+        }
+        blocks.clear();
+    }
+
+    for (size_t i = 0; fConnected && i < blocks.size(); ) {
+        // encoded sectors come from the cache, only new ones are encoded under cs_main
+        std::vector<spark::CSparkSectorCache::SectorPtr> sectors;
+        size_t nCoins = 0;
+        {
+            LOCK(cs_main);
+            if (!chainActive.Contains(blocks.front().first))
+                break;
+            for (; i < blocks.size() && nCoins < SPARKSET_CHUNK_COINS; i++) {
+                sectors.push_back(sectorCache->GetSector(blocks[i].first, blocks[i].second));
+                nCoins += sectors.back()->nCoins;
+            }
+        }
+
+        std::string chunk;
+        for (const auto& sector : sectors)
+            chunk.append(sector->serialized.begin(), sector->serialized.end());
+        fConnected = req->WriteReplyChunk(rf == RF_BINARY ? chunk : HexStr(chunk.begin(), chunk.end()));
+    }
+
+    if (rf == RF_HEX && fConnected)
+        req->WriteReplyChunk("\n");
+    req->WriteReplyEnd();
+    return true;
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -603,6 +714,7 @@ static const struct {
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/sparkset/", rest_sparkset},
 };
 
 bool StartREST()
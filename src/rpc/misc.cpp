@@ -21,6 +21,9 @@
 #endif
 #include "sigma.h"
 #include "txdb.h"
+#include "spark/sectorcache.h"
+#include "gcsfilter.h"
+#include "crypto/common.h"
 
 #include "masternode-sync.h"
 #include "evo/deterministicmns.h"
@@ -31,6 +34,14 @@
 
 #include <univalue.h>
 
+// Maximum number of coins getsparkanonymitysetsector returns at once
+static const int MAX_SPARK_SECTOR_COINS = 10000;
+// Maximum number of blocks getusedcoinstagsdelta/getusedcoinstagsfilter cover at once
+static const int MAX_USED_LTAGS_RANGE = 10000;
+// Filter parameters of getusedcoinstagsfilter, same as BIP 158 basic filters
+static const uint8_t USED_LTAGS_FILTER_P = 19;
+static const uint32_t USED_LTAGS_FILTER_M = 784931;
+
 /**
  * @note Do not add or change anything in the information returned by this
  * method. `getinfo` exists for backwards-compatibility only. It combines
@@ -882,6 +893,8 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
                         "    ]\n"
                         "  \"start\" (number) The start block height\n"
                         "  \"end\" (number) The end block height\n"
+                        "  \"limit\" (number, optional) Return pages of about this many changes, a transaction is never split\n"
+                        "  \"cursor\" (object, optional) The cursor returned with the previous page\n"
                         "}\n"
                         "\nResult:\n"
                         "[\n"
@@ -894,8 +907,18 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
                         "    \"address\"  (string) The base58check encoded address\n"
                         "  }\n"
                         "]\n"
+                        "\nResult with limit:\n"
+                        "{\n"
+                        "  \"deltas\"  (array) The changes as above\n"
+                        "  \"cursor\"  (object) Where the next page starts, null after the last page\n"
+                        "    {\n"
+                        "      \"height\"  (number) The block height\n"
+                        "      \"blockindex\"  (number) The block index\n"
+                        "    }\n"
+                        "}\n"
                         "\nExamples:\n"
                 + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+                + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
                 + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -920,10 +943,34 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    UniValue limitValue = find_value(request.params[0].get_obj(), "limit");
+    size_t limit = 0;
+    int cursorHeight = start;
+    unsigned int cursorTxIndex = 0;
+    if (!limitValue.isNull()) {
+        if (limitValue.get_int() <= 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit is expected to be positive");
+        }
+        limit = limitValue.get_int();
+        UniValue cursorValue = find_value(request.params[0].get_obj(), "cursor");
+        if (cursorValue.isObject()) {
+            cursorHeight = find_value(cursorValue.get_obj(), "height").get_int();
+            cursorTxIndex = find_value(cursorValue.get_obj(), "blockindex").get_int();
+        }
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    bool fMore = false;
 
     for (std::vector<std::pair<uint160, AddressType> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (start > 0 && end > 0) {
+        if (limit > 0) {
+            // a page of every address, starting at the cursor
+            size_t nBefore = addressIndex.size();
+            if (!GetAddressIndexPage((*it).first, (*it).second, addressIndex, cursorHeight, cursorTxIndex, end, limit)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            fMore |= addressIndex.size() - nBefore >= limit;
+        } else if (start > 0 && end > 0) {
             if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
                 throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
             }
@@ -934,6 +981,21 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         }
     }
 
+    if (limit > 0 && addresses.size() > 1) {
+        // merge the pages of the addresses, the first limit changes are all known to be read
+        std::stable_sort(addressIndex.begin(), addressIndex.end(),
+            [](const std::pair<CAddressIndexKey, CAmount>& a, const std::pair<CAddressIndexKey, CAmount>& b) {
+                return std::make_pair(a.first.blockHeight, a.first.txindex) < std::make_pair(b.first.blockHeight, b.first.txindex);
+            });
+        size_t nKeep = std::min(limit, addressIndex.size());
+        while (nKeep < addressIndex.size() && addressIndex[nKeep].first.blockHeight == addressIndex[nKeep - 1].first.blockHeight &&
+               addressIndex[nKeep].first.txindex == addressIndex[nKeep - 1].first.txindex) {
+            nKeep++;
+        }
+        fMore |= nKeep < addressIndex.size();
+        addressIndex.resize(nKeep);
+    }
+
     UniValue result(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
@@ -952,6 +1014,20 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         result.push_back(delta);
     }
 
+    if (limit > 0) {
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("deltas", result));
+        if (fMore && !addressIndex.empty()) {
+            UniValue cursor(UniValue::VOBJ);
+            cursor.push_back(Pair("height", addressIndex.back().first.blockHeight));
+            cursor.push_back(Pair("blockindex", (int)addressIndex.back().first.txindex + 1));
+            page.push_back(Pair("cursor", cursor));
+        } else {
+            page.push_back(Pair("cursor", NullUniValue));
+        }
+        return page;
+    }
+
     return result;
 }
 
@@ -973,6 +1049,8 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
                         "{\n"
                         "  \"balance\"  (string) The current balance in duffs\n"
                         "  \"received\"  (string) The total number of duffs received (including change)\n"
+                        "  \"txcount\"  (number) The number of transactions, counted for every address they involve\n"
+                        "  \"utxocount\"  (number) The number of unspent outputs\n"
                         "}\n"
                         "\nExamples:\n"
                 + HelpExampleCli("getaddressbalance", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
@@ -985,27 +1063,21 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    CAddressBalance total;
 
     for (std::vector<std::pair<uint160, AddressType> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+        CAddressBalance balance;
+        if (!GetAddressBalance((*it).first, (*it).second, balance)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-    }
-
-    CAmount balance = 0;
-    CAmount received = 0;
-
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
-        }
-        balance += it->second;
+        total += balance;
     }
 
     UniValue result(UniValue::VOBJ);
-    result.push_back(Pair("balance", balance));
-    result.push_back(Pair("received", received));
+    result.push_back(Pair("balance", total.balance));
+    result.push_back(Pair("received", total.received));
+    result.push_back(Pair("txcount", total.txCount));
+    result.push_back(Pair("utxocount", total.utxoCount));
 
     return result;
 
@@ -1085,7 +1157,7 @@ UniValue getanonymityset(const JSONRPCRequest& request)
         i++;
     }
 
-    ret.push_back(Pair("blockHash", EncodeBase64(blockHash.begin(), blockHash.size())));
+    ret.push_back(Pair("blockHash", blockHash.GetHex()));
     ret.push_back(Pair("setHash", UniValue(EncodeBase64(setHash.data(), setHash.size()))));
     ret.push_back(Pair("coins", mints));
 
@@ -1162,7 +1234,7 @@ UniValue getusedcoinserials(const JSONRPCRequest& request)
     }
 
     lelantus::CLelantusState* lelantusState = lelantus::CLelantusState::GetState();
-    std::unordered_map<Scalar, int>  serials;
+    lelantus::UsedSerialSet serials;
     {
         LOCK(cs_main);
         serials = lelantusState->GetSpends();
@@ -1170,14 +1242,11 @@ UniValue getusedcoinserials(const JSONRPCRequest& request)
 
     UniValue serializedSerials(UniValue::VARR);
     int i = 0;
-    for ( auto it = serials.begin(); it != serials.end(); ++it, ++i) {
-        if ((serials.size() - i - 1) < startNumber)
-            continue;
-        std::vector<unsigned char> serialized;
-        serialized.resize(32);
-        it->first.serialize(serialized.data());
-        serializedSerials.push_back(EncodeBase64(serialized.data(), 32));
-    }
+    serials.ForEachSerialized([&](const lelantus::UsedSerialSet::SerializedTag& serialized, int) {
+        if ((serials.size() - i++ - 1) < startNumber)
+            return;
+        serializedSerials.push_back(EncodeBase64(serialized.data(), serialized.size()));
+    });
 
     UniValue ret(UniValue::VOBJ);
     ret.push_back(Pair("serials", serializedSerials));
@@ -1245,7 +1314,7 @@ UniValue getsparkanonymityset(const JSONRPCRequest& request)
                 "{\n"
                 "  \"blockHash\"   (string) Latest block hash for anonymity set\n"
                 "  \"setHash\"   (string) Anonymity set hash\n"
-                "  \"mints\" (Pair<string, string>) Serialized Spark coin paired with txhash\n"
+                "  \"coins\" (Array) Serialized Spark coins, each with its txhash and serial context\n"
                 "}\n"
                 + HelpExampleCli("getsparkanonymityset", "\"1\" " "\"ca511f07489e35c9bc60ca62c82de225ba7aae7811ce4c090f95aa976639dc4e\"")
                 + HelpExampleRpc("getsparkanonymityset", "\"1\" " "\"ca511f07489e35c9bc60ca62c82de225ba7aae7811ce4c090f95aa976639dc4e\"")
@@ -1266,43 +1335,151 @@ UniValue getsparkanonymityset(const JSONRPCRequest& request)
     }
 
     uint256 blockHash;
-    std::vector<std::pair<spark::Coin, std::pair<uint256, std::vector<unsigned char>>>> coins;
+    std::vector<spark::CSparkSectorCache::SectorPtr> sectors;
     std::vector<unsigned char> setHash;
 
     {
         LOCK(cs_main);
-        spark::CSparkState* sparkState = spark::CSparkState::GetState();
-        sparkState->GetCoinsForRecovery(
+        spark::CSparkSectorCache::GetCache()->GetAnonymitySet(
                 &chainActive,
                 chainActive.Height() - (ZC_MINT_CONFIRMATIONS - 1),
                 coinGroupId,
                 startBlockHash,
                 blockHash,
-                coins,
-                setHash);
+                setHash,
+                sectors);
     }
 
     UniValue ret(UniValue::VOBJ);
-    UniValue mints(UniValue::VARR);
+    ret.push_back(Pair("blockHash", blockHash.GetHex()));
+    ret.push_back(Pair("setHash", UniValue(EncodeBase64(setHash.data(), setHash.size()))));
+    ret.push_back(Pair("coins", spark::CSparkSectorCache::SectorsToUniValue(sectors)));
 
-    for (const auto& coin : coins) {
-        CDataStream serializedCoin(SER_NETWORK, PROTOCOL_VERSION);
-        serializedCoin << coin;
-        std::vector<unsigned char> vch(serializedCoin.begin(), serializedCoin.end());
+    return ret;
+}
 
-        std::vector<UniValue> data;
-        data.push_back(EncodeBase64(vch.data(), size_t(vch.size()))); // coin
-        data.push_back(EncodeBase64(coin.second.first.begin(), coin.second.first.size())); // tx hash
-        data.push_back(EncodeBase64(coin.second.second.data(), coin.second.second.size())); // spark serial context
+UniValue getsparkanonymitysetmeta(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+                "getsparkanonymitysetmeta\n"
+                "\nReturns the latest block hash, set hash and size of the anonymity set.\n"
+                "\nArguments:\n"
+                "{\n"
+                "      \"coinGroupId\"  (int)\n"
+                "}\n"
+                "\nResult:\n"
+                "{\n"
+                "  \"blockHash\"   (string) Latest block hash for anonymity set, in hex\n"
+                "  \"setHash\"   (string) Anonymity set hash\n"
+                "  \"size\" (int) Number of coins in the set\n"
+                "}\n"
+                + HelpExampleCli("getsparkanonymitysetmeta", "\"1\"")
+                + HelpExampleRpc("getsparkanonymitysetmeta", "\"1\"")
+        );
 
-        UniValue entity(UniValue::VARR);
-        entity.push_backV(data);
-        mints.push_back(entity);
+    int coinGroupId;
+    try {
+        coinGroupId = std::stol(request.params[0].get_str());
+    } catch (std::logic_error const & e) {
+        throw std::runtime_error(std::string("An exception occurred while parsing parameters: ") + e.what());
+    }
+
+    if(!GetBoolArg("-mobile", false)){
+        throw std::runtime_error(std::string("Please rerun Firo with -mobile "));
+    }
+
+    uint256 blockHash;
+    std::vector<unsigned char> setHash;
+    size_t size = 0;
+
+    {
+        LOCK(cs_main);
+        spark::CSparkState* sparkState = spark::CSparkState::GetState();
+        sparkState->GetAnonSetMetaData(
+                &chainActive,
+                chainActive.Height() - (ZC_MINT_CONFIRMATIONS - 1),
+                coinGroupId,
+                "",
+                blockHash,
+                setHash,
+                size);
     }
 
-    ret.push_back(Pair("blockHash", EncodeBase64(blockHash.begin(), blockHash.size())));
+    UniValue ret(UniValue::VOBJ);
+    // hex, so it can be passed to getsparkanonymitysetsector as it is
+    ret.push_back(Pair("blockHash", blockHash.GetHex()));
     ret.push_back(Pair("setHash", UniValue(EncodeBase64(setHash.data(), setHash.size()))));
-    ret.push_back(Pair("coins", mints));
+    ret.push_back(Pair("size", (uint64_t)size));
+
+    return ret;
+}
+
+UniValue getsparkanonymitysetsector(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 4)
+        throw std::runtime_error(
+                "getsparkanonymitysetsector\n"
+                "\nReturns a sector of the anonymity set as it was at the given block.\n"
+                "\nArguments:\n"
+                "{\n"
+                "      \"coinGroupId\"  (int)\n"
+                "      \"latestBlock\"    (string) Block hash returned by getsparkanonymitysetmeta\n"
+                "      \"startIndex\"    (int) Index of the first coin to return\n"
+                "      \"endIndex\"    (int) Index past the last coin to return, at most " + std::to_string(MAX_SPARK_SECTOR_COINS) + " after startIndex\n"
+                "}\n"
+                "\nResult:\n"
+                "{\n"
+                "  \"coins\" (Array) Serialized Spark coins, each with its txhash and serial context\n"
+                "}\n"
+                + HelpExampleCli("getsparkanonymitysetsector", "\"1\" " "\"ca511f07489e35c9bc60ca62c82de225ba7aae7811ce4c090f95aa976639dc4e\" " "\"0\" " "\"1000\"")
+                + HelpExampleRpc("getsparkanonymitysetsector", "\"1\", " "\"ca511f07489e35c9bc60ca62c82de225ba7aae7811ce4c090f95aa976639dc4e\", " "\"0\", " "\"1000\"")
+        );
+
+    int coinGroupId;
+    uint256 latestBlock;
+    int startIndex;
+    int endIndex;
+    try {
+        coinGroupId = std::stol(request.params[0].get_str());
+        startIndex = std::stol(request.params[2].get_str());
+        endIndex = std::stol(request.params[3].get_str());
+    } catch (std::logic_error const & e) {
+        throw std::runtime_error(std::string("An exception occurred while parsing parameters: ") + e.what());
+    }
+    latestBlock = ParseHashV(request.params[1], "latestBlock");
+
+    if (startIndex < 0 || endIndex < startIndex)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid sector range");
+    if (endIndex - startIndex > MAX_SPARK_SECTOR_COINS)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Sector size is limited to %d coins", MAX_SPARK_SECTOR_COINS));
+
+    if(!GetBoolArg("-mobile", false)){
+        throw std::runtime_error(std::string("Please rerun Firo with -mobile "));
+    }
+
+    std::vector<std::pair<spark::Coin, std::pair<uint256, std::vector<unsigned char>>>> coins;
+
+    {
+        LOCK(cs_main);
+        spark::CSparkState* sparkState = spark::CSparkState::GetState();
+        sparkState->GetCoinsForRecovery(
+                &chainActive,
+                coinGroupId,
+                latestBlock,
+                "",
+                startIndex,
+                endIndex,
+                coins);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    UniValue coinsArr(UniValue::VARR);
+
+    for (const auto& coin : coins)
+        coinsArr.push_back(spark::RecoveryCoinToUniValue(coin));
+
+    ret.push_back(Pair("coins", coinsArr));
 
     return ret;
 }
@@ -1381,21 +1558,13 @@ UniValue getusedcoinstags(const JSONRPCRequest& request)
         throw std::runtime_error(std::string("An exception occurred while parsing parameters: ") + e.what());
     }
 
-    spark::CSparkState* sparkState =  spark::CSparkState::GetState();
-    std::unordered_map<GroupElement, int, spark::CLTagHash>  tags;
-    {
-        LOCK(cs_main);
-        tags = sparkState->GetSpends();
-    }
+    spark::CSparkSectorCache::EncodedTagsPtr tags = spark::CSparkSectorCache::GetCache()->GetUsedLTags(false);
     UniValue serializedTags(UniValue::VARR);
     int i = 0;
-    for ( auto it = tags.begin(); it != tags.end(); ++it, ++i) {
-        if ((tags.size() - i - 1) < startNumber)
+    for ( auto it = tags->begin(); it != tags->end(); ++it, ++i) {
+        if ((tags->size() - i - 1) < startNumber)
             continue;
-        std::vector<unsigned char> serialized;
-        serialized.resize(34);
-        it->first.serialize(serialized.data());
-        serializedTags.push_back(EncodeBase64(serialized.data(), 34));
+        serializedTags.push_back(*it);
     }
 
     UniValue ret(UniValue::VOBJ);
@@ -1427,32 +1596,13 @@ UniValue getusedcoinstagstxhashes(const JSONRPCRequest& request)
         throw std::runtime_error(std::string("An exception occurred while parsing parameters: ") + e.what());
     }
 
-    spark::CSparkState* sparkState =  spark::CSparkState::GetState();
-    std::unordered_map<GroupElement, int, spark::CLTagHash>  tags;
-    std::unordered_map<uint256, uint256> ltagTxhash;
-    {
-        LOCK(cs_main);
-        tags = sparkState->GetSpends();
-        ltagTxhash = sparkState->GetSpendTxIds();
-    }
+    spark::CSparkSectorCache::EncodedTagsPtr tagsTxIds = spark::CSparkSectorCache::GetCache()->GetUsedLTags(true);
     UniValue serializedTagsTxIds(UniValue::VARR);
     int i = 0;
-    for ( auto it = tags.begin(); it != tags.end(); ++it, ++i) {
-        if ((tags.size() - i - 1) < startNumber)
+    for ( auto it = tagsTxIds->begin(); it != tagsTxIds->end(); ++it, ++i) {
+        if ((tagsTxIds->size() - i - 1) < startNumber)
             continue;
-        std::vector<unsigned char> serialized;
-        serialized.resize(34);
-        it->first.serialize(serialized.data());
-        std::vector<UniValue> data;
-        data.push_back(EncodeBase64(serialized.data(), 34));
-        uint256 txid;
-        uint256 ltagHash = primitives::GetLTagHash(it->first);
-        if (ltagTxhash.count(ltagHash) > 0)
-            txid = ltagTxhash[ltagHash];
-        data.push_back(EncodeBase64(txid.begin(), txid.size()));
-        UniValue entity(UniValue::VARR);
-        entity.push_backV(data);
-        serializedTagsTxIds.push_back(entity);
+        serializedTagsTxIds.push_back(*it);
     }
 
     UniValue ret(UniValue::VOBJ);
@@ -1461,6 +1611,109 @@ UniValue getusedcoinstagstxhashes(const JSONRPCRequest& request)
     return ret;
 }
 
+// Collects the linking tags spent in the active chain blocks [startHeight, endHeight], serialized the way
+// getusedcoinstags sends them. Returns the hash of the block at endHeight.
+static uint256 GetUsedLTagsInRange(const JSONRPCRequest& request, std::vector<std::vector<unsigned char>>& tags)
+{
+    int startHeight, endHeight;
+    try {
+        startHeight = std::stol(request.params[0].get_str());
+        endHeight = std::stol(request.params[1].get_str());
+    } catch (std::logic_error const & e) {
+        throw std::runtime_error(std::string("An exception occurred while parsing parameters: ") + e.what());
+    }
+
+    LOCK(cs_main);
+    if (startHeight < 0 || endHeight < startHeight || endHeight > chainActive.Height())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Block range out of range");
+    if (endHeight - startHeight >= MAX_USED_LTAGS_RANGE)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block range is limited to %d blocks", MAX_USED_LTAGS_RANGE));
+
+    std::vector<unsigned char> serialized(34);
+    for (int height = startHeight; height <= endHeight; ++height) {
+        for (const auto& lTag : chainActive[height]->spentLTags) {
+            lTag.first.serialize(serialized.data());
+            tags.push_back(serialized);
+        }
+    }
+    return chainActive[endHeight]->GetBlockHash();
+}
+
+UniValue getusedcoinstagsdelta(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 2)
+        throw std::runtime_error(
+                "getusedcoinstagsdelta\n"
+                "\nReturns the coin tags used in the given range of blocks.\n"
+                "\nArguments:\n"
+                "{\n"
+                "      \"startHeight\"  (int) First block of the range\n"
+                "      \"endHeight\"  (int) Last block of the range\n"
+                "}\n"
+                "\nResult:\n"
+                "{\n"
+                "  \"blockHash\"   (string) Hash of the last block of the range, to detect reorgs\n"
+                "  \"tags\" (std::string[]) array of Serialized GroupElements\n"
+                "}\n"
+                + HelpExampleCli("getusedcoinstagsdelta", "\"420000\" \"421000\"")
+                + HelpExampleRpc("getusedcoinstagsdelta", "\"420000\", \"421000\"")
+        );
+
+    std::vector<std::vector<unsigned char>> tags;
+    uint256 blockHash = GetUsedLTagsInRange(request, tags);
+
+    UniValue serializedTags(UniValue::VARR);
+    for (const auto& tag : tags)
+        serializedTags.push_back(EncodeBase64(tag.data(), tag.size()));
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("blockHash", blockHash.GetHex()));
+    ret.push_back(Pair("tags", serializedTags));
+
+    return ret;
+}
+
+UniValue getusedcoinstagsfilter(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 2)
+        throw std::runtime_error(
+                "getusedcoinstagsfilter\n"
+                "\nReturns a Golomb-coded set (BIP 158 encoding) of the coin tags used in the given range of blocks.\n"
+                "The SipHash key is the first 16 bytes of the block hash in internal (little-endian) byte order,\n"
+                "elements are the serialized tags,\n"
+                "P = " + std::to_string(USED_LTAGS_FILTER_P) + " and M = " + std::to_string(USED_LTAGS_FILTER_M) + ".\n"
+                "Fetch the exact tags with getusedcoinstagsdelta only for ranges whose filter matches.\n"
+                "\nArguments:\n"
+                "{\n"
+                "      \"startHeight\"  (int) First block of the range\n"
+                "      \"endHeight\"  (int) Last block of the range\n"
+                "}\n"
+                "\nResult:\n"
+                "{\n"
+                "  \"blockHash\"   (string) Hash of the last block of the range\n"
+                "  \"n\"   (int) Number of tags in the filter\n"
+                "  \"filter\" (string) Encoded filter\n"
+                "}\n"
+                + HelpExampleCli("getusedcoinstagsfilter", "\"420000\" \"421000\"")
+                + HelpExampleRpc("getusedcoinstagsfilter", "\"420000\", \"421000\"")
+        );
+
+    std::vector<std::vector<unsigned char>> tags;
+    uint256 blockHash = GetUsedLTagsInRange(request, tags);
+
+    GCSFilter::Params params(ReadLE64(blockHash.begin()), ReadLE64(blockHash.begin() + 8),
+                             USED_LTAGS_FILTER_P, USED_LTAGS_FILTER_M);
+    GCSFilter filter(params, GCSFilter::ElementSet(tags.begin(), tags.end()));
+    const std::vector<unsigned char>& encoded = filter.GetEncoded();
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("blockHash", blockHash.GetHex()));
+    ret.push_back(Pair("n", (uint64_t)filter.GetN()));
+    ret.push_back(Pair("filter", EncodeBase64(encoded.data(), encoded.size())));
+
+    return ret;
+}
+
 UniValue getsparklatestcoinid(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -1778,7 +2031,7 @@ UniValue gettotalsupply(const JSONRPCRequest& request)
     CAmount total = 0;
 
     if(!pblocktree->ReadTotalSupply(total))
-        throw JSONRPCError(RPC_DATABASE_ERROR, "Cannot read the total supply from the database. This functionality requires -addressindex to be enabled. Enabling -addressindex requires reindexing.");
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Cannot read the total supply from the database. This functionality requires -addressindex to be enabled. When -addressindex is enabled on a synced node the index is built in the background first.");
 
     UniValue result(UniValue::VOBJ);
     result.push_back(Pair("total", total));
@@ -1921,9 +2174,13 @@ static const CRPCCommand commands[] =
 
         /* Mobile Spark */
     { "mobile",             "getsparkanonymityset",   &getsparkanonymityset, false },
+    { "mobile",             "getsparkanonymitysetmeta", &getsparkanonymitysetmeta, false },
+    { "mobile",             "getsparkanonymitysetsector", &getsparkanonymitysetsector, false },
     { "mobile",             "getsparkmintmetadata",   &getsparkmintmetadata, true  },
     { "mobile",             "getusedcoinstags",       &getusedcoinstags,     false },
     { "mobile",             "getusedcoinstagstxhashes", &getusedcoinstagstxhashes, false },
+    { "mobile",             "getusedcoinstagsdelta",  &getusedcoinstagsdelta, false },
+    { "mobile",             "getusedcoinstagsfilter", &getusedcoinstagsfilter, false },
     { "mobile",             "getsparklatestcoinid",   &getsparklatestcoinid, true  },
     { "mobile",             "getmempoolsparktxids",   &getmempoolsparktxids, true },
     { "mobile",             "getmempoolsparktxs",     &getmempoolsparktxs,       true  },
@@ -11,6 +11,7 @@
 #include "llmq/quorums_debug.h"
 #include "llmq/quorums_dkgsession.h"
 #include "llmq/quorums_signing.h"
+#include "llmq/quorums_signing_shares.h"
 
 void quorum_list_help()
 {
@@ -340,6 +341,38 @@ UniValue quorum_sigs_cmd(const JSONRPCRequest& request)
     }
 }
 
+void quorum_sigsharesstats_help()
+{
+    throw std::runtime_error(
+            "quorum sigsharesstats\n"
+            "Return queue depth and latency of signature share verification and recovery.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"pendingSigShares\": n,      (numeric) Received shares waiting for verification\n"
+            "  \"sigShares\": n,             (numeric) Verified shares of sessions that are not recovered yet\n"
+            "  \"signSessions\": n,          (numeric) Active signing sessions\n"
+            "  \"verifyRounds\": n,          (numeric) Verification rounds since startup\n"
+            "  \"verifiedSigShares\": n,     (numeric) Shares verified since startup\n"
+            "  \"avgVerifyTime\": n,         (numeric) Average time of a verification round in microseconds\n"
+            "  \"lastVerifyTime\": n,        (numeric) Time of the last verification round in microseconds\n"
+            "  \"recoveredSigs\": n,         (numeric) Signatures recovered since startup\n"
+            "  \"avgRecoveryTime\": n,       (numeric) Average time of a recovery in microseconds\n"
+            "  \"lastRecoveryTime\": n       (numeric) Time of the last recovery in microseconds\n"
+            "}\n"
+    );
+}
+
+UniValue quorum_sigsharesstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        quorum_sigsharesstats_help();
+    }
+
+    llmq::CSigSharesStats stats;
+    llmq::quorumSigSharesManager->GetStats(stats);
+    return stats.ToJson();
+}
+
 void quorum_dkgsimerror_help()
 {
     throw std::runtime_error(
@@ -390,6 +423,7 @@ UniValue quorum_dkgsimerror(const JSONRPCRequest& request)
             "  hasrecsig         - Test if a valid recovered signature is present\n"
             "  getrecsig         - Get a recovered signature\n"
             "  isconflicting     - Test if a conflict exists\n"
+            "  sigsharesstats    - Return signature share verification and recovery metrics\n"
     );
 }
 
@@ -416,6 +450,8 @@ UniValue quorum(const JSONRPCRequest& request)
         return quorum_sigs_cmd(request);
     } else if (command == "dkgsimerror") {
         return quorum_dkgsimerror(request);
+    } else if (command == "sigsharesstats") {
+        return quorum_sigsharesstats(request);
     } else {
         quorum_help();
     }
@@ -31,6 +31,10 @@ namespace sigma {
 
 static CSigmaState sigmaState;
 
+static boost::filesystem::path GetFrozenStatePath() {
+    return GetDataDir() / "sigma_frozen.dat";
+}
+
 bool CheckSigmaSpendSerial(
         CValidationState &state,
         CSigmaTxInfo *sigmaTxInfo,
@@ -660,6 +664,9 @@ bool ConnectBlockSigma(
     else if (!fJustCheck) { // TODO(martun): not sure if this else is necessary here. Check again later.
         sigmaState.AddBlock(pindexNew);
     }
+
+    if (!fJustCheck && pindexNew->nHeight == chainparams.GetConsensus().nLelantusGracefulPeriod + SIGMA_FREEZE_DEPTH)
+        sigmaState.FreezeIfFinal(pindexNew);
     return true;
 }
 
@@ -750,6 +757,7 @@ bool GetOutPoint(COutPoint& outPoint, const uint256 &pubCoinValueHash) {
 }
 
 bool BuildSigmaStateFromIndex(CChain *chain) {
+    sigmaState.LoadFrozenState(chain);
     for (CBlockIndex *blockIndex = chain->Genesis(); blockIndex; blockIndex=chain->Next(blockIndex))
     {
         sigmaState.AddBlock(blockIndex);
@@ -762,6 +770,8 @@ bool BuildSigmaStateFromIndex(CChain *chain) {
         sigmaState.GetLatestCoinID(CoinDenomination::SIGMA_DENOM_1),
         sigmaState.GetLatestCoinID(CoinDenomination::SIGMA_DENOM_10),
         sigmaState.GetLatestCoinID(CoinDenomination::SIGMA_DENOM_100));
+    if (chain->Tip())
+        sigmaState.FreezeIfFinal(chain->Tip());
     return true;
 }
 
@@ -790,8 +800,9 @@ CSigmaState::Containers::Containers(std::atomic<bool> & surgeCondition)
 : surgeCondition(surgeCondition)
 {}
 
-void CSigmaState::Containers::AddMint(sigma::PublicCoin const & pubCoin, CMintedCoinInfo const & coinInfo) {
-    mintedPubCoins.insert(std::make_pair(pubCoin, coinInfo));
+void CSigmaState::Containers::AddMint(sigma::PublicCoin const & pubCoin, CMintedCoinInfo const & coinInfo, bool fFrozen) {
+    if (!fFrozen)
+        mintedPubCoins.insert(std::make_pair(pubCoin, coinInfo));
     mintMetaInfo[coinInfo.coinGroupId][coinInfo.denomination] += 1;
     CheckSurgeCondition(coinInfo.coinGroupId, coinInfo.denomination);
 }
@@ -806,8 +817,9 @@ void CSigmaState::Containers::RemoveMint(sigma::PublicCoin const & pubCoin) {
     }
 }
 
-void CSigmaState::Containers::AddSpend(Scalar const & serial, CSpendCoinInfo const & coinInfo) {
-    usedCoinSerials[serial] = coinInfo;
+void CSigmaState::Containers::AddSpend(Scalar const & serial, CSpendCoinInfo const & coinInfo, bool fFrozen) {
+    if (!fFrozen)
+        usedCoinSerials[serial] = coinInfo;
     spendMetaInfo[coinInfo.coinGroupId][coinInfo.denomination] += 1;
     CheckSurgeCondition(coinInfo.coinGroupId, coinInfo.denomination);
 }
@@ -822,10 +834,59 @@ void CSigmaState::Containers::RemoveSpend(Scalar const & serial) {
     }
 }
 
+bool CSigmaState::Containers::FindMint(sigma::PublicCoin const & pubCoin, CMintedCoinInfo & coinInfo) const {
+    mint_info_container::const_iterator iter = mintedPubCoins.find(pubCoin);
+    if (iter != mintedPubCoins.end()) {
+        coinInfo = iter->second;
+        return true;
+    }
+    return frozenState && frozenState->FindMint(pubCoin, coinInfo);
+}
+
+bool CSigmaState::Containers::HasSpend(Scalar const & serial) const {
+    if (usedCoinSerials.count(serial) != 0)
+        return true;
+    CSpendCoinInfo coinInfo;
+    return frozenState && frozenState->FindSpend(serial, coinInfo);
+}
+
+void CSigmaState::Containers::Freeze(std::unique_ptr<CSigmaFrozenState> frozenStateIn) {
+    frozenState = std::move(frozenStateIn);
+    // swapped with empty maps, clear() would keep the buckets
+    mint_info_container().swap(mintedPubCoins);
+    spend_info_container().swap(usedCoinSerials);
+}
+
+void CSigmaState::Containers::Thaw() {
+    if (!frozenState)
+        return;
+    mintedPubCoins.reserve(mintedPubCoins.size() + frozenState->GetMintCount());
+    frozenState->ForEachMint([this](const sigma::PublicCoin& pubCoin, const CMintedCoinInfo& coinInfo) {
+        mintedPubCoins.insert(std::make_pair(pubCoin, coinInfo));
+    });
+    usedCoinSerials.reserve(usedCoinSerials.size() + frozenState->GetSpendCount());
+    frozenState->ForEachSpend([this](const Scalar& serial, const CSpendCoinInfo& coinInfo) {
+        usedCoinSerials[serial] = coinInfo;
+    });
+    frozenState.reset();
+}
+
+CSigmaFrozenState const * CSigmaState::Containers::GetFrozenState() const {
+    return frozenState.get();
+}
+
+bool CSigmaState::Containers::IsFrozen(int nHeight) const {
+    return frozenState && nHeight <= frozenState->GetHeight();
+}
+
 mint_info_container const & CSigmaState::Containers::GetMints() const {
     return mintedPubCoins;
 }
 
+std::size_t CSigmaState::Containers::GetMintCount() const {
+    return mintedPubCoins.size() + (frozenState ? frozenState->GetMintCount() : 0);
+}
+
 spend_info_container const & CSigmaState::Containers::GetSpends() const {
     return usedCoinSerials;
 }
@@ -837,6 +898,7 @@ bool CSigmaState::Containers::IsSurgeCondition() const {
 void CSigmaState::Containers::Reset() {
     mintedPubCoins.clear();
     usedCoinSerials.clear();
+    frozenState.reset();
     mintMetaInfo.clear();
     spendMetaInfo.clear();
     surgeCondition = false;
@@ -928,6 +990,7 @@ void CSigmaState::AddSpend(const Scalar &serial, CoinDenomination denom, int coi
 }
 
 void CSigmaState::AddBlock(CBlockIndex *index) {
+    bool fFrozen = containers.IsFrozen(index->nHeight);
     BOOST_FOREACH(
         const PAIRTYPE(PAIRTYPE(sigma::CoinDenomination, int), std::vector<sigma::PublicCoin>) &pubCoins,
             index->sigmaMintedPubCoins) {
@@ -944,16 +1007,23 @@ void CSigmaState::AddBlock(CBlockIndex *index) {
 
         latestCoinIds[pubCoins.first.first] = pubCoins.first.second;
         BOOST_FOREACH(const sigma::PublicCoin &coin, pubCoins.second) {
-            containers.AddMint(coin, CMintedCoinInfo::make(pubCoins.first.first, pubCoins.first.second, index->nHeight));
+            containers.AddMint(coin, CMintedCoinInfo::make(pubCoins.first.first, pubCoins.first.second, index->nHeight), fFrozen);
         }
     }
 
     BOOST_FOREACH(const spend_info_container::value_type &serial, index->sigmaSpentSerials) {
-        AddSpend(serial.first, serial.second.denomination, serial.second.coinGroupId);
+        containers.AddSpend(serial.first, CSpendCoinInfo::make(serial.second.denomination, serial.second.coinGroupId), fFrozen);
     }
 }
 
 void CSigmaState::RemoveBlock(CBlockIndex *index) {
+    // the coins have to be in the maps to be rolled back
+    if (containers.IsFrozen(index->nHeight) || (containers.GetFrozenState() &&
+            (!index->sigmaMintedPubCoins.empty() || !index->sigmaSpentSerials.empty()))) {
+        LogPrintf("RemoveBlock: disconnecting block %d, moving the frozen sigma state back to memory\n", index->nHeight);
+        containers.Thaw();
+    }
+
     // roll back accumulator updates
     BOOST_FOREACH(
         const PAIRTYPE(PAIRTYPE(sigma::CoinDenomination, int),std::vector<sigma::PublicCoin>) &coin,
@@ -1010,6 +1080,49 @@ void CSigmaState::RemoveBlock(CBlockIndex *index) {
     }
 }
 
+bool CSigmaState::LoadFrozenState(CChain *chain) {
+    int nFreezeHeight = ::Params().GetConsensus().nLelantusGracefulPeriod;
+    if (chain->Height() < nFreezeHeight + SIGMA_FREEZE_DEPTH)
+        return false;
+
+    std::unique_ptr<CSigmaFrozenState> frozenState = CSigmaFrozenState::Open(GetFrozenStatePath());
+    if (!frozenState)
+        return false;
+    if (frozenState->GetHeight() != nFreezeHeight || (*chain)[nFreezeHeight]->GetBlockHash() != frozenState->GetBlockHash()) {
+        LogPrintf("LoadFrozenState: the frozen sigma state is not of the active chain, ignoring it\n");
+        return false;
+    }
+
+    LogPrintf("LoadFrozenState: loaded %d sigma mints and %d spends\n", frozenState->GetMintCount(), frozenState->GetSpendCount());
+    containers.Freeze(std::move(frozenState));
+    return true;
+}
+
+void CSigmaState::FreezeIfFinal(const CBlockIndex *tip) {
+    int nFreezeHeight = ::Params().GetConsensus().nLelantusGracefulPeriod;
+    if (containers.GetFrozenState() || tip->nHeight < nFreezeHeight + SIGMA_FREEZE_DEPTH)
+        return;
+
+    // no sigma mint or spend can be in a block past nLelantusGracefulPeriod
+    boost::filesystem::path path = GetFrozenStatePath();
+    if (!CSigmaFrozenState::Write(path, GetUnfrozenMints(), GetUnfrozenSpends(), nFreezeHeight, tip->GetAncestor(nFreezeHeight)->GetBlockHash())) {
+        error("FreezeIfFinal: failed to write the frozen sigma state, keeping it in memory");
+        return;
+    }
+    std::unique_ptr<CSigmaFrozenState> frozenState = CSigmaFrozenState::Open(path);
+    if (!frozenState) {
+        error("FreezeIfFinal: failed to open the frozen sigma state, keeping it in memory");
+        return;
+    }
+
+    LogPrintf("FreezeIfFinal: froze %d sigma mints and %d spends\n", frozenState->GetMintCount(), frozenState->GetSpendCount());
+    containers.Freeze(std::move(frozenState));
+}
+
+bool CSigmaState::IsFrozen() const {
+    return containers.GetFrozenState() != nullptr;
+}
+
 bool CSigmaState::GetCoinGroupInfo(
         sigma::CoinDenomination denomination,
         int group_id,
@@ -1024,11 +1137,14 @@ bool CSigmaState::GetCoinGroupInfo(
 }
 
 bool CSigmaState::IsUsedCoinSerial(const Scalar &coinSerial) {
-    return containers.GetSpends().count(coinSerial) != 0;
+    return containers.HasSpend(coinSerial);
 }
 
 bool CSigmaState::IsUsedCoinSerialHash(Scalar &coinSerial, const uint256 &coinSerialHash) {
-    for ( auto it = GetSpends().begin(); it != GetSpends().end(); ++it ){
+    const CSigmaFrozenState *frozenState = containers.GetFrozenState();
+    if (frozenState && frozenState->FindSpendByHash(coinSerial, coinSerialHash))
+        return true;
+    for ( auto it = GetUnfrozenSpends().begin(); it != GetUnfrozenSpends().end(); ++it ){
         if(primitives::GetSerialHash(it->first)==coinSerialHash){
             coinSerial = it->first;
             return true;
@@ -1038,11 +1154,15 @@ bool CSigmaState::IsUsedCoinSerialHash(Scalar &coinSerial, const uint256 &coinSe
 }
 
 bool CSigmaState::HasCoin(const sigma::PublicCoin& pubCoin) {
-    return containers.GetMints().find(pubCoin) != containers.GetMints().end();
+    CMintedCoinInfo coinInfo;
+    return containers.FindMint(pubCoin, coinInfo);
 }
 
 bool CSigmaState::HasCoinHash(GroupElement &pubCoinValue, const uint256 &pubCoinValueHash) {
-    for ( auto it = GetMints().begin(); it != GetMints().end(); ++it ){
+    const CSigmaFrozenState *frozenState = containers.GetFrozenState();
+    if (frozenState && frozenState->FindMintByHash(pubCoinValue, pubCoinValueHash))
+        return true;
+    for ( auto it = GetUnfrozenMints().begin(); it != GetUnfrozenMints().end(); ++it ){
         const sigma::PublicCoin & pubCoin = (*it).first;
         if(pubCoin.getValueHash()==pubCoinValueHash){
             pubCoinValue = pubCoin.getValue();
@@ -1052,6 +1172,29 @@ bool CSigmaState::HasCoinHash(GroupElement &pubCoinValue, const uint256 &pubCoin
     return false;
 }
 
+void CSigmaState::FindCoinHashes(const std::unordered_set<uint256>& pubCoinValueHashes, std::unordered_map<uint256, GroupElement>& pubCoinValues) {
+    if (pubCoinValueHashes.empty())
+        return;
+    if (const CSigmaFrozenState *frozenState = containers.GetFrozenState()) {
+        for (const uint256& pubCoinValueHash : pubCoinValueHashes) {
+            GroupElement pubCoinValue;
+            if (frozenState->FindMintByHash(pubCoinValue, pubCoinValueHash))
+                pubCoinValues.emplace(pubCoinValueHash, pubCoinValue);
+        }
+        if (pubCoinValues.size() == pubCoinValueHashes.size())
+            return;
+    }
+    for (const auto& mint : GetUnfrozenMints()) {
+        const sigma::PublicCoin& pubCoin = mint.first;
+        uint256 pubCoinValueHash = pubCoin.getValueHash();
+        if (pubCoinValueHashes.count(pubCoinValueHash)) {
+            pubCoinValues.emplace(pubCoinValueHash, pubCoin.getValue());
+            if (pubCoinValues.size() == pubCoinValueHashes.size())
+                return;
+        }
+    }
+}
+
 int CSigmaState::GetCoinSetForSpend(
         CChain *chain,
         int maxHeight,
@@ -1142,10 +1285,9 @@ void CSigmaState::GetAnonymitySet(
 
 std::pair<int, int> CSigmaState::GetMintedCoinHeightAndId(
         const sigma::PublicCoin& pubCoin) {
-    auto coinIt = containers.GetMints().find(pubCoin);
-
-    if (coinIt != containers.GetMints().end()) {
-        return std::make_pair(coinIt->second.nHeight, coinIt->second.coinGroupId);
+    CMintedCoinInfo coinInfo;
+    if (containers.FindMint(pubCoin, coinInfo)) {
+        return std::make_pair(coinInfo.nHeight, coinInfo.coinGroupId);
     }
     return std::make_pair(-1, -1);
 }
@@ -1223,11 +1365,11 @@ bool CSigmaState::IsSurgeConditionDetected() const {
     return surgeCondition;
 }
 
-mint_info_container const & CSigmaState::GetMints() const {
+mint_info_container const & CSigmaState::GetUnfrozenMints() const {
     return containers.GetMints();
 }
 
-spend_info_container const & CSigmaState::GetSpends() const {
+spend_info_container const & CSigmaState::GetUnfrozenSpends() const {
     return containers.GetSpends();
 }
 
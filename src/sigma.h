@@ -12,7 +12,9 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 #include "coin_containers.h"
+#include "sigmafrozenstate.h"
 
 //tests
 namespace sigma_mintspend_many { class sigma_mintspend_many; }
@@ -22,6 +24,9 @@ namespace zerocoin_tests3_v3 { class zerocoin_mintspend_v3; }
 
 namespace sigma {
 
+// Blocks the chain has to be past the end of Sigma before its mints and serials are frozen
+static const int SIGMA_FREEZE_DEPTH = 100;
+
 // Sigma transaction info, added to the CBlock to ensure sigma mint/spend transactions got their info stored into
 // index
 class CSigmaTxInfo {
@@ -134,6 +139,12 @@ public:
     // Disconnect block from the chain rolling back mints and spends
     void RemoveBlock(CBlockIndex *index);
 
+    // Uses the frozen state written before if its block is on the chain. Has to be called before the blocks are added.
+    bool LoadFrozenState(CChain *chain);
+    // Moves the mints and spends to the frozen state once the tip is SIGMA_FREEZE_DEPTH blocks past the end of Sigma
+    void FreezeIfFinal(const CBlockIndex *tip);
+    bool IsFrozen() const;
+
     // Query coin group with given denomination and id
     bool GetCoinGroupInfo(sigma::CoinDenomination denomination,
         int group_id, SigmaCoinGroupInfo &result);
@@ -147,6 +158,8 @@ public:
     bool HasCoin(const sigma::PublicCoin& pubCoin);
     // Query if there is a coin with given hash of a pubCoin value. If so, store preimage in pubCoin param
     bool HasCoinHash(GroupElement &pubCoinValue, const uint256 &pubCoinValueHash);
+    // Looks up many pubCoin value hashes in one pass over the mints, found preimages are stored in pubCoinValues
+    void FindCoinHashes(const std::unordered_set<uint256>& pubCoinValueHashes, std::unordered_map<uint256, GroupElement>& pubCoinValues);
 
     // Given denomination and id returns latest accumulator value and corresponding block hash
     // Do not take into account coins with height more than maxHeight
@@ -200,13 +213,14 @@ public:
 
     int GetLatestCoinID(sigma::CoinDenomination denomination) const;
 
-    mint_info_container const & GetMints() const;
-    spend_info_container const & GetSpends() const;
+    // Only the mints and spends that aren't in the frozen state, all of them until the state is frozen
+    mint_info_container const & GetUnfrozenMints() const;
+    spend_info_container const & GetUnfrozenSpends() const;
     std::unordered_map<std::pair<CoinDenomination, int>, SigmaCoinGroupInfo, pairhash> const & GetCoinGroups() const ;
     std::unordered_map<CoinDenomination, int> const & GetLatestCoinIds() const;
     std::unordered_map<Scalar, uint256, sigma::CScalarHash> const & GetMempoolCoinSerials() const;
 
-    std::size_t GetTotalCoins() const { return GetMints().size(); }
+    std::size_t GetTotalCoins() const { return containers.GetMintCount(); }
 
     bool IsSurgeConditionDetected() const;
 
@@ -227,16 +241,29 @@ private:
     struct Containers {
         Containers(std::atomic<bool> & surgeCondition);
 
-        void AddMint(sigma::PublicCoin const & pubCoin, CMintedCoinInfo const & coinInfo);
+        // fFrozen adds a coin that is in the frozen state, it's only counted
+        void AddMint(sigma::PublicCoin const & pubCoin, CMintedCoinInfo const & coinInfo, bool fFrozen = false);
         void RemoveMint(sigma::PublicCoin const & pubCoin);
 
-        void AddSpend(Scalar const & serial, CSpendCoinInfo const & coinInfo);
+        void AddSpend(Scalar const & serial, CSpendCoinInfo const & coinInfo, bool fFrozen = false);
         void RemoveSpend(Scalar const & serial);
 
+        bool FindMint(sigma::PublicCoin const & pubCoin, CMintedCoinInfo & coinInfo) const;
+        bool HasSpend(Scalar const & serial) const;
+
+        // Drops the maps, their coins are looked up in the frozen state
+        void Freeze(std::unique_ptr<CSigmaFrozenState> frozenState);
+        // Moves the coins of the frozen state back to the maps
+        void Thaw();
+        CSigmaFrozenState const * GetFrozenState() const;
+        // Whether the coins of the block at nHeight are in the frozen state
+        bool IsFrozen(int nHeight) const;
+
         void Reset();
 
         mint_info_container const & GetMints() const;
         spend_info_container const & GetSpends() const;
+        std::size_t GetMintCount() const;
         bool IsSurgeCondition() const;
     private:
         // Set of all minted pubCoin values, keyed by the public coin.
@@ -244,6 +271,8 @@ private:
         mint_info_container mintedPubCoins;
         // Set of all used coin serials.
         spend_info_container usedCoinSerials;
+        // Mints and spends of the chain up to the end of Sigma, they aren't in the maps
+        std::unique_ptr<CSigmaFrozenState> frozenState;
 
         std::atomic<bool> & surgeCondition;
 
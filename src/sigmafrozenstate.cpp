@@ -0,0 +1,393 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sigmafrozenstate.h"
+
+#include "crypto/sha256.h"
+#include "primitives/mint_spend.h"
+#include "util.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sigma {
+
+static const char FROZEN_STATE_MAGIC[8] = {'F', 'I', 'R', 'O', 'S', 'G', 'M', 'A'};
+static const uint32_t FROZEN_STATE_VERSION = 1;
+// The lookup tables are indexed by the first two bytes of the keys
+static const uint32_t PREFIX_COUNT = 1 << 16;
+static const size_t PREFIX_TABLES = 4;
+
+// The file never leaves the node, so it is in native byte order
+struct CSigmaFrozenState::Header
+{
+    char magic[8];
+    uint32_t nVersion;
+    int32_t nHeight;
+    unsigned char blockHash[32];
+    uint64_t nMints;
+    uint64_t nSpends;
+    // of everything after the header
+    unsigned char checksum[CSHA256::OUTPUT_SIZE];
+};
+
+struct CSigmaFrozenState::MintRecord
+{
+    // serialized value followed by the denomination, like the public coin the mints are keyed by
+    unsigned char key[GroupElement::serialize_size + 1];
+    unsigned char padding[3];
+    int32_t coinGroupId;
+    int32_t nHeight;
+};
+
+struct CSigmaFrozenState::SpendRecord
+{
+    unsigned char key[32];
+    int32_t denomination;
+    int32_t coinGroupId;
+};
+
+struct CSigmaFrozenState::HashRecord
+{
+    unsigned char key[32];
+    // of the mint or spend record
+    uint32_t nIndex;
+};
+
+static_assert(Scalar::memoryRequired() == 32, "serials are stored in 32 bytes");
+
+template <typename Record>
+static uint32_t KeyPrefix(const Record& record)
+{
+    return (uint32_t(record.key[0]) << 8) | record.key[1];
+}
+
+template <typename Record>
+static bool KeyLess(const Record& a, const Record& b)
+{
+    return memcmp(a.key, b.key, sizeof(a.key)) < 0;
+}
+
+// prefixes[p] is the index of the first record with a prefix of at least p
+template <typename Record>
+static void BuildPrefixes(const std::vector<Record>& records, uint32_t* prefixes)
+{
+    size_t n = 0;
+    for (uint32_t nPrefix = 0; nPrefix <= PREFIX_COUNT; nPrefix++) {
+        while (n < records.size() && KeyPrefix(records[n]) < nPrefix)
+            n++;
+        prefixes[nPrefix] = n;
+    }
+}
+
+template <typename Record>
+static const Record* FindRecord(const Record* records, const uint32_t* prefixes, const Record& key)
+{
+    uint32_t nPrefix = KeyPrefix(key);
+    const Record* first = records + prefixes[nPrefix];
+    const Record* last = records + prefixes[nPrefix + 1];
+    const Record* it = std::lower_bound(first, last, key, KeyLess<Record>);
+    if (it == last || memcmp(it->key, key.key, sizeof(key.key)) != 0)
+        return nullptr;
+    return it;
+}
+
+template <typename Record>
+static void AppendRecords(std::vector<unsigned char>& body, const std::vector<Record>& records)
+{
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(records.data());
+    body.insert(body.end(), begin, begin + records.size() * sizeof(Record));
+}
+
+static size_t BodySize(uint64_t nMints, uint64_t nSpends, size_t nMintRecord, size_t nSpendRecord, size_t nHashRecord)
+{
+    return nMints * (nMintRecord + nHashRecord) + nSpends * (nSpendRecord + nHashRecord) +
+            PREFIX_TABLES * (PREFIX_COUNT + 1) * sizeof(uint32_t);
+}
+
+CSigmaFrozenState::CSigmaFrozenState() : data(nullptr), size(0), fMapped(false) {}
+
+CSigmaFrozenState::~CSigmaFrozenState()
+{
+#ifndef WIN32
+    if (fMapped)
+        munmap(const_cast<unsigned char*>(data), size);
+#endif
+}
+
+bool CSigmaFrozenState::Write(const boost::filesystem::path& path, const mint_info_container& mints,
+                              const spend_info_container& spends, int nHeight, const uint256& blockHash)
+{
+    // the hashes are computed before sorting, the records only keep the serialized values
+    std::vector<std::pair<MintRecord, uint256>> mintsWithHashes;
+    mintsWithHashes.reserve(mints.size());
+    for (const auto& mint : mints) {
+        MintRecord record;
+        memset(&record, 0, sizeof(record));
+        mint.first.getValue().serialize(record.key);
+        record.key[GroupElement::serialize_size] = static_cast<unsigned char>(mint.first.getDenomination());
+        record.coinGroupId = mint.second.coinGroupId;
+        record.nHeight = mint.second.nHeight;
+        mintsWithHashes.emplace_back(record, mint.first.getValueHash());
+    }
+    std::sort(mintsWithHashes.begin(), mintsWithHashes.end(),
+            [](const std::pair<MintRecord, uint256>& a, const std::pair<MintRecord, uint256>& b) {
+                return KeyLess(a.first, b.first);
+            });
+
+    std::vector<std::pair<SpendRecord, uint256>> spendsWithHashes;
+    spendsWithHashes.reserve(spends.size());
+    for (const auto& spend : spends) {
+        SpendRecord record;
+        memset(&record, 0, sizeof(record));
+        spend.first.serialize(record.key);
+        record.denomination = static_cast<int32_t>(spend.second.denomination);
+        record.coinGroupId = spend.second.coinGroupId;
+        spendsWithHashes.emplace_back(record, primitives::GetSerialHash(spend.first));
+    }
+    std::sort(spendsWithHashes.begin(), spendsWithHashes.end(),
+            [](const std::pair<SpendRecord, uint256>& a, const std::pair<SpendRecord, uint256>& b) {
+                return KeyLess(a.first, b.first);
+            });
+
+    std::vector<MintRecord> mintRecords;
+    std::vector<SpendRecord> spendRecords;
+    std::vector<HashRecord> mintHashes, spendHashes;
+    for (size_t i = 0; i < mintsWithHashes.size(); i++) {
+        mintRecords.push_back(mintsWithHashes[i].first);
+        HashRecord hashRecord;
+        memcpy(hashRecord.key, mintsWithHashes[i].second.begin(), sizeof(hashRecord.key));
+        hashRecord.nIndex = i;
+        mintHashes.push_back(hashRecord);
+    }
+    for (size_t i = 0; i < spendsWithHashes.size(); i++) {
+        spendRecords.push_back(spendsWithHashes[i].first);
+        HashRecord hashRecord;
+        memcpy(hashRecord.key, spendsWithHashes[i].second.begin(), sizeof(hashRecord.key));
+        hashRecord.nIndex = i;
+        spendHashes.push_back(hashRecord);
+    }
+    std::sort(mintHashes.begin(), mintHashes.end(), KeyLess<HashRecord>);
+    std::sort(spendHashes.begin(), spendHashes.end(), KeyLess<HashRecord>);
+
+    std::vector<uint32_t> prefixes(PREFIX_TABLES * (PREFIX_COUNT + 1));
+    BuildPrefixes(mintRecords, &prefixes[0]);
+    BuildPrefixes(spendRecords, &prefixes[PREFIX_COUNT + 1]);
+    BuildPrefixes(mintHashes, &prefixes[2 * (PREFIX_COUNT + 1)]);
+    BuildPrefixes(spendHashes, &prefixes[3 * (PREFIX_COUNT + 1)]);
+
+    std::vector<unsigned char> body;
+    body.reserve(BodySize(mintRecords.size(), spendRecords.size(), sizeof(MintRecord), sizeof(SpendRecord), sizeof(HashRecord)));
+    AppendRecords(body, mintRecords);
+    AppendRecords(body, spendRecords);
+    AppendRecords(body, mintHashes);
+    AppendRecords(body, spendHashes);
+    AppendRecords(body, prefixes);
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FROZEN_STATE_MAGIC, sizeof(header.magic));
+    header.nVersion = FROZEN_STATE_VERSION;
+    header.nHeight = nHeight;
+    memcpy(header.blockHash, blockHash.begin(), sizeof(header.blockHash));
+    header.nMints = mintRecords.size();
+    header.nSpends = spendRecords.size();
+    CSHA256().Write(body.data(), body.size()).Finalize(header.checksum);
+
+    boost::filesystem::path pathTmp = path;
+    pathTmp += ".new";
+    FILE* file = fopen(pathTmp.string().c_str(), "wb");
+    if (!file)
+        return error("%s: failed to open %s", __func__, pathTmp.string());
+    bool fWritten = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            (body.empty() || fwrite(body.data(), body.size(), 1, file) == 1);
+    if (fWritten)
+        FileCommit(file);
+    fclose(file);
+    if (!fWritten || !RenameOver(pathTmp, path)) {
+        boost::filesystem::remove(pathTmp);
+        return error("%s: failed to write %s", __func__, path.string());
+    }
+    return true;
+}
+
+std::unique_ptr<CSigmaFrozenState> CSigmaFrozenState::Open(const boost::filesystem::path& path)
+{
+    std::unique_ptr<CSigmaFrozenState> state(new CSigmaFrozenState());
+#ifndef WIN32
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1)
+        return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        close(fd);
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return nullptr;
+    state->data = static_cast<const unsigned char*>(addr);
+    state->size = st.st_size;
+    state->fMapped = true;
+#else
+    FILE* file = fopen(path.string().c_str(), "rb");
+    if (!file)
+        return nullptr;
+    unsigned char chunk[65536];
+    size_t nRead;
+    while ((nRead = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        state->buffer.insert(state->buffer.end(), chunk, chunk + nRead);
+    fclose(file);
+    if (state->buffer.size() < sizeof(Header))
+        return nullptr;
+    state->data = state->buffer.data();
+    state->size = state->buffer.size();
+#endif
+
+    const Header& header = state->GetHeader();
+    if (memcmp(header.magic, FROZEN_STATE_MAGIC, sizeof(header.magic)) != 0 || header.nVersion != FROZEN_STATE_VERSION ||
+            header.nMints > state->size || header.nSpends > state->size ||
+            state->size - sizeof(Header) != BodySize(header.nMints, header.nSpends, sizeof(MintRecord), sizeof(SpendRecord), sizeof(HashRecord))) {
+        LogPrintf("%s: ignoring %s, it has an unknown format\n", __func__, path.string());
+        return nullptr;
+    }
+    unsigned char checksum[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(state->data + sizeof(Header), state->size - sizeof(Header)).Finalize(checksum);
+    if (memcmp(checksum, header.checksum, sizeof(checksum)) != 0) {
+        LogPrintf("%s: ignoring %s, it is damaged\n", __func__, path.string());
+        return nullptr;
+    }
+    return state;
+}
+
+const CSigmaFrozenState::Header& CSigmaFrozenState::GetHeader() const
+{
+    return *reinterpret_cast<const Header*>(data);
+}
+
+const CSigmaFrozenState::MintRecord* CSigmaFrozenState::Mints() const
+{
+    return reinterpret_cast<const MintRecord*>(data + sizeof(Header));
+}
+
+const CSigmaFrozenState::SpendRecord* CSigmaFrozenState::Spends() const
+{
+    return reinterpret_cast<const SpendRecord*>(Mints() + GetHeader().nMints);
+}
+
+const CSigmaFrozenState::HashRecord* CSigmaFrozenState::MintHashes() const
+{
+    return reinterpret_cast<const HashRecord*>(Spends() + GetHeader().nSpends);
+}
+
+const CSigmaFrozenState::HashRecord* CSigmaFrozenState::SpendHashes() const
+{
+    return MintHashes() + GetHeader().nMints;
+}
+
+const uint32_t* CSigmaFrozenState::Prefixes(size_t nTable) const
+{
+    return reinterpret_cast<const uint32_t*>(SpendHashes() + GetHeader().nSpends) + nTable * (PREFIX_COUNT + 1);
+}
+
+int CSigmaFrozenState::GetHeight() const
+{
+    return GetHeader().nHeight;
+}
+
+uint256 CSigmaFrozenState::GetBlockHash() const
+{
+    uint256 hash;
+    memcpy(hash.begin(), GetHeader().blockHash, sizeof(GetHeader().blockHash));
+    return hash;
+}
+
+size_t CSigmaFrozenState::GetMintCount() const
+{
+    return GetHeader().nMints;
+}
+
+size_t CSigmaFrozenState::GetSpendCount() const
+{
+    return GetHeader().nSpends;
+}
+
+bool CSigmaFrozenState::FindMint(const PublicCoin& pubCoin, CMintedCoinInfo& coinInfo) const
+{
+    MintRecord key;
+    pubCoin.getValue().serialize(key.key);
+    key.key[GroupElement::serialize_size] = static_cast<unsigned char>(pubCoin.getDenomination());
+    const MintRecord* record = FindRecord(Mints(), Prefixes(0), key);
+    if (!record)
+        return false;
+    coinInfo = CMintedCoinInfo::make(pubCoin.getDenomination(), record->coinGroupId, record->nHeight);
+    return true;
+}
+
+bool CSigmaFrozenState::FindSpend(const Scalar& serial, CSpendCoinInfo& coinInfo) const
+{
+    SpendRecord key;
+    serial.serialize(key.key);
+    const SpendRecord* record = FindRecord(Spends(), Prefixes(1), key);
+    if (!record)
+        return false;
+    coinInfo = CSpendCoinInfo::make(CoinDenomination(record->denomination), record->coinGroupId);
+    return true;
+}
+
+bool CSigmaFrozenState::FindMintByHash(GroupElement& pubCoinValue, const uint256& pubCoinValueHash) const
+{
+    HashRecord key;
+    memcpy(key.key, pubCoinValueHash.begin(), sizeof(key.key));
+    const HashRecord* record = FindRecord(MintHashes(), Prefixes(2), key);
+    if (!record)
+        return false;
+    pubCoinValue.deserialize(Mints()[record->nIndex].key);
+    return true;
+}
+
+bool CSigmaFrozenState::FindSpendByHash(Scalar& serial, const uint256& serialHash) const
+{
+    HashRecord key;
+    memcpy(key.key, serialHash.begin(), sizeof(key.key));
+    const HashRecord* record = FindRecord(SpendHashes(), Prefixes(3), key);
+    if (!record)
+        return false;
+    serial.deserialize(Spends()[record->nIndex].key);
+    return true;
+}
+
+void CSigmaFrozenState::ForEachMint(const std::function<void(const PublicCoin&, const CMintedCoinInfo&)>& fn) const
+{
+    const MintRecord* mints = Mints();
+    for (size_t i = 0; i < GetMintCount(); i++) {
+        GroupElement value;
+        value.deserialize(mints[i].key);
+        CoinDenomination denomination = CoinDenomination(mints[i].key[GroupElement::serialize_size]);
+        fn(PublicCoin(value, denomination), CMintedCoinInfo::make(denomination, mints[i].coinGroupId, mints[i].nHeight));
+    }
+}
+
+void CSigmaFrozenState::ForEachSpend(const std::function<void(const Scalar&, const CSpendCoinInfo&)>& fn) const
+{
+    const SpendRecord* spends = Spends();
+    for (size_t i = 0; i < GetSpendCount(); i++) {
+        Scalar serial;
+        serial.deserialize(spends[i].key);
+        fn(serial, CSpendCoinInfo::make(CoinDenomination(spends[i].denomination), spends[i].coinGroupId));
+    }
+}
+
+} // namespace sigma
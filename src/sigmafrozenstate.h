@@ -0,0 +1,80 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef FIRO_SIGMAFROZENSTATE_H
+#define FIRO_SIGMAFROZENSTATE_H
+
+#include "coin_containers.h"
+#include "uint256.h"
+
+#include <boost/filesystem/path.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace sigma {
+
+/**
+ * The final Sigma mint and serial sets, sorted in a memory mapped file.
+ *
+ * Sigma mints and serials can't be added to the chain past nLelantusGracefulPeriod, but CSigmaState used to keep
+ * all of them in node based hash maps that were rebuilt at every startup. Once the chain is deep enough past the end
+ * of Sigma the sets are written as fixed size records sorted by their serialized keys, with tables of the value and
+ * serial hashes the wallet looks coins up by. A lookup narrows the range with a table indexed by the first two bytes
+ * of the key and binary searches it. The file records the block up to which it has the state, callers only use it
+ * while that block is on the active chain.
+ */
+class CSigmaFrozenState
+{
+public:
+    CSigmaFrozenState(const CSigmaFrozenState&) = delete;
+    CSigmaFrozenState& operator=(const CSigmaFrozenState&) = delete;
+    ~CSigmaFrozenState();
+
+    // Writes the sets of the chain up to the block at nHeight, replacing the file atomically
+    static bool Write(const boost::filesystem::path& path, const mint_info_container& mints,
+                      const spend_info_container& spends, int nHeight, const uint256& blockHash);
+    // Maps a file written by Write, nullptr if it's missing or damaged
+    static std::unique_ptr<CSigmaFrozenState> Open(const boost::filesystem::path& path);
+
+    int GetHeight() const;
+    uint256 GetBlockHash() const;
+    size_t GetMintCount() const;
+    size_t GetSpendCount() const;
+
+    bool FindMint(const PublicCoin& pubCoin, CMintedCoinInfo& coinInfo) const;
+    bool FindSpend(const Scalar& serial, CSpendCoinInfo& coinInfo) const;
+    // Look coins up by the hashes the wallet keeps, the preimage is stored in the first argument
+    bool FindMintByHash(GroupElement& pubCoinValue, const uint256& pubCoinValueHash) const;
+    bool FindSpendByHash(Scalar& serial, const uint256& serialHash) const;
+
+    void ForEachMint(const std::function<void(const PublicCoin&, const CMintedCoinInfo&)>& fn) const;
+    void ForEachSpend(const std::function<void(const Scalar&, const CSpendCoinInfo&)>& fn) const;
+
+private:
+    struct Header;
+    struct MintRecord;
+    struct SpendRecord;
+    struct HashRecord;
+
+    CSigmaFrozenState();
+
+    const Header& GetHeader() const;
+    const MintRecord* Mints() const;
+    const SpendRecord* Spends() const;
+    const HashRecord* MintHashes() const;
+    const HashRecord* SpendHashes() const;
+    const uint32_t* Prefixes(size_t nTable) const;
+
+    const unsigned char* data;
+    size_t size;
+    bool fMapped;
+    // the file contents on platforms without mmap
+    std::vector<unsigned char> buffer;
+};
+
+} // namespace sigma
+
+#endif // FIRO_SIGMAFROZENSTATE_H
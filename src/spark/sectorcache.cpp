@@ -0,0 +1,233 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sectorcache.h"
+#include "../validation.h"
+#include "../utilstrencodings.h"
+
+namespace spark {
+
+static CSparkSectorCache sectorCache(SPARK_SECTOR_CACHE_BYTES);
+
+UniValue RecoveryCoinToUniValue(const RecoveryCoin& coin) {
+    CDataStream serializedCoin(SER_NETWORK, PROTOCOL_VERSION);
+    serializedCoin << coin;
+    std::vector<unsigned char> vch(serializedCoin.begin(), serializedCoin.end());
+
+    std::vector<UniValue> data;
+    data.push_back(EncodeBase64(vch.data(), size_t(vch.size()))); // coin
+    data.push_back(EncodeBase64(coin.second.first.begin(), coin.second.first.size())); // tx hash
+    data.push_back(EncodeBase64(coin.second.second.data(), coin.second.second.size())); // spark serial context
+
+    UniValue entity(UniValue::VARR);
+    entity.push_backV(data);
+    return entity;
+}
+
+void CSparkSector::AddCoin(UniValue&& coin) {
+    // an encoded coin is an array of three strings
+    nEncodedBytes += coin.size() * sizeof(UniValue);
+    for (const UniValue& field : coin.getValues())
+        nEncodedBytes += field.get_str().capacity();
+    coins.push_back(std::move(coin));
+    nCoins++;
+}
+
+size_t CSparkSector::DynamicMemoryUsage() const {
+    return sizeof(*this) + coins.capacity() * sizeof(UniValue) + nEncodedBytes + serialized.capacity();
+}
+
+CSparkSectorCache::CSparkSectorCache(size_t nMaxBytesIn)
+    : nMaxBytes(nMaxBytesIn),
+      nBytes(0) {
+}
+
+CSparkSectorCache::SectorPtr CSparkSectorCache::GetSector(CBlockIndex* block, int coinGroupID) {
+    AssertLockHeld(cs_main);
+
+    Key key = MakeKey(coinGroupID, block->GetBlockHash(), false);
+    SectorPtr sector;
+    if (Get(key, sector))
+        return sector;
+
+    auto newSector = std::make_shared<CSparkSector>();
+    auto it = block->sparkMintedCoins.find(coinGroupID);
+    if (it != block->sparkMintedCoins.end()) {
+        CDataStream serialized(SER_NETWORK, PROTOCOL_VERSION);
+        newSector->coins.reserve(it->second.size());
+        for (const auto& coin : it->second) {
+            std::pair<uint256, std::vector<unsigned char>> txHashContext;
+            auto ctx = block->sparkTxHashContext.find(coin.S);
+            if (ctx != block->sparkTxHashContext.end())
+                txHashContext = ctx->second;
+            RecoveryCoin recoveryCoin(coin, txHashContext);
+            serialized << recoveryCoin;
+            newSector->AddCoin(RecoveryCoinToUniValue(recoveryCoin));
+        }
+        newSector->serialized.assign(serialized.begin(), serialized.end());
+    }
+
+    sector = newSector;
+    Insert(key, sector);
+    return sector;
+}
+
+void CSparkSectorCache::GetAnonymitySet(
+        CChain *chain,
+        int maxHeight,
+        int coinGroupID,
+        const std::string& startBlockHash,
+        uint256& blockHash_out,
+        std::vector<unsigned char>& setHash_out,
+        std::vector<SectorPtr>& sectors_out) {
+    AssertLockHeld(cs_main);
+    sectors_out.clear();
+
+    CSparkState* sparkState = CSparkState::GetState();
+    std::vector<std::pair<CBlockIndex*, int>> blocks;
+    sparkState->GetBlocksForRecovery(chain, maxHeight, coinGroupID, startBlockHash, blockHash_out, setHash_out, blocks);
+    if (blocks.empty())
+        return;
+
+    // a complete group never grows again, freeze its full set
+    bool fFreeze = startBlockHash.empty() && coinGroupID < sparkState->GetLatestCoinID();
+    if (fFreeze) {
+        SectorPtr frozen;
+        if (GetFrozenSet(coinGroupID, blockHash_out, frozen)) {
+            sectors_out.push_back(frozen);
+            return;
+        }
+    }
+
+    sectors_out.reserve(blocks.size());
+    for (const auto& block : blocks)
+        sectors_out.push_back(GetSector(block.first, block.second));
+
+    if (fFreeze) {
+        auto frozen = std::make_shared<CSparkSector>();
+        size_t nCoins = 0, nSerializedSize = 0;
+        for (const auto& sector : sectors_out) {
+            nCoins += sector->nCoins;
+            nSerializedSize += sector->serialized.size();
+        }
+        frozen->coins.reserve(nCoins);
+        frozen->serialized.reserve(nSerializedSize);
+        for (const auto& sector : sectors_out) {
+            frozen->coins.insert(frozen->coins.end(), sector->coins.begin(), sector->coins.end());
+            frozen->serialized.insert(frozen->serialized.end(), sector->serialized.begin(), sector->serialized.end());
+            frozen->nCoins += sector->nCoins;
+            frozen->nEncodedBytes += sector->nEncodedBytes;
+        }
+        sectors_out.assign(1, frozen);
+        Insert(MakeKey(coinGroupID, blockHash_out, true), sectors_out.front());
+    }
+}
+
+bool CSparkSectorCache::GetFrozenSet(int coinGroupID, const uint256& blockHash, SectorPtr& set_out) {
+    return Get(MakeKey(coinGroupID, blockHash, true), set_out);
+}
+
+UniValue CSparkSectorCache::SectorsToUniValue(const std::vector<SectorPtr>& sectors) {
+    UniValue coins(UniValue::VARR);
+    for (const auto& sector : sectors)
+        coins.push_backV(sector->coins);
+    return coins;
+}
+
+CSparkSectorCache::Key CSparkSectorCache::MakeKey(int coinGroupID, const uint256& blockHash, bool fFrozen) {
+    return Key(((uint32_t)coinGroupID << 1) | (fFrozen ? 1 : 0), blockHash);
+}
+
+bool CSparkSectorCache::Get(const Key& key, SectorPtr& sector_out) {
+    LOCK(cs);
+    auto it = index.find(key);
+    if (it == index.end())
+        return false;
+    entries.splice(entries.begin(), entries, it->second);
+    sector_out = it->second->sector;
+    return true;
+}
+
+void CSparkSectorCache::Insert(const Key& key, const SectorPtr& sector) {
+    LOCK(cs);
+    // concurrent callers may have done the same work for the same key
+    if (index.count(key))
+        return;
+
+    nBytes += sector->DynamicMemoryUsage();
+    entries.push_front({key, sector});
+    index.emplace(key, entries.begin());
+
+    // the new entry is kept even if it exceeds the budget on its own
+    while (nBytes > nMaxBytes && entries.size() > 1) {
+        nBytes -= entries.back().sector->DynamicMemoryUsage();
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+CSparkSectorCache::EncodedTagsPtr CSparkSectorCache::GetUsedLTags(bool withTxHashes) {
+    UsedLTagSet tags;
+    std::unordered_map<uint256, uint256> ltagTxhash;
+    uint256 tip;
+    {
+        LOCK(cs_main);
+        tip = chainActive.Tip() ? chainActive.Tip()->GetBlockHash() : uint256();
+        {
+            LOCK(cs);
+            if (tip == lTagsTip && lTags)
+                return withTxHashes ? lTagsTxHashes : lTags;
+        }
+        CSparkState* sparkState = CSparkState::GetState();
+        tags = sparkState->GetSpends();
+        ltagTxhash = sparkState->GetSpendTxIds();
+    }
+
+    // Serialize outside of cs_main, concurrent callers may do the same work for the same tip
+    auto newTags = std::make_shared<std::vector<UniValue>>();
+    auto newTagsTxHashes = std::make_shared<std::vector<UniValue>>();
+    newTags->reserve(tags.size());
+    newTagsTxHashes->reserve(tags.size());
+    tags.ForEachSerialized([&](const UsedLTagSet::SerializedTag& serialized, int) {
+        UniValue encodedTag(EncodeBase64(serialized.data(), serialized.size()));
+
+        uint256 txid;
+        // tx hashes are only kept with -mobile
+        if (!ltagTxhash.empty()) {
+            GroupElement tag;
+            tag.deserialize(serialized.data());
+            auto it = ltagTxhash.find(primitives::GetLTagHash(tag));
+            if (it != ltagTxhash.end())
+                txid = it->second;
+        }
+        UniValue entity(UniValue::VARR);
+        entity.push_back(encodedTag);
+        entity.push_back(EncodeBase64(txid.begin(), txid.size()));
+
+        newTags->push_back(std::move(encodedTag));
+        newTagsTxHashes->push_back(std::move(entity));
+    });
+
+    LOCK(cs);
+    lTagsTip = tip;
+    lTags = newTags;
+    lTagsTxHashes = newTagsTxHashes;
+    return withTxHashes ? lTagsTxHashes : lTags;
+}
+
+void CSparkSectorCache::Clear() {
+    LOCK(cs);
+    entries.clear();
+    index.clear();
+    nBytes = 0;
+    lTagsTip.SetNull();
+    lTags.reset();
+    lTagsTxHashes.reset();
+}
+
+CSparkSectorCache* CSparkSectorCache::GetCache() {
+    return &sectorCache;
+}
+
+} // namespace spark
@@ -0,0 +1,119 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef FIRO_SPARK_SECTORCACHE_H
+#define FIRO_SPARK_SECTORCACHE_H
+
+#include "state.h"
+#include "../saltedhasher.h"
+#include "../sync.h"
+
+#include <univalue.h>
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace spark {
+
+// Memory used by the encoded sectors and frozen sets kept in the cache
+static const size_t SPARK_SECTOR_CACHE_BYTES = 256 * 1024 * 1024;
+
+typedef std::pair<spark::Coin, std::pair<uint256, std::vector<unsigned char>>> RecoveryCoin;
+
+// Encodes a coin the way the mobile RPCs send it: [coin, tx hash, serial context], all base64
+UniValue RecoveryCoinToUniValue(const RecoveryCoin& coin);
+
+// Coins of a sector or a frozen set, in both encodings they are sent in
+struct CSparkSector {
+    // the coins as getsparkanonymityset returns them
+    std::vector<UniValue> coins;
+    // the coins serialized back to back, as /rest/sparkset streams them
+    std::vector<unsigned char> serialized;
+    size_t nCoins = 0;
+    // heap memory held by the elements of coins
+    size_t nEncodedBytes = 0;
+
+    void AddCoin(UniValue&& coin);
+    size_t DynamicMemoryUsage() const;
+};
+
+/*
+ * Ready-to-send data for the mobile RPCs (getsparkanonymityset, getusedcoinstags, getusedcoinstagstxhashes)
+ * and /rest/sparkset.
+ *
+ * The coins a block mints into a group never change, so the encoded coins of a block (a sector) are
+ * cached by (group id, block hash) and never go stale, sectors of disconnected blocks simply age out.
+ * A set is fully determined by its group id and latest block, so once a group is complete its whole
+ * set is frozen into a single entry. Only the sectors of new blocks of the latest group are encoded
+ * on demand. Sectors and frozen sets are evicted, least recently used first, when the cache exceeds
+ * its memory budget. Used tags are snapshotted once per chain tip.
+ */
+class CSparkSectorCache {
+public:
+    typedef std::shared_ptr<const CSparkSector> SectorPtr;
+    typedef std::shared_ptr<const std::vector<UniValue>> EncodedTagsPtr;
+
+    explicit CSparkSectorCache(size_t nMaxBytesIn);
+
+    // Returns the sectors making up the set getsparkanonymityset returns, latest block first.
+    // cs_main must be held.
+    void GetAnonymitySet(
+            CChain *chain,
+            int maxHeight,
+            int coinGroupID,
+            const std::string& startBlockHash,
+            uint256& blockHash_out,
+            std::vector<unsigned char>& setHash_out,
+            std::vector<SectorPtr>& sectors_out);
+
+    // Returns the frozen set of a complete group with the given latest block, if it's cached
+    bool GetFrozenSet(int coinGroupID, const uint256& blockHash, SectorPtr& set_out);
+
+    // Returns the coins a block mints into a group, cs_main must be held
+    SectorPtr GetSector(CBlockIndex* block, int coinGroupID);
+
+    // Returns encoded used linking tags (paired with the spending tx hash if withTxHashes is set) as of
+    // the current tip, in the order CSparkState::GetSpends() iterates them. Takes cs_main, must not be
+    // called with cs_main held.
+    EncodedTagsPtr GetUsedLTags(bool withTxHashes);
+
+    // Builds the coins array getsparkanonymityset returns from sectors
+    static UniValue SectorsToUniValue(const std::vector<SectorPtr>& sectors);
+
+    void Clear();
+
+    static CSparkSectorCache* GetCache();
+
+private:
+    // group id shifted left by one, the low bit is set for frozen sets
+    typedef std::pair<uint32_t, uint256> Key;
+
+    struct Entry {
+        Key key;
+        SectorPtr sector;
+    };
+
+    static Key MakeKey(int coinGroupID, const uint256& blockHash, bool fFrozen);
+    bool Get(const Key& key, SectorPtr& sector_out);
+    void Insert(const Key& key, const SectorPtr& sector);
+
+private:
+    CCriticalSection cs;
+
+    const size_t nMaxBytes;
+    size_t nBytes;
+    // most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, StaticSaltedHasher> index;
+
+    // tip the used tags snapshot was taken at
+    uint256 lTagsTip;
+    EncodedTagsPtr lTags;
+    EncodedTagsPtr lTagsTxHashes;
+};
+
+} // namespace spark
+
+#endif // FIRO_SPARK_SECTORCACHE_H
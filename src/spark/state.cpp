@@ -29,6 +29,17 @@ static bool CheckLTag(
 }
 
 bool BuildSparkStateFromIndex(CChain *chain) {
+    // Counted first, the maps would rehash every coin again each time they grow. Rehashing a coin means
+    // serializing and hashing it.
+    size_t nMints = 0, nSpends = 0;
+    for (CBlockIndex *blockIndex = chain->Genesis(); blockIndex; blockIndex=chain->Next(blockIndex))
+    {
+        for (auto const &coins : blockIndex->sparkMintedCoins)
+            nMints += coins.second.size();
+        nSpends += blockIndex->spentLTags.size();
+    }
+    sparkState.Reserve(nMints, nSpends);
+
     for (CBlockIndex *blockIndex = chain->Genesis(); blockIndex; blockIndex=chain->Next(blockIndex))
     {
         sparkState.AddBlock(blockIndex);
@@ -956,13 +967,7 @@ bool CSparkState::IsUsedLTag(const GroupElement& lTag) {
 }
 
 bool CSparkState::IsUsedLTagHash(GroupElement& lTag, const uint256 &coinLTaglHash) {
-    for ( auto it = GetSpends().begin(); it != GetSpends().end(); ++it ) {
-        if (primitives::GetLTagHash(it->first) == coinLTaglHash) {
-            lTag = it->first;
-            return true;
-        }
-    }
-    return false;
+    return usedLTags.FindHash(lTag, coinLTaglHash);
 }
 
 
@@ -1042,7 +1047,7 @@ void CSparkState::AddMintsToStateAndBlockIndex(
 
 void CSparkState::AddSpend(const GroupElement& lTag, int coinGroupId) {
     if (mintMetaInfo.count(coinGroupId) > 0) {
-        usedLTags[lTag] = coinGroupId;
+        usedLTags.insert(lTag, coinGroupId);
         spendMetaInfo[coinGroupId] += 1;
     }
 }
@@ -1052,10 +1057,10 @@ void CSparkState::AddLTagTxHash(const uint256& lTagHash, const uint256& txHash)
 }
 
 void CSparkState::RemoveSpend(const GroupElement& lTag) {
-    auto iter = usedLTags.find(lTag);
-    if (iter != usedLTags.end()) {
-        spendMetaInfo[iter->second] -= 1;
-        usedLTags.erase(iter);
+    int coinGroupId;
+    if (usedLTags.Find(lTag, coinGroupId)) {
+        spendMetaInfo[coinGroupId] -= 1;
+        usedLTags.erase(lTag);
     }
 }
 
@@ -1094,6 +1099,13 @@ void CSparkState::AddBlock(CBlockIndex *index) {
     }
 }
 
+void CSparkState::Reserve(size_t nMints, size_t nSpends) {
+    mintedCoins.reserve(mintedCoins.size() + nMints);
+    usedLTags.reserve(usedLTags.size() + nSpends);
+    if (GetBoolArg("-mobile", false))
+        ltagTxhash.reserve(ltagTxhash.size() + nSpends);
+}
+
 void CSparkState::RemoveBlock(CBlockIndex *index) {
     // roll back coin group updates
     for (auto &coins : index->sparkMintedCoins)
@@ -1331,10 +1343,157 @@ void CSparkState::GetCoinsForRecovery(
 }
 
 
+void CSparkState::GetAnonSetMetaData(
+        CChain *chain,
+        int maxHeight,
+        int coinGroupID,
+        std::string start_block_hash,
+        uint256& blockHash_out,
+        std::vector<unsigned char>& setHash_out,
+        size_t& size_out) {
+    size_out = 0;
+    if (coinGroups.count(coinGroupID) == 0) {
+        return;
+    }
+    SparkCoinGroupInfo &coinGroup = coinGroups[coinGroupID];
+    for (CBlockIndex *block = coinGroup.lastBlock;; block = block->pprev) {
+        if (block->nHeight <= maxHeight) {
+            if (block->GetBlockHash().GetHex() == start_block_hash) {
+                break;
+            }
+            // check coins in group coinGroupID - 1 in the case that using coins from prev group.
+            int id = 0;
+            if (CountCoinInBlock(block, coinGroupID)) {
+                id = coinGroupID;
+            } else if (CountCoinInBlock(block, coinGroupID - 1)) {
+                id = coinGroupID - 1;
+            }
+            if (id) {
+                if (size_out == 0) {
+                    // latest block satisfying given conditions
+                    // remember block hash and set hash
+                    blockHash_out = block->GetBlockHash();
+                    setHash_out = GetAnonymitySetHash(block, id);
+                }
+                size_out += block->sparkMintedCoins[id].size();
+            }
+        }
+        if (block == coinGroup.firstBlock) {
+            break;
+        }
+    }
+}
+
+void CSparkState::GetBlocksForRecovery(
+        CChain *chain,
+        int maxHeight,
+        int coinGroupID,
+        std::string start_block_hash,
+        uint256& blockHash_out,
+        std::vector<unsigned char>& setHash_out,
+        std::vector<std::pair<CBlockIndex*, int>>& blocks_out) {
+    blocks_out.clear();
+    if (coinGroups.count(coinGroupID) == 0) {
+        return;
+    }
+    SparkCoinGroupInfo &coinGroup = coinGroups[coinGroupID];
+    for (CBlockIndex *block = coinGroup.lastBlock;; block = block->pprev) {
+        if (block->nHeight <= maxHeight) {
+            if (block->GetBlockHash().GetHex() == start_block_hash) {
+                break;
+            }
+            // check coins in group coinGroupID - 1 in the case that using coins from prev group.
+            int id = 0;
+            if (CountCoinInBlock(block, coinGroupID)) {
+                id = coinGroupID;
+            } else if (CountCoinInBlock(block, coinGroupID - 1)) {
+                id = coinGroupID - 1;
+            }
+            if (id) {
+                if (blocks_out.empty()) {
+                    // latest block satisfying given conditions
+                    // remember block hash and set hash
+                    blockHash_out = block->GetBlockHash();
+                    setHash_out = GetAnonymitySetHash(block, id);
+                }
+                blocks_out.emplace_back(block, id);
+            }
+        }
+        if (block == coinGroup.firstBlock) {
+            break;
+        }
+    }
+}
+
+void CSparkState::GetCoinsForRecovery(
+        CChain *chain,
+        int coinGroupID,
+        const uint256& latestBlockHash,
+        std::string start_block_hash,
+        size_t startIndex,
+        size_t endIndex,
+        std::vector<std::pair<spark::Coin, std::pair<uint256, std::vector<unsigned char>>>>& coins) {
+    coins.clear();
+    if (coinGroups.count(coinGroupID) == 0 || startIndex >= endIndex) {
+        return;
+    }
+    SparkCoinGroupInfo &coinGroup = coinGroups[coinGroupID];
+    bool fLatestFound = false;
+    size_t index = 0;
+    for (CBlockIndex *block = coinGroup.lastBlock;; block = block->pprev) {
+        // skip everything added on top of the block the client has pinned the set to
+        if (!fLatestFound && block->GetBlockHash() == latestBlockHash) {
+            // the set is pinned to a block that is no longer in the active chain
+            if (!chain->Contains(block)) {
+                return;
+            }
+            fLatestFound = true;
+        }
+        if (fLatestFound) {
+            if (block->GetBlockHash().GetHex() == start_block_hash) {
+                break;
+            }
+            int id = 0;
+            if (CountCoinInBlock(block, coinGroupID)) {
+                id = coinGroupID;
+            } else if (CountCoinInBlock(block, coinGroupID - 1)) {
+                id = coinGroupID - 1;
+            }
+            if (id) {
+                const std::vector<spark::Coin> &blockCoins = block->sparkMintedCoins[id];
+                // the whole block is before the requested range, don't look into it
+                if (index + blockCoins.size() <= startIndex) {
+                    index += blockCoins.size();
+                } else {
+                    for (const auto &coin : blockCoins) {
+                        if (index >= endIndex) {
+                            break;
+                        }
+                        if (index >= startIndex) {
+                            std::pair<uint256, std::vector<unsigned char>> txHashContext;
+                            if (block->sparkTxHashContext.count(coin.S))
+                                txHashContext = block->sparkTxHashContext[coin.S];
+                            coins.push_back({coin, txHashContext});
+                        }
+                        ++index;
+                    }
+                }
+                if (index >= endIndex) {
+                    break;
+                }
+            }
+        }
+        if (block == coinGroup.firstBlock) {
+            break;
+        }
+    }
+}
+
+
 std::unordered_map<spark::Coin, CMintedCoinInfo, spark::CoinHash> const & CSparkState::GetMints() const {
     return mintedCoins;
 }
-std::unordered_map<GroupElement, int, spark::CLTagHash> const & CSparkState::GetSpends() const {
+UsedLTagSet const & CSparkState::GetSpends() const {
     return usedLTags;
 }
 
@@ -10,11 +10,15 @@
 #include "../libspark/mint_transaction.h"
 #include "../libspark/spend_transaction.h"
 #include "primitives.h"
+#include "../flattagset.h"
 
 namespace spark_mintspend { class spark_mintspend_test; }
 
 namespace spark {
 
+// Used linking tags mapped to the id of the group they were spent from
+typedef CFlatTagSet<GroupElement, primitives::GetLTagHash> UsedLTagSet;
+
 // Spark transaction info, added to the CBlock to ensure spark mint/spend transactions got their info stored into index
 class CSparkTxInfo {
 public:
@@ -175,6 +179,8 @@ public:
     void AddBlock(CBlockIndex *index);
     // Disconnect block from the chain rolling back mints and spends
     void RemoveBlock(CBlockIndex *index);
+    // Makes room for this many more mints and spends, before many blocks are added
+    void Reserve(size_t nMints, size_t nSpends);
 
     // Add spend into the mempool.
     // Check if there is a coin with such serial in either blockchain or mempool
@@ -213,8 +219,42 @@ public:
             std::vector<std::pair<spark::Coin, std::pair<uint256, std::vector<unsigned char>>>>& coins,
             std::vector<unsigned char>& setHash_out);
 
+    // Returns the block hash and set hash GetCoinsForRecovery would return and the number of coins
+    // in the set, without collecting the coins themselves
+    void GetAnonSetMetaData(
+            CChain *chain,
+            int maxHeight,
+            int coinGroupID,
+            std::string start_block_hash,
+            uint256& blockHash_out,
+            std::vector<unsigned char>& setHash_out,
+            size_t& size_out);
+
+    // Returns the blocks holding the coins GetCoinsForRecovery would return, latest first, each paired
+    // with the id of the group its coins were minted to
+    void GetBlocksForRecovery(
+            CChain *chain,
+            int maxHeight,
+            int coinGroupID,
+            std::string start_block_hash,
+            uint256& blockHash_out,
+            std::vector<unsigned char>& setHash_out,
+            std::vector<std::pair<CBlockIndex*, int>>& blocks_out);
+
+    // Returns a sector [startIndex, endIndex) of the set as it was at the block latestBlockHash, coins
+    // ordered the same way GetCoinsForRecovery orders them. Lets clients page through a large set.
+    // Returns nothing if latestBlockHash is not part of the group or was disconnected.
+    void GetCoinsForRecovery(
+            CChain *chain,
+            int coinGroupID,
+            const uint256& latestBlockHash,
+            std::string start_block_hash,
+            size_t startIndex,
+            size_t endIndex,
+            std::vector<std::pair<spark::Coin, std::pair<uint256, std::vector<unsigned char>>>>& coins);
+
     std::unordered_map<spark::Coin, CMintedCoinInfo, spark::CoinHash> const & GetMints() const;
-    std::unordered_map<GroupElement, int, spark::CLTagHash> const & GetSpends() const;
+    UsedLTagSet const & GetSpends() const;
     std::unordered_map<uint256, uint256> const& GetSpendTxIds() const;
     std::unordered_map<int, SparkCoinGroupInfo> const & GetCoinGroups() const;
     std::unordered_map<GroupElement, uint256, spark::CLTagHash> const & GetMempoolLTags() const;
@@ -240,7 +280,7 @@ private:
     // Set of all minted coins
     std::unordered_map<spark::Coin, CMintedCoinInfo, spark::CoinHash> mintedCoins;
     // Set of all used coin linking tags.
-    std::unordered_map<GroupElement, int, spark::CLTagHash> usedLTags;
+    UsedLTagSet usedLTags;
     // linking tag hash mapped to tx hash
     std::unordered_map<uint256, uint256> ltagTxhash;
 
@@ -357,4 +357,89 @@ struct CAddressIndexIteratorHeightKey {
     }
 };
 
+struct CAddressIndexIteratorTxKey {
+    AddressType type;
+    uint160 hashBytes;
+    int blockHeight;
+    unsigned int txindex;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, static_cast<unsigned int>(type));
+        hashBytes.Serialize(s);
+        ser_writedata32be(s, blockHeight);
+        ser_writedata32be(s, txindex);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        type = static_cast<AddressType>(ser_readdata8(s));
+        hashBytes.Unserialize(s);
+        blockHeight = ser_readdata32be(s);
+        txindex = ser_readdata32be(s);
+    }
+
+    CAddressIndexIteratorTxKey(AddressType addressType, uint160 addressHash, int height, unsigned int blockindex) {
+        type = addressType;
+        hashBytes = addressHash;
+        blockHeight = height;
+        txindex = blockindex;
+    }
+
+    CAddressIndexIteratorTxKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = AddressType::unknown;
+        hashBytes.SetNull();
+        blockHeight = 0;
+        txindex = 0;
+    }
+};
+
+/**
+ * Running totals of an address, kept next to its address index entries so that its balance doesn't need
+ * a scan over all of them. Used for the per-block changes of the totals as well.
+ */
+struct CAddressBalance {
+    CAmount balance;
+    CAmount received;
+    int64_t txCount;
+    // only counted for the address types with unspent index entries
+    int64_t utxoCount;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(balance);
+        READWRITE(received);
+        READWRITE(txCount);
+        READWRITE(utxoCount);
+    }
+
+    CAddressBalance() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+        txCount = 0;
+        utxoCount = 0;
+    }
+
+    bool IsNull() const {
+        return balance == 0 && received == 0 && txCount == 0 && utxoCount == 0;
+    }
+
+    CAddressBalance& operator+=(const CAddressBalance& other) {
+        balance += other.balance;
+        received += other.received;
+        txCount += other.txCount;
+        utxoCount += other.utxoCount;
+        return *this;
+    }
+};
+
 #endif // BITCOIN_SPENTINDEX_H
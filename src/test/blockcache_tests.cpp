@@ -0,0 +1,91 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockcache.h"
+#include "blockencodings.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "consensus/merkle.h"
+#include "random.h"
+#include "streams.h"
+#include "validation.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockcache_tests, BasicTestingSetup)
+
+static std::shared_ptr<const CBlock> BuildBlock(size_t nTxs) {
+    std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig.resize(10);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 42;
+    for (size_t i = 0; i < nTxs; i++) {
+        tx.vin[0].prevout.hash = GetRandHash();
+        pblock->vtx.push_back(MakeTransactionRef(tx));
+    }
+    pblock->nVersion = 42;
+    pblock->hashPrevBlock = GetRandHash();
+    pblock->nBits = 0x207fffff;
+    pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
+    return pblock;
+}
+
+BOOST_AUTO_TEST_CASE(shared_encodings)
+{
+    CSerializedBlockCache cache(SERIALIZED_BLOCK_CACHE_BYTES);
+    std::shared_ptr<const CBlock> pblock = BuildBlock(10);
+    uint256 hash = pblock->GetHash();
+    CBlockIndex index(*pblock);
+    index.phashBlock = &hash;
+    cache.AddBlock(pblock);
+
+    LOCK(cs_main);
+    const Consensus::Params& params = Params().GetConsensus();
+    BOOST_CHECK(cache.GetBlock(&index, false, params) == pblock);
+
+    CSharedNetPayloadRef serialized = cache.GetSerializedBlock(&index, SERIALIZE_TRANSACTION_NO_WITNESS, false, params);
+    BOOST_REQUIRE(serialized);
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS);
+    ss << *pblock;
+    BOOST_CHECK(serialized->data == std::vector<unsigned char>(ss.begin(), ss.end()));
+    BOOST_CHECK(serialized->hash == Hash(ss.begin(), ss.end()));
+
+    // every later request is served the same payload
+    BOOST_CHECK(cache.GetSerializedBlock(&index, SERIALIZE_TRANSACTION_NO_WITNESS, false, params) == serialized);
+    BOOST_CHECK(cache.GetSerializedCompactBlock(&index, true, false, params) == cache.GetSerializedCompactBlock(&index, true, false, params));
+
+    CSharedNetPayloadRef cmpctblock = cache.GetSerializedCompactBlock(&index, true, false, params);
+    CDataStream ssCmpct(cmpctblock->data, SER_NETWORK, PROTOCOL_VERSION);
+    CBlockHeaderAndShortTxIDs shortIDs;
+    ssCmpct >> shortIDs;
+    BOOST_CHECK_EQUAL(shortIDs.BlockTxCount(), pblock->vtx.size());
+}
+
+BOOST_AUTO_TEST_CASE(memory_bound)
+{
+    std::shared_ptr<const CBlock> pblock1 = BuildBlock(100);
+    std::shared_ptr<const CBlock> pblock2 = BuildBlock(100);
+    uint256 hash1 = pblock1->GetHash(), hash2 = pblock2->GetHash();
+    CBlockIndex index1(*pblock1), index2(*pblock2);
+    index1.phashBlock = &hash1;
+    index2.phashBlock = &hash2;
+
+    // room for both blocks serialized, parsed blocks take several times more memory
+    CSerializedBlockCache cache(::GetSerializeSize(*pblock1, SER_NETWORK, PROTOCOL_VERSION) +
+                                ::GetSerializeSize(*pblock2, SER_NETWORK, PROTOCOL_VERSION));
+    cache.AddBlock(pblock1);
+    cache.AddBlock(pblock2);
+
+    // the least recently used block was evicted, the blocks aren't on disk
+    LOCK(cs_main);
+    const Consensus::Params& params = Params().GetConsensus();
+    BOOST_CHECK(!cache.GetBlock(&index1, false, params));
+    BOOST_CHECK(cache.GetBlock(&index2, false, params) == pblock2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 
 #include "bls/bls.h"
 #include "bls/bls_batchverifier.h"
+#include "bls/bls_worker.h"
 #include "test/test_bitcoin.h"
 
 #include <boost/test/unit_test.hpp>
@@ -154,4 +155,113 @@ BOOST_AUTO_TEST_CASE(batch_verifier_tests)
     Verify(msgs);
 }
 
+BOOST_AUTO_TEST_CASE(batch_verifier_bisect_tests)
+{
+    std::vector<Message> msgs;
+
+    // many messages from a single source, the invalid ones must be found by bisecting the batch
+    for (uint32_t i = 1; i <= 13; i++) {
+        AddMessage(msgs, 1, i, i, i != 2 && i != 3 && i != 11);
+    }
+    Verify(msgs);
+
+    // all messages invalid
+    msgs.clear();
+    for (uint32_t i = 1; i <= 5; i++) {
+        AddMessage(msgs, 1, i, i, false);
+    }
+    Verify(msgs);
+}
+
+BOOST_AUTO_TEST_CASE(worker_verify_bisect_tests)
+{
+    CBLSWorker worker;
+    worker.Start();
+
+    // the first sig is verified on its own, and holds its worker until the others are queued so that they are
+    // verified as one batch
+    std::promise<void> gate;
+    std::shared_future<void> gateFuture(gate.get_future());
+    std::vector<Message> msgs;
+    AddMessage(msgs, 1, 0, 100, true);
+    auto first = worker.AsyncVerifySig(msgs[0].sig, msgs[0].pk, msgs[0].msgHash, [gateFuture] {
+        gateFuture.wait();
+        return false;
+    });
+
+    for (uint32_t i = 1; i <= 13; i++) {
+        AddMessage(msgs, 1, i, i, i != 2 && i != 3 && i != 11);
+    }
+    std::vector<std::future<bool>> results;
+    for (size_t i = 1; i < msgs.size(); i++) {
+        results.emplace_back(worker.AsyncVerifySig(msgs[i].sig, msgs[i].pk, msgs[i].msgHash));
+    }
+    // the same sig queued twice is verified once, both callers get the result
+    auto duplicate = worker.AsyncVerifySig(msgs[13].sig, msgs[13].pk, msgs[13].msgHash);
+    gate.set_value();
+
+    BOOST_CHECK(first.get());
+    for (size_t i = 0; i < results.size(); i++) {
+        BOOST_CHECK_EQUAL(results[i].get(), msgs[i + 1].valid);
+    }
+    BOOST_CHECK_EQUAL(duplicate.get(), msgs[13].valid);
+
+    worker.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(worker_recover_tests)
+{
+    CBLSWorker worker;
+    worker.Start();
+
+    // a 3 of 5 threshold key
+    const size_t threshold = 3;
+    std::vector<CBLSSecretKey> msk(threshold);
+    for (auto& sk : msk) {
+        sk.MakeNewKey();
+    }
+    std::vector<CBLSId> ids;
+    std::vector<CBLSSecretKey> skShares;
+    for (uint32_t i = 1; i <= 5; i++) {
+        uint256 proTxHash;
+        *((uint32_t*)proTxHash.begin()) = i;
+        ids.emplace_back(proTxHash);
+        skShares.emplace_back();
+        BOOST_REQUIRE(skShares.back().SecretKeyShare(msk, ids.back()));
+    }
+
+    // sessions signed by different members are recovered concurrently on the pool
+    std::vector<uint256> msgHashes;
+    std::vector<std::future<CBLSSignature>> recovered;
+    for (uint32_t s = 0; s < 8; s++) {
+        uint256 msgHash;
+        *((uint32_t*)msgHash.begin()) = s + 100;
+        msgHashes.emplace_back(msgHash);
+
+        std::vector<CBLSSignature> sigShares;
+        std::vector<CBLSId> sigIds;
+        for (size_t i = 0; i < threshold; i++) {
+            size_t member = (s + i) % ids.size();
+            sigShares.emplace_back(skShares[member].Sign(msgHash));
+            sigIds.emplace_back(ids[member]);
+        }
+        recovered.emplace_back(worker.Async([sigShares, sigIds]() {
+            CBLSSignature sig;
+            if (!sig.Recover(sigShares, sigIds)) {
+                return CBLSSignature();
+            }
+            return sig;
+        }));
+    }
+
+    for (size_t s = 0; s < recovered.size(); s++) {
+        CBLSSignature sig = recovered[s].get();
+        BOOST_CHECK(sig.IsValid());
+        BOOST_CHECK(sig == msk[0].Sign(msgHashes[s]));
+        BOOST_CHECK(sig.VerifyInsecure(msk[0].GetPublicKey(), msgHashes[s]));
+    }
+
+    worker.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -320,4 +320,36 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
 
 
 
+BOOST_AUTO_TEST_CASE(dbwrapper_profiles)
+{
+    CDBProfile profile;
+    BOOST_CHECK(!CDBProfile::FromName("fast", profile));
+
+    // every profile opens a working database
+    for (const std::string& strName : {"default", "lookup", "cold", "write"}) {
+        BOOST_CHECK(CDBProfile::FromName(strName, profile));
+        boost::filesystem::path ph = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        CDBWrapper dbw(ph, (1 << 20), true, false, false, profile);
+        uint256 in = GetRandHash();
+        uint256 res;
+        BOOST_CHECK(dbw.Write('k', in));
+        BOOST_CHECK(dbw.Read('k', res));
+        BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
+    }
+
+    // -dbprofile overrides the profile of a database only
+    std::string strError;
+    const char* argvValid[] = {"ignored", "-dbprofile=blockindex:write"};
+    ParseParameters(2, argvValid);
+    BOOST_CHECK(CheckDBProfileArgs(strError));
+    BOOST_CHECK_EQUAL(GetDBProfile("blockindex").nBlockCachePercent, 25);
+    BOOST_CHECK(!GetDBProfile("blockindex").fCompression);
+    BOOST_CHECK_EQUAL(GetDBProfile("chainstate").nBlockCachePercent, 75);
+
+    const char* argvInvalid[] = {"ignored", "-dbprofile=utxo:cold"};
+    ParseParameters(2, argvInvalid);
+    BOOST_CHECK(!CheckDBProfileArgs(strError));
+    ParseParameters(0, argvInvalid);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -16,6 +16,8 @@
 #include "evo/specialtx.h"
 #include "evo/providertx.h"
 #include "evo/deterministicmns.h"
+#include "evo/evodb.h"
+#include "llmq/quorums_utils.h"
 
 #include <boost/test/unit_test.hpp>
 
@@ -408,4 +410,104 @@ BOOST_FIXTURE_TEST_CASE(dip3_protx, TestChainDIP3Setup)
 
     const_cast<Consensus::Params&>(Params().GetConsensus()).DIP0003EnforcementHeight = DIP0003EnforcementHeightBackup;
 }
+
+BOOST_FIXTURE_TEST_CASE(dip3_list_for_block, TestChainDIP3Setup)
+{
+    auto utxos = BuildSimpleUtxoMap(coinbaseTxns);
+
+    // the first list is snapshotted where DIP3 activated, later ones are only stored as diffs
+    std::vector<uint256> dmnHashes;
+    std::vector<const CBlockIndex*> blocks;
+    for (int i = 0; i < 5; i++) {
+        CKey ownerKey;
+        CBLSSecretKey operatorKey;
+        auto tx = CreateProRegTx(utxos, i + 1, GenerateRandomAddress(), coinbaseKey, ownerKey, operatorKey);
+        dmnHashes.emplace_back(tx.GetHash());
+        CreateAndProcessBlock({tx}, coinbaseKey);
+        deterministicMNManager->UpdatedBlockTip(chainActive.Tip());
+        CreateAndProcessBlock({}, coinbaseKey);
+        deterministicMNManager->UpdatedBlockTip(chainActive.Tip());
+
+        LOCK(cs_main);
+        blocks.emplace_back(chainActive.Tip());
+    }
+
+    // a manager with an empty cache builds every list again from the snapshot and the diffs
+    CDeterministicMNManager coldManager(*evoDb);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        auto mnList = coldManager.GetListForBlock(blocks[i]);
+        BOOST_CHECK(mnList.GetBlockHash() == blocks[i]->GetBlockHash());
+        BOOST_CHECK_EQUAL(mnList.GetHeight(), blocks[i]->nHeight);
+        BOOST_CHECK_EQUAL(mnList.GetAllMNsCount(), i + 1);
+        for (size_t j = 0; j < dmnHashes.size(); j++) {
+            BOOST_CHECK_EQUAL(mnList.HasMN(dmnHashes[j]), j <= i);
+        }
+
+        auto cachedList = deterministicMNManager->GetListForBlock(blocks[i]);
+        BOOST_CHECK_EQUAL(cachedList.GetAllMNsCount(), mnList.GetAllMNsCount());
+    }
+
+    // lists below the cached ones are built from the snapshot again, this one is before the first registration
+    auto mnList = coldManager.GetListForBlock(blocks[0]->pprev->pprev);
+    BOOST_CHECK_EQUAL(mnList.GetAllMNsCount(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(dip3_quorum_members, TestChainDIP3Setup)
+{
+    auto utxos = BuildSimpleUtxoMap(coinbaseTxns);
+
+    int port = 1;
+    for (int i = 0; i < 3; i++) {
+        std::vector<CMutableTransaction> txns;
+        for (int j = 0; j < 3; j++) {
+            CKey ownerKey;
+            CBLSSecretKey operatorKey;
+            txns.emplace_back(CreateProRegTx(utxos, port++, GenerateRandomAddress(), coinbaseKey, ownerKey, operatorKey));
+        }
+        CreateAndProcessBlock(txns, coinbaseKey);
+        deterministicMNManager->UpdatedBlockTip(chainActive.Tip());
+    }
+
+    const CBlockIndex* pindexQuorum;
+    {
+        LOCK(cs_main);
+        pindexQuorum = chainActive.Tip();
+    }
+    auto mnList = deterministicMNManager->GetListForBlock(pindexQuorum);
+    BOOST_REQUIRE_EQUAL(mnList.GetValidMNsCount(), 9);
+
+    // partial selection gives the same order as sorting all scores
+    uint256 modifier = GetRandHash();
+    auto scores = mnList.CalculateScores(modifier);
+    std::sort(scores.begin(), scores.end(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+        if (a.first == b.first) {
+            return b.second->collateralOutpoint < a.second->collateralOutpoint;
+        }
+        return b.first < a.first;
+    });
+    for (size_t maxSize : {0, 1, 5, 9, 20}) {
+        auto quorum = mnList.CalculateQuorum(maxSize, modifier);
+        BOOST_REQUIRE_EQUAL(quorum.size(), std::min(maxSize, scores.size()));
+        for (size_t i = 0; i < quorum.size(); i++) {
+            BOOST_CHECK(quorum[i]->proTxHash == scores[i].second->proTxHash);
+        }
+    }
+
+    // members are calculated once, then served from the cache, and stored in evoDB
+    auto llmqType = Consensus::LLMQ_5_60;
+    auto& params = Params().GetConsensus().llmqs.at(llmqType);
+    auto expected = mnList.CalculateQuorum(params.size, ::SerializeHash(std::make_pair((uint8_t)llmqType, pindexQuorum->GetBlockHash())));
+    auto members = llmq::CLLMQUtils::GetAllQuorumMembers(llmqType, pindexQuorum);
+    auto cachedMembers = llmq::CLLMQUtils::GetAllQuorumMembers(llmqType, pindexQuorum);
+    std::vector<uint256> storedProTxHashes;
+    BOOST_REQUIRE(evoDb->GetRawDB().Read(std::make_pair(std::string("q_m"), std::make_pair((uint8_t)llmqType, pindexQuorum->GetBlockHash())), storedProTxHashes));
+    BOOST_REQUIRE_EQUAL(members.size(), expected.size());
+    BOOST_REQUIRE_EQUAL(cachedMembers.size(), expected.size());
+    BOOST_REQUIRE_EQUAL(storedProTxHashes.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        BOOST_CHECK(members[i]->proTxHash == expected[i]->proTxHash);
+        BOOST_CHECK(cachedMembers[i]->proTxHash == expected[i]->proTxHash);
+        BOOST_CHECK(storedProTxHashes[i] == expected[i]->proTxHash);
+    }
+}
 BOOST_AUTO_TEST_SUITE_END()
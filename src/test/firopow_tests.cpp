@@ -6,6 +6,11 @@
 #include <crypto/progpow/lib/ethash/ethash-internal.hpp>
 #include <crypto/progpow/include/ethash/progpow.hpp>
 #include <crypto/progpow/helpers.hpp>
+#include <crypto/progpow.h>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdio>
 
 BOOST_FIXTURE_TEST_SUITE(firpow_tests, BasicTestingSetup)
 BOOST_AUTO_TEST_CASE(firopow_hash_and_verify) {
@@ -39,4 +44,59 @@ BOOST_AUTO_TEST_CASE(firopow_hash_and_verify) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(firopow_epoch_cache) {
+
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::path lightFile = dir / "epoch-0.light";
+
+    // the first test cases are far enough from the end of epoch 0 not to start building epoch 1
+    auto checkHashes = [](CProgPowEpochCache& cache) {
+        for (int i = 0; i < 4; i++) {
+            const firopow_hash_test_case& t = firopow_hash_test_cases[i];
+            const ethash::hash256 header{to_hash256(t.header_hash_hex)};
+            const uint64_t nonce{std::stoull(t.nonce_hex, nullptr, 16)};
+            auto result{cache.Hash(t.block_number, header, nonce)};
+            BOOST_CHECK(ethash::is_equal(result.final_hash, to_hash256(t.final_hash_hex)));
+            BOOST_CHECK(ethash::is_equal(result.mix_hash, to_hash256(t.mix_hash_hex)));
+        }
+    };
+
+    {
+        // builds the context and writes it
+        CProgPowEpochCache cache;
+        BOOST_CHECK(cache.Init(dir.string(), false));
+        checkHashes(cache);
+        BOOST_CHECK(!cache.HasFullDataset(0));
+    }
+#ifndef WIN32
+    BOOST_CHECK(boost::filesystem::exists(lightFile));
+    std::time_t nWriteTime = boost::filesystem::last_write_time(lightFile);
+
+    {
+        // maps the context written before
+        CProgPowEpochCache cache;
+        BOOST_CHECK(cache.Init(dir.string(), false));
+        checkHashes(cache);
+    }
+    BOOST_CHECK_EQUAL(boost::filesystem::last_write_time(lightFile), nWriteTime);
+
+    {
+        // a corrupted context is detected and built again
+        FILE* file = fopen(lightFile.string().c_str(), "r+b");
+        BOOST_REQUIRE(file);
+        fseek(file, 1 << 20, SEEK_SET);
+        int c = fgetc(file);
+        fseek(file, 1 << 20, SEEK_SET);
+        fputc(c ^ 0x01, file);
+        fclose(file);
+
+        CProgPowEpochCache cache;
+        BOOST_CHECK(cache.Init(dir.string(), false));
+        checkHashes(cache);
+    }
+#endif
+
+    boost::filesystem::remove_all(dir);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
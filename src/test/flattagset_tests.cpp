@@ -0,0 +1,62 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "lelantus.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+
+BOOST_FIXTURE_TEST_SUITE(flattagset_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(insert_find_erase)
+{
+    lelantus::UsedSerialSet serials;
+    std::map<uint64_t, int> expected;
+
+    // grows several times and erases from the middle of probe sequences
+    for (uint64_t i = 1; i <= 1000; i++) {
+        serials.insert(Scalar(i), int(i % 7));
+        expected[i] = int(i % 7);
+    }
+    for (uint64_t i = 1; i <= 1000; i += 3) {
+        BOOST_CHECK(serials.erase(Scalar(i)));
+        expected.erase(i);
+    }
+    BOOST_CHECK(!serials.erase(Scalar(uint64_t(1))));
+    // updates the group id and reuses erased entries
+    serials.insert(Scalar(uint64_t(2)), 100);
+    expected[2] = 100;
+    serials.insert(Scalar(uint64_t(1)), 5);
+    expected[1] = 5;
+
+    BOOST_CHECK_EQUAL(serials.size(), expected.size());
+    for (uint64_t i = 1; i <= 1001; i++) {
+        int nGroupId = -1;
+        bool fFound = serials.Find(Scalar(i), nGroupId);
+        BOOST_CHECK_EQUAL(fFound, expected.count(i) != 0);
+        if (fFound)
+            BOOST_CHECK_EQUAL(nGroupId, expected[i]);
+    }
+
+    Scalar serial;
+    BOOST_CHECK(serials.FindHash(serial, primitives::GetSerialHash(Scalar(uint64_t(500)))));
+    BOOST_CHECK(serial == Scalar(uint64_t(500)));
+    BOOST_CHECK(!serials.FindHash(serial, primitives::GetSerialHash(Scalar(uint64_t(499)))));
+
+    size_t nCount = 0;
+    serials.ForEach([&](const Scalar& s, int) {
+        nCount++;
+        BOOST_CHECK(serials.count(s));
+    });
+    BOOST_CHECK_EQUAL(nCount, expected.size());
+
+    serials.clear();
+    BOOST_CHECK(serials.empty());
+    BOOST_CHECK(!serials.count(Scalar(uint64_t(2))));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
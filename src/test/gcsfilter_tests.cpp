@@ -0,0 +1,109 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gcsfilter.h"
+#include "streams.h"
+#include "test/test_bitcoin.h"
+#include "test/test_random.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(gcsfilter_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(gcsfilter_test)
+{
+    GCSFilter::ElementSet included_elements, excluded_elements;
+    for (int i = 0; i < 100; ++i) {
+        GCSFilter::Element element1(32);
+        element1[0] = i;
+        included_elements.insert(std::move(element1));
+
+        GCSFilter::Element element2(32);
+        element2[1] = i;
+        excluded_elements.insert(std::move(element2));
+    }
+
+    GCSFilter filter({0, 0, 10, 1 << 10}, included_elements);
+    for (const auto& element : included_elements) {
+        BOOST_CHECK(filter.Match(element));
+
+        auto insertion = excluded_elements.insert(element);
+        BOOST_CHECK(filter.MatchAny(excluded_elements));
+        excluded_elements.erase(insertion.first);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor)
+{
+    GCSFilter filter;
+    BOOST_CHECK_EQUAL(filter.GetN(), 0);
+    BOOST_CHECK_EQUAL(filter.GetEncoded().size(), 1);
+
+    const GCSFilter::Params& params = filter.GetParams();
+    BOOST_CHECK_EQUAL(params.m_siphash_k0, 0);
+    BOOST_CHECK_EQUAL(params.m_siphash_k1, 0);
+    BOOST_CHECK_EQUAL(params.m_P, 0);
+    BOOST_CHECK_EQUAL(params.m_M, 1);
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_encoding_roundtrip)
+{
+    GCSFilter::ElementSet elements;
+    for (int i = 0; i < 500; ++i) {
+        GCSFilter::Element element(34);
+        for (auto& c : element)
+            c = insecure_rand();
+        elements.insert(std::move(element));
+    }
+
+    GCSFilter filter({insecure_rand(), insecure_rand(), 19, 784931}, elements);
+    GCSFilter decoded(filter.GetParams(), filter.GetEncoded());
+    BOOST_CHECK_EQUAL(decoded.GetN(), elements.size());
+    for (const auto& element : elements)
+        BOOST_CHECK(decoded.Match(element));
+
+    // truncated or padded encodings are rejected
+    std::vector<unsigned char> truncated(filter.GetEncoded().begin(), filter.GetEncoded().end() - 1);
+    BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), truncated), std::ios_base::failure);
+    std::vector<unsigned char> padded(filter.GetEncoded());
+    padded.push_back(0);
+    BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), padded), std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(bitstream_reader_writer)
+{
+    CDataStream stream(SER_NETWORK, INIT_PROTO_VERSION);
+
+    BitStreamWriter<CDataStream> bitwriter(stream);
+    bitwriter.Write(0, 1);
+    bitwriter.Write(2, 2);
+    bitwriter.Write(6, 3);
+    bitwriter.Write(11, 4);
+    bitwriter.Write(1, 5);
+    bitwriter.Write(32, 6);
+    bitwriter.Write(7, 7);
+    bitwriter.Write(30497, 16);
+    bitwriter.Flush();
+
+    CDataStream serialized_int1(SER_NETWORK, INIT_PROTO_VERSION);
+    serialized_int1 << uint32_t{0x7700C35A}; // NOTE: Serialized as LE
+    CDataStream serialized_int2(SER_NETWORK, INIT_PROTO_VERSION);
+    serialized_int2 << uint16_t{0x1072}; // NOTE: Serialized as LE
+
+    BOOST_CHECK_EQUAL(serialized_int1.str(), stream.str().substr(0, 4));
+    BOOST_CHECK_EQUAL(serialized_int2.str(), stream.str().substr(4, 2));
+
+    BitStreamReader<CDataStream> bitreader(stream);
+    BOOST_CHECK_EQUAL(bitreader.Read(1), 0);
+    BOOST_CHECK_EQUAL(bitreader.Read(2), 2);
+    BOOST_CHECK_EQUAL(bitreader.Read(3), 6);
+    BOOST_CHECK_EQUAL(bitreader.Read(4), 11);
+    BOOST_CHECK_EQUAL(bitreader.Read(5), 1);
+    BOOST_CHECK_EQUAL(bitreader.Read(6), 32);
+    BOOST_CHECK_EQUAL(bitreader.Read(7), 7);
+    BOOST_CHECK_EQUAL(bitreader.Read(16), 30497);
+    BOOST_CHECK_THROW(bitreader.Read(8), std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
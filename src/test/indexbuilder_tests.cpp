@@ -0,0 +1,77 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "indexbuilder.h"
+#include "script/standard.h"
+#include "validation.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(indexbuilder_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(build_and_enable)
+{
+    BOOST_CHECK(!fAddressIndex && !fSpentIndex && !fTimestampIndex);
+
+    CIndexBuilder builder(true, true, true, 2);
+    BOOST_CHECK(builder.Run());
+    BOOST_CHECK(fAddressIndex && fAddressBalanceIndex && fSpentIndex && fTimestampIndex);
+    CIndexBuilderProgress progress;
+    BOOST_CHECK(!pblocktree->ReadIndexBuilderProgress(progress));
+
+    // the coinbase outputs paid to the key are all there
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    size_t nOutputs = 0;
+    CAmount nValue = 0;
+    for (const CTransaction& tx : coinbaseTxns) {
+        for (const CTxOut& out : tx.vout) {
+            if (out.scriptPubKey == scriptPubKey) {
+                nOutputs++;
+                nValue += out.nValue;
+            }
+        }
+    }
+    uint160 hash = coinbaseKey.GetPubKey().GetID();
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    BOOST_CHECK(GetAddressIndex(hash, AddressType::payToPubKeyHash, addressIndex));
+    BOOST_CHECK_EQUAL(addressIndex.size(), nOutputs);
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
+    BOOST_CHECK(GetAddressUnspent(hash, AddressType::payToPubKeyHash, unspentOutputs));
+    BOOST_CHECK_EQUAL(unspentOutputs.size(), nOutputs);
+
+    CAddressBalance balance;
+    BOOST_CHECK(GetAddressBalance(hash, AddressType::payToPubKeyHash, balance));
+    BOOST_CHECK_EQUAL(balance.balance, nValue);
+    BOOST_CHECK_EQUAL(balance.txCount, (int64_t)coinbaseTxns.size());
+    BOOST_CHECK_EQUAL(balance.utxoCount, (int64_t)nOutputs);
+
+    std::vector<uint256> hashes;
+    BOOST_CHECK(GetTimestampIndex(chainActive.Tip()->nTime, chainActive[1]->nTime, hashes));
+    BOOST_CHECK(std::find(hashes.begin(), hashes.end(), chainActive.Tip()->GetBlockHash()) != hashes.end());
+
+    // ConnectBlock keeps the indexes from now on
+    CreateAndProcessBlock({}, scriptPubKey);
+    addressIndex.clear();
+    BOOST_CHECK(GetAddressIndex(hash, AddressType::payToPubKeyHash, addressIndex));
+    BOOST_CHECK(addressIndex.size() > nOutputs);
+    BOOST_CHECK_EQUAL(addressIndex.back().first.blockHeight, chainActive.Height());
+
+    // connecting the last blocks again, as -checklevel=4 does, leaves the totals as they are
+    BOOST_CHECK(GetAddressBalance(hash, AddressType::payToPubKeyHash, balance));
+    {
+        LOCK(cs_main);
+        FlushStateToDisk();
+        BOOST_CHECK(CVerifyDB().VerifyDB(Params(), pcoinsdbview, 4, 3));
+    }
+    CAddressBalance balanceAfter;
+    BOOST_CHECK(GetAddressBalance(hash, AddressType::payToPubKeyHash, balanceAfter));
+    BOOST_CHECK_EQUAL(balanceAfter.balance, balance.balance);
+    BOOST_CHECK_EQUAL(balanceAfter.txCount, balance.txCount);
+
+    fAddressIndex = fAddressBalanceIndex = fSpentIndex = fTimestampIndex = false;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bls/bls.h"
+#include "dbwrapper.h"
+#include "llmq/quorums_instantsend.h"
+#include "random.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+static std::pair<uint256, CInstantSendLock> MakeInstantSendLock()
+{
+    CInstantSendLock islock;
+    islock.txid = GetRandHash();
+    islock.inputs.emplace_back(GetRandHash(), 0);
+    islock.inputs.emplace_back(GetRandHash(), 1);
+
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    islock.sig.Set(sk.Sign(islock.GetRequestId()));
+
+    return std::make_pair(::SerializeHash(islock), islock);
+}
+
+BOOST_FIXTURE_TEST_SUITE(llmq_instantsend_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(islock_removed_after_mined)
+{
+    CDBWrapper llmqDb(GetDataDir() / "llmq", 1 << 20, true);
+    CInstantSendDb db(llmqDb);
+
+    auto p = MakeInstantSendLock();
+    auto& hash = p.first;
+    auto& islock = p.second;
+    db.WriteNewInstantSendLock(hash, islock);
+    db.WriteInstantSendLockMined(hash, 10);
+
+    // the lookups cache the lock
+    BOOST_CHECK(db.GetInstantSendLockByHash(hash) != nullptr);
+    BOOST_CHECK(db.GetInstantSendLockHashByTxid(islock.txid) == hash);
+    BOOST_CHECK(db.GetInstantSendLockByInput(islock.inputs[1]) != nullptr);
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), 1);
+
+    // not confirmed deep enough yet
+    BOOST_CHECK(db.RemoveConfirmedInstantSendLocks(9).empty());
+    BOOST_CHECK(db.GetInstantSendLockByTxid(islock.txid) != nullptr);
+
+    auto removed = db.RemoveConfirmedInstantSendLocks(10);
+    BOOST_CHECK_EQUAL(removed.size(), 1);
+    BOOST_CHECK(removed.count(hash));
+
+    BOOST_CHECK(db.GetInstantSendLockByHash(hash) == nullptr);
+    BOOST_CHECK(db.GetInstantSendLockHashByTxid(islock.txid).IsNull());
+    BOOST_CHECK(db.GetInstantSendLockByTxid(islock.txid) == nullptr);
+    for (auto& in : islock.inputs) {
+        BOOST_CHECK(db.GetInstantSendLockByInput(in) == nullptr);
+    }
+    BOOST_CHECK(db.HasArchivedInstantSendLock(hash));
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(islock_cache_eviction)
+{
+    // one entry per shard, truncated once a shard holds more than two
+    CShardedLRUCache<uint256, uint256, StaticSaltedHasher> cache(16);
+    std::vector<uint256> keys;
+    for (int i = 0; i < 1000; i++) {
+        keys.emplace_back(GetRandHash());
+        cache.Insert(keys.back(), keys.back());
+    }
+    BOOST_CHECK(cache.Size() <= 3 * 16);
+
+    // the last key inserted is still cached, most of the others have to be loaded again
+    int loads = 0;
+    auto load = [&]() { loads++; return uint256(); };
+    BOOST_CHECK(cache.Get(keys.back(), load) == keys.back());
+    BOOST_CHECK_EQUAL(loads, 0);
+    for (auto& key : keys) {
+        cache.Get(key, load);
+    }
+    BOOST_CHECK(loads >= 1000 - 3 * 16);
+    BOOST_CHECK(cache.Size() <= 3 * 16);
+
+    // evicted locks are read from the DB again
+    CDBWrapper llmqDb(GetDataDir() / "llmq", 1 << 20, true);
+    CInstantSendDb db(llmqDb, 16);
+    std::vector<std::pair<uint256, CInstantSendLock>> islocks;
+    for (int i = 0; i < 100; i++) {
+        islocks.emplace_back(MakeInstantSendLock());
+        db.WriteNewInstantSendLock(islocks.back().first, islocks.back().second);
+    }
+    for (auto& p : islocks) {
+        auto islock = db.GetInstantSendLockByInput(p.second.inputs[0]);
+        BOOST_CHECK(islock != nullptr && islock->txid == p.second.txid);
+        BOOST_CHECK(db.GetInstantSendLockHashByTxid(p.second.txid) == p.first);
+    }
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), islocks.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
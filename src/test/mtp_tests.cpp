@@ -3,6 +3,10 @@
 #include "random.h"
 #include <iostream>
 #include <boost/test/unit_test.hpp>
+// last, the BLAKE2 round macros of ref.h clash with names used by other headers
+extern "C" {
+#include "crypto/MerkleTreeProof/ref.h"
+}
 
 using namespace std;
 
@@ -94,5 +98,23 @@ BOOST_AUTO_TEST_CASE(mtp_block_integrity_test)
     BOOST_CHECK(false == mtp::verify(block3.nNonce+1, block3, pow_limit));
 }
 
+BOOST_AUTO_TEST_CASE(mtp_fill_block_matches_ref)
+{
+    // fill_block_mtp is the SIMD version in builds targeting SSSE3 or later, the reference one otherwise
+    for (int i = 0; i < 100; i++) {
+        block prev, ref, next, nextRef;
+        uint8_t h0[ARGON2_PREHASH_DIGEST_LENGTH];
+        GetRandBytes((unsigned char*)prev.v, sizeof(prev.v));
+        GetRandBytes((unsigned char*)ref.v, sizeof(ref.v));
+        GetRandBytes((unsigned char*)next.v, sizeof(next.v));
+        GetRandBytes(h0, sizeof(h0));
+        copy_block(&nextRef, &next);
+        uint32_t blockIndex = (uint32_t)GetRand(1u << 22);
+
+        fill_block_mtp(&prev, &ref, &next, i % 2, blockIndex, h0);
+        fill_block_mtp_ref(&prev, &ref, &nextRef, i % 2, blockIndex, h0);
+        BOOST_CHECK(memcmp(next.v, nextRef.v, sizeof(next.v)) == 0);
+    }
+}
 
 BOOST_AUTO_TEST_SUITE_END()
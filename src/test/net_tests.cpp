@@ -9,6 +9,7 @@
 #include "serialize.h"
 #include "streams.h"
 #include "net.h"
+#include "net_processing.h"
 #include "netbase.h"
 #include "chainparams.h"
 
@@ -172,4 +173,54 @@ BOOST_AUTO_TEST_CASE(cnode_simple_test)
     BOOST_CHECK(pnode2->fFeeler == false);
 }
 
+
+static void PushTestMessage(CNode& node, const char* pszCommand)
+{
+    CNetMessage msg(Params().MessageStart(), SER_NETWORK, INIT_PROTO_VERSION);
+    msg.hdr = CMessageHeader(Params().MessageStart(), pszCommand, 0);
+    LOCK(node.cs_vProcessMsg);
+    node.vProcessMsg.push_back(std::move(msg));
+}
+
+BOOST_AUTO_TEST_CASE(cnode_concurrent_processing_test)
+{
+    in_addr ipv4Addr;
+    ipv4Addr.s_addr = 0xa0b0c001;
+    CAddress addr = CAddress(CService(ipv4Addr, 7777), NODE_NETWORK);
+
+    CNode node(0, NODE_NETWORK, 0, INVALID_SOCKET, addr, 0, 0, "", true);
+
+    // Nothing is handed off before the handshake completes
+    PushTestMessage(node, NetMsgType::GETDATA);
+    BOOST_CHECK(!CanProcessMessagesConcurrently(&node));
+
+    node.fSuccessfullyConnected = true;
+    BOOST_CHECK(CanProcessMessagesConcurrently(&node));
+
+    // A state-changing message at the front keeps the node on the handler thread
+    {
+        LOCK(node.cs_vProcessMsg);
+        node.vProcessMsg.clear();
+    }
+    BOOST_CHECK(!CanProcessMessagesConcurrently(&node));
+    PushTestMessage(node, NetMsgType::TX);
+    PushTestMessage(node, NetMsgType::GETHEADERS);
+    BOOST_CHECK(!CanProcessMessagesConcurrently(&node));
+
+    // Only the front of the queue is considered
+    {
+        LOCK(node.cs_vProcessMsg);
+        node.vProcessMsg.pop_front();
+    }
+    BOOST_CHECK(CanProcessMessagesConcurrently(&node));
+
+    // Pending getdata work is always read-only
+    {
+        LOCK(node.cs_vProcessMsg);
+        node.vProcessMsg.clear();
+    }
+    node.vRecvGetData.push_back(CInv(MSG_BLOCK, uint256()));
+    BOOST_CHECK(CanProcessMessagesConcurrently(&node));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,58 @@
+// Copyright (c) 2024 The Firo Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "consensus/validation.h"
+#include "random.h"
+#include "txdb.h"
+#include "validation.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(powhashdb_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(pending_and_flushed)
+{
+    CPoWHashDB db(1 << 20, true);
+    uint256 blockHash = GetRandHash(), powHash = GetRandHash(), readHash;
+    BOOST_CHECK(!db.ReadPoWHash(blockHash, readHash));
+
+    // served from memory before the flush and from the database after it
+    db.AddPoWHash(blockHash, powHash);
+    BOOST_CHECK(db.ReadPoWHash(blockHash, readHash));
+    BOOST_CHECK(readHash == powHash);
+    BOOST_CHECK(db.Flush());
+    readHash.SetNull();
+    BOOST_CHECK(db.ReadPoWHash(blockHash, readHash));
+    BOOST_CHECK(readHash == powHash);
+    BOOST_CHECK(!db.ReadPoWHash(GetRandHash(), readHash));
+}
+
+BOOST_AUTO_TEST_CASE(header_check_uses_verified_hash)
+{
+    // a Lyra2Z header that doesn't meet its target
+    CBlockHeader header;
+    header.nVersion = 2;
+    header.hashPrevBlock = GetRandHash();
+    header.nTime = 1500000000;
+    header.nBits = 0x1d00ffff;
+
+    LOCK(cs_main);
+    const Consensus::Params& params = Params().GetConsensus();
+    CValidationState state;
+    BOOST_CHECK(!CheckBlockHeader(header, state, params));
+
+    // once the header is recorded as verified its hash isn't computed again
+    ppowhashdb = new CPoWHashDB(1 << 20, true);
+    ppowhashdb->AddPoWHash(header.GetHash(), uint256S("01"));
+    CBlockHeader verifiedHeader(header);
+    verifiedHeader.cachedPoWHash.SetNull();
+    BOOST_CHECK(CheckBlockHeader(verifiedHeader, state, params));
+    delete ppowhashdb;
+    ppowhashdb = nullptr;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
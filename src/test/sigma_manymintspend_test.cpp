@@ -193,7 +193,7 @@ BOOST_AUTO_TEST_CASE(sigma_mintspend_many)
         BOOST_CHECK_MESSAGE(mempool.size() == 0, "Mempool not empty although mempool should reject double spend");
 
         //Temporary disable usedCoinSerials check to force double spend in mempool
-        auto tempSerials = sigmaState->GetSpends();
+        auto tempSerials = sigmaState->GetUnfrozenSpends();
         sigmaState->containers.usedCoinSerials.clear();
 
         wtx.Init(NULL);
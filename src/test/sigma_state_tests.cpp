@@ -4,6 +4,7 @@
 #include "../validation.h"
 #include "../secp256k1/include/Scalar.h"
 #include "../sigma.h"
+#include "../primitives/mint_spend.h"
 #include "./test_bitcoin.h"
 #include "../wallet/wallet.h"
 
@@ -77,9 +78,9 @@ BOOST_AUTO_TEST_CASE(sigma_addspend)
     sigma::CoinSpend coin(params, privcoin, anonymity_set, metaData, true);
 
     auto coinSerial = coin.getCoinSerialNumber();
-    auto initSize = sigmaState->GetSpends().count(coinSerial);
+    auto initSize = sigmaState->GetUnfrozenSpends().count(coinSerial);
     sigmaState->AddSpend(coinSerial, pubcoin.getDenomination(), 0);
-    auto actSize = sigmaState->GetSpends().count(coinSerial);
+    auto actSize = sigmaState->GetUnfrozenSpends().count(coinSerial);
 
     BOOST_CHECK_MESSAGE(initSize + 1 == actSize, "Serial was not added to usedCoinSerials.");
     sigmaState->Reset();
@@ -173,13 +174,13 @@ BOOST_AUTO_TEST_CASE(sigma_addmint_double)
     auto mintsBlock = CreateBlockWithMints({pubcoin});
 
     sigmaState->AddMintsToStateAndBlockIndex(&index, &mintsBlock);
-    auto mintedPubCoin = sigmaState->GetMints();
+    auto mintedPubCoin = sigmaState->GetUnfrozenMints();
 
     BOOST_CHECK_MESSAGE(mintedPubCoin.size() == 1,
         "Unexpected mintedPubCoin size after first call.");
 
     sigmaState->AddMintsToStateAndBlockIndex(&index, &mintsBlock);
-    mintedPubCoin = sigmaState->GetMints();
+    mintedPubCoin = sigmaState->GetUnfrozenMints();
 
     BOOST_CHECK_MESSAGE(mintedPubCoin.size() == 1,
          "Unexpected mintedPubCoin size after second call.");
@@ -207,7 +208,7 @@ BOOST_AUTO_TEST_CASE(sigma_addmint_two)
     CBlockIndex index = CreateBlockIndex(1);
     sigmaState->AddMintsToStateAndBlockIndex(&index, &mintsBlock);
 
-    auto mintedPubCoin = sigmaState->GetMints();
+    auto mintedPubCoin = sigmaState->GetUnfrozenMints();
 
     BOOST_CHECK_MESSAGE(mintedPubCoin.size() == 2, "Unexpected mintedPubCoin size.");
 
@@ -507,7 +508,7 @@ BOOST_AUTO_TEST_CASE(sigma_reset)
     auto mintsBlock = CreateBlockWithMints({pubcoin});
     sigmaState->AddMintsToStateAndBlockIndex(&index, &mintsBlock);
 
-    BOOST_CHECK_MESSAGE(sigmaState->GetMints().size() == 1,
+    BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenMints().size() == 1,
       "Unexpected mintedPubCoin size before reset.");
     BOOST_CHECK_MESSAGE(sigmaState->GetCoinGroups().size() == 1,
       "Unexpected coinGroups size before reset.");
@@ -529,18 +530,18 @@ BOOST_AUTO_TEST_CASE(sigma_reset)
 
     sigmaState->AddSpend(coinSerial, pubcoin.getDenomination(), 0);
 
-    BOOST_CHECK_MESSAGE(sigmaState->GetSpends().size() == 1,
+    BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenSpends().size() == 1,
       "Unexpected usedCoinSerials size before reset.");
     BOOST_CHECK_MESSAGE(sigmaState->GetLatestCoinIds().size() == 1,
       "Unexpected mintedPubCoin size before reset.");
 
     sigmaState->Reset();
 
-    BOOST_CHECK_MESSAGE(sigmaState->GetMints().size() == 0,
+    BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenMints().size() == 0,
       "Unexpected mintedPubCoin size after reset.");
     BOOST_CHECK_MESSAGE(sigmaState->GetCoinGroups().size() == 0,
       "Unexpected coinGroups size after reset.");
-    BOOST_CHECK_MESSAGE(sigmaState->GetSpends().size() == 0,
+    BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenSpends().size() == 0,
       "Unexpected usedCoinSerials size after reset.");
     BOOST_CHECK_MESSAGE(sigmaState->GetLatestCoinIds().size() == 0,
       "Unexpected mintedPubCoin size after reset.");
@@ -562,7 +563,7 @@ BOOST_AUTO_TEST_CASE(sigma_getcoingroupinfo_existing)
     auto mintsBlock = CreateBlockWithMints({pubcoin});
 
     sigmaState->AddMintsToStateAndBlockIndex(&index, &mintsBlock);
-    auto mintedPubCoin = sigmaState->GetMints();
+    auto mintedPubCoin = sigmaState->GetUnfrozenMints();
 
     BOOST_CHECK_MESSAGE(mintedPubCoin.size() == 1,
         "Unexpected mintedPubCoin size after first call.");
@@ -611,10 +612,10 @@ BOOST_AUTO_TEST_CASE(sigma_addblock_nonexist_index)
     CBlockIndex index = CreateBlockIndex(1);
 
 	sigmaState->AddBlock(&index);
-	BOOST_CHECK_MESSAGE(sigmaState->GetMints().size() == 0,
+	BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenMints().size() == 0,
 	  "Unexpected mintedPubCoins size, add new block without minted txs.");
 
-	BOOST_CHECK_MESSAGE(sigmaState->GetSpends().size() == 0,
+	BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenSpends().size() == 0,
 	  "Unexpected usedCoinSerials size, add new block without spend txs.");
 
     sigmaState->Reset();
@@ -642,10 +643,10 @@ BOOST_AUTO_TEST_CASE(sigma_addblock_minted_spend)
 	index.sigmaMintedPubCoins[denomination1Group1].push_back(pubcoin2);
 
 	sigmaState->AddBlock(&index);
-	BOOST_CHECK_MESSAGE(sigmaState->GetMints().size() == 2,
+	BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenMints().size() == 2,
 	  "Unexpected mintedPubCoins size, add new block with 2 minted txs.");
 
-	BOOST_CHECK_MESSAGE(sigmaState->GetSpends().size() == 0,
+	BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenSpends().size() == 0,
 	  "Unexpected usedCoinSerials size, add new block without spend txs.");
 
 	// spend
@@ -665,10 +666,10 @@ BOOST_AUTO_TEST_CASE(sigma_addblock_minted_spend)
 	index2.sigmaSpentSerials.clear();
 	index2.sigmaSpentSerials.insert(std::make_pair(spendSerial, sigma::CSpendCoinInfo::make(coinSpend.getDenomination(), 0)));
 	sigmaState->AddBlock(&index2);
-	BOOST_CHECK_MESSAGE(sigmaState->GetMints().size() == 2,
+	BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenMints().size() == 2,
 	  "Unexpected mintedPubCoins size, add new block without additional minted.");
 
-	BOOST_CHECK_MESSAGE(sigmaState->GetSpends().size() == 1,
+	BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenSpends().size() == 1,
 	  "Unexpected usedCoinSerials size, add new block with 1 spend txs.");
 
     // minted more coin
@@ -679,10 +680,10 @@ BOOST_AUTO_TEST_CASE(sigma_addblock_minted_spend)
 
     index3.sigmaMintedPubCoins[denomination1Group1].push_back(pubcoin3);
     sigmaState->AddBlock(&index3);
-    BOOST_CHECK_MESSAGE(sigmaState->GetMints().size() == 3,
+    BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenMints().size() == 3,
 	  "Unexpected mintedPubCoins size, add new block with one more minted.");
 
-	BOOST_CHECK_MESSAGE(sigmaState->GetSpends().size() == 1,
+	BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenSpends().size() == 1,
 	  "Unexpected usedCoinSerials size, add new block without new spend");
 
     sigmaState->Reset();
@@ -728,10 +729,10 @@ BOOST_AUTO_TEST_CASE(sigma_removeblock_remove)
 
     // remove one
     sigmaState->RemoveBlock(&index2);
-    BOOST_CHECK_MESSAGE(sigmaState->GetMints().size() == 10,
+    BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenMints().size() == 10,
 	  "Unexpected mintedPubCoins size, remove index contain 10 minteds.");
 
-    BOOST_CHECK_MESSAGE(sigmaState->GetSpends().size() == 0,
+    BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenSpends().size() == 0,
       "Unexpected usedCoinSerials size, remove index contain 1 spend.");
 
     BOOST_CHECK_MESSAGE(sigmaState->GetLatestCoinIds().find(sigma::CoinDenomination::SIGMA_DENOM_1)->second == 1,
@@ -744,10 +745,10 @@ BOOST_AUTO_TEST_CASE(sigma_removeblock_remove)
 
     // remove all
     sigmaState->RemoveBlock(&index1);
-    BOOST_CHECK_MESSAGE(sigmaState->GetMints().size() == 0,
+    BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenMints().size() == 0,
 	  "Unexpected mintedPubCoins size, remove index contain 10 minteds.");
 
-	BOOST_CHECK_MESSAGE(sigmaState->GetSpends().size() == 0,
+	BOOST_CHECK_MESSAGE(sigmaState->GetUnfrozenSpends().size() == 0,
 	  "Unexpected usedCoinSerials size, remove index contain no spend.");
 
     BOOST_CHECK_MESSAGE(sigmaState->GetLatestCoinIds().find(sigma::CoinDenomination::SIGMA_DENOM_1) == sigmaState->GetLatestCoinIds().end(),
@@ -1217,5 +1218,135 @@ BOOST_AUTO_TEST_CASE(sigma_surge_detection_failure_anywhere)
     sigmaState->Reset();
 }
 
+BOOST_AUTO_TEST_CASE(sigma_frozen_state)
+{
+    sigma::CSigmaState *sigmaState = sigma::CSigmaState::GetState();
+    auto params = sigma::Params::get_default();
+
+    std::vector<sigma::PrivateCoin> privCoins = generateCoins(params, 10, sigma::CoinDenomination::SIGMA_DENOM_1);
+    std::vector<sigma::PublicCoin> pubCoins = getPubcoins(privCoins);
+    CBlockIndex index = CreateBlockIndex(1);
+    CBlock mintsBlock = CreateBlockWithMints(pubCoins);
+    sigmaState->AddMintsToStateAndBlockIndex(&index, &mintsBlock);
+
+    std::vector<Scalar> serials(10);
+    for (Scalar& serial : serials) {
+        serial.randomize();
+        sigmaState->AddSpend(serial, sigma::CoinDenomination::SIGMA_DENOM_1, 1);
+    }
+
+    boost::filesystem::path path = GetDataDir() / "sigma_frozen_test.dat";
+    uint256 blockHash = uint256S("0102");
+    BOOST_REQUIRE(sigma::CSigmaFrozenState::Write(path, sigmaState->GetUnfrozenMints(), sigmaState->GetUnfrozenSpends(), 1, blockHash));
+    std::unique_ptr<sigma::CSigmaFrozenState> frozenState = sigma::CSigmaFrozenState::Open(path);
+    BOOST_REQUIRE(frozenState);
+    BOOST_CHECK_EQUAL(frozenState->GetHeight(), 1);
+    BOOST_CHECK(frozenState->GetBlockHash() == blockHash);
+    BOOST_CHECK_EQUAL(frozenState->GetMintCount(), 10);
+    BOOST_CHECK_EQUAL(frozenState->GetSpendCount(), 10);
+
+    for (const sigma::PublicCoin& pubCoin : pubCoins) {
+        sigma::CMintedCoinInfo coinInfo;
+        BOOST_CHECK(frozenState->FindMint(pubCoin, coinInfo));
+        BOOST_CHECK_EQUAL(coinInfo.coinGroupId, 1);
+        BOOST_CHECK_EQUAL(coinInfo.nHeight, 1);
+        GroupElement pubCoinValue;
+        BOOST_CHECK(frozenState->FindMintByHash(pubCoinValue, pubCoin.getValueHash()));
+        BOOST_CHECK(pubCoinValue == pubCoin.getValue());
+        // the denomination is part of the key
+        BOOST_CHECK(!frozenState->FindMint(sigma::PublicCoin(pubCoin.getValue(), sigma::CoinDenomination::SIGMA_DENOM_10), coinInfo));
+    }
+    for (const Scalar& serial : serials) {
+        sigma::CSpendCoinInfo coinInfo;
+        BOOST_CHECK(frozenState->FindSpend(serial, coinInfo));
+        BOOST_CHECK(coinInfo.denomination == sigma::CoinDenomination::SIGMA_DENOM_1);
+        Scalar found;
+        BOOST_CHECK(frozenState->FindSpendByHash(found, primitives::GetSerialHash(serial)));
+        BOOST_CHECK(found == serial);
+    }
+
+    sigma::CSpendCoinInfo spendInfo;
+    Scalar unknownSerial;
+    unknownSerial.randomize();
+    BOOST_CHECK(!frozenState->FindSpend(unknownSerial, spendInfo));
+    BOOST_CHECK(!frozenState->FindSpendByHash(unknownSerial, uint256S("0102")));
+
+    // a damaged file isn't used
+    frozenState.reset();
+    FILE* file = fopen(path.string().c_str(), "r+b");
+    BOOST_REQUIRE(file);
+    fseek(file, -1, SEEK_END);
+    fputc(0xff, file);
+    fclose(file);
+    BOOST_CHECK(!sigma::CSigmaFrozenState::Open(path));
+
+    boost::filesystem::remove(path);
+    sigmaState->Reset();
+}
+
+BOOST_AUTO_TEST_CASE(sigma_freeze_and_thaw)
+{
+    sigma::CSigmaState *sigmaState = sigma::CSigmaState::GetState();
+    auto params = sigma::Params::get_default();
+
+    std::vector<sigma::PublicCoin> pubCoins1 = getPubcoins(generateCoins(params, 5, sigma::CoinDenomination::SIGMA_DENOM_1));
+    std::vector<sigma::PublicCoin> pubCoins2 = getPubcoins(generateCoins(params, 5, sigma::CoinDenomination::SIGMA_DENOM_1));
+    CBlockIndex index1 = CreateBlockIndex(1);
+    CBlock block1 = CreateBlockWithMints(pubCoins1);
+    sigmaState->AddMintsToStateAndBlockIndex(&index1, &block1);
+    CBlockIndex index2 = CreateBlockIndex(2);
+    CBlock block2 = CreateBlockWithMints(pubCoins2);
+    sigmaState->AddMintsToStateAndBlockIndex(&index2, &block2);
+
+    std::vector<Scalar> serials(5);
+    for (Scalar& serial : serials) {
+        serial.randomize();
+        sigmaState->AddSpend(serial, sigma::CoinDenomination::SIGMA_DENOM_1, 1);
+    }
+
+    // a chain just past the freeze depth
+    int nFreezeHeight = Params().GetConsensus().nLelantusGracefulPeriod;
+    int nTipHeight = nFreezeHeight + sigma::SIGMA_FREEZE_DEPTH;
+    std::vector<uint256> hashes(nTipHeight + 1);
+    std::vector<CBlockIndex> blocks(nTipHeight + 1);
+    for (int i = 0; i <= nTipHeight; i++) {
+        hashes[i] = ArithToUint256(arith_uint256(i + 1));
+        blocks[i].nHeight = i;
+        blocks[i].phashBlock = &hashes[i];
+        blocks[i].pprev = i > 0 ? &blocks[i - 1] : nullptr;
+        blocks[i].BuildSkip();
+    }
+
+    sigmaState->FreezeIfFinal(&blocks[nTipHeight - 1]);
+    BOOST_CHECK(!sigmaState->IsFrozen());
+
+    sigmaState->FreezeIfFinal(&blocks[nTipHeight]);
+    BOOST_REQUIRE(sigmaState->IsFrozen());
+    BOOST_CHECK_EQUAL(sigmaState->GetUnfrozenMints().size(), 0);
+    BOOST_CHECK_EQUAL(sigmaState->GetUnfrozenSpends().size(), 0);
+
+    // the coins are found in the frozen state
+    for (const auto& pubCoin : pubCoins1)
+        BOOST_CHECK(sigmaState->HasCoin(pubCoin));
+    for (const auto& pubCoin : pubCoins2)
+        BOOST_CHECK(sigmaState->HasCoin(pubCoin));
+    for (const Scalar& serial : serials)
+        BOOST_CHECK(sigmaState->IsUsedCoinSerial(serial));
+
+    // disconnecting a frozen block moves the coins back to the maps before it's rolled back
+    sigmaState->RemoveBlock(&index2);
+    BOOST_CHECK(!sigmaState->IsFrozen());
+    BOOST_CHECK_EQUAL(sigmaState->GetUnfrozenMints().size(), pubCoins1.size());
+    BOOST_CHECK_EQUAL(sigmaState->GetUnfrozenSpends().size(), serials.size());
+    for (const auto& pubCoin : pubCoins1)
+        BOOST_CHECK(sigmaState->HasCoin(pubCoin));
+    for (const auto& pubCoin : pubCoins2)
+        BOOST_CHECK(!sigmaState->HasCoin(pubCoin));
+    for (const Scalar& serial : serials)
+        BOOST_CHECK(sigmaState->IsUsedCoinSerial(serial));
+
+    boost::filesystem::remove(GetDataDir() / "sigma_frozen.dat");
+    sigmaState->Reset();
+}
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -91,10 +91,13 @@ BOOST_AUTO_TEST_CASE(spark_mintspend_test)
 
     {
          //Set mints unused, and try to spend again
-         for(auto ltag : tempTags)
-             pwalletMain->sparkWallet->setCoinUnused(ltag.first);
+         GroupElement lTag;
+         tempTags.ForEach([&](const GroupElement& tag, int) {
+             pwalletMain->sparkWallet->setCoinUnused(tag);
+             lTag = tag;
+         });
 
-         spark::Coin coin = pwalletMain->sparkWallet->getCoinFromLTag(tempTags.begin()->first);
+         spark::Coin coin = pwalletMain->sparkWallet->getCoinFromLTag(lTag);
          COutPoint outPoint;
          spark::GetOutPoint(outPoint, coin);
          CCoinControl coinControl;
@@ -1,4 +1,5 @@
 #include "../spark/state.h"
+#include "../spark/sectorcache.h"
 #include "../validation.h"
 #include "../wallet/wallet.h"
 #include "fixtures.h"
@@ -503,4 +504,142 @@ BOOST_AUTO_TEST_CASE(get_coin_group)
     sparkState->Reset();
 }
 
+BOOST_AUTO_TEST_CASE(get_coin_set_sectors)
+{
+    GenerateBlocks(1100);
+
+    std::vector<CAmount> amounts(6, COIN);
+    std::vector<CMutableTransaction> txs;
+    auto mints = GenerateMints(amounts, txs);
+
+    std::vector<CBlockIndex*> indexes;
+    for (size_t i = 0; i != mints.size(); i += 2) {
+        auto index = GenerateBlock({txs[i], txs[i + 1]});
+        auto block = GetCBlock(index);
+        PopulateSparkTxInfo(
+            block,
+            {
+                pwalletMain->sparkWallet->getCoinFromMeta(mints[i]),
+                pwalletMain->sparkWallet->getCoinFromMeta(mints[i + 1])
+            },
+            {});
+        sparkState->AddMintsToStateAndBlockIndex(index, &block);
+        indexes.push_back(index);
+    }
+
+    typedef std::vector<std::pair<spark::Coin, std::pair<uint256, std::vector<unsigned char>>>> RecoveryCoins;
+
+    uint256 blockHash;
+    std::vector<unsigned char> setHash;
+    RecoveryCoins allCoins;
+    sparkState->GetCoinsForRecovery(&chainActive, chainActive.Height(), 1, "", blockHash, allCoins, setHash);
+    BOOST_CHECK_EQUAL(6, allCoins.size());
+    BOOST_CHECK(indexes.back()->GetBlockHash() == blockHash);
+
+    uint256 metaBlockHash;
+    std::vector<unsigned char> metaSetHash;
+    size_t size = 0;
+    sparkState->GetAnonSetMetaData(&chainActive, chainActive.Height(), 1, "", metaBlockHash, metaSetHash, size);
+    BOOST_CHECK_EQUAL(allCoins.size(), size);
+    BOOST_CHECK(blockHash == metaBlockHash);
+    BOOST_CHECK(setHash == metaSetHash);
+
+    // sectors put together give the full set, also when they split blocks
+    RecoveryCoins sector, joined;
+    for (auto range : std::vector<std::pair<size_t, size_t>>{{0, 3}, {3, 4}, {4, 100}}) {
+        sparkState->GetCoinsForRecovery(&chainActive, 1, blockHash, "", range.first, range.second, sector);
+        joined.insert(joined.end(), sector.begin(), sector.end());
+    }
+    BOOST_CHECK(allCoins == joined);
+
+    // coins after a given block only
+    sparkState->GetAnonSetMetaData(&chainActive, chainActive.Height(), 1, indexes[0]->GetBlockHash().GetHex(), metaBlockHash, metaSetHash, size);
+    BOOST_CHECK_EQUAL(4, size);
+    sparkState->GetCoinsForRecovery(&chainActive, 1, blockHash, indexes[0]->GetBlockHash().GetHex(), 0, 100, sector);
+    BOOST_CHECK(RecoveryCoins(allCoins.begin(), allCoins.begin() + 4) == sector);
+
+    // pinned to an older block, newer coins are not included
+    sparkState->GetCoinsForRecovery(&chainActive, 1, indexes[1]->GetBlockHash(), "", 0, 100, sector);
+    BOOST_CHECK(RecoveryCoins(allCoins.begin() + 2, allCoins.end()) == sector);
+
+    // unknown block gives nothing
+    sparkState->GetCoinsForRecovery(&chainActive, 1, uint256(), "", 0, 100, sector);
+    BOOST_CHECK(sector.empty());
+
+    sparkState->Reset();
+}
+
+BOOST_AUTO_TEST_CASE(sector_cache)
+{
+    GenerateBlocks(1100);
+
+    std::vector<CAmount> amounts(4, COIN);
+    std::vector<CMutableTransaction> txs;
+    auto mints = GenerateMints(amounts, txs);
+
+    for (size_t i = 0; i != mints.size(); i += 2) {
+        auto index = GenerateBlock({txs[i], txs[i + 1]});
+        auto block = GetCBlock(index);
+        PopulateSparkTxInfo(
+            block,
+            {
+                pwalletMain->sparkWallet->getCoinFromMeta(mints[i]),
+                pwalletMain->sparkWallet->getCoinFromMeta(mints[i + 1])
+            },
+            {});
+        sparkState->AddMintsToStateAndBlockIndex(index, &block);
+    }
+
+    LOCK(cs_main);
+    uint256 blockHash;
+    std::vector<unsigned char> setHash;
+    std::vector<spark::RecoveryCoin> coins;
+    sparkState->GetCoinsForRecovery(&chainActive, chainActive.Height(), 1, "", blockHash, coins, setHash);
+
+    spark::CSparkSectorCache* cache = spark::CSparkSectorCache::GetCache();
+    uint256 cachedBlockHash;
+    std::vector<unsigned char> cachedSetHash;
+    std::vector<spark::CSparkSectorCache::SectorPtr> sectors;
+    cache->GetAnonymitySet(&chainActive, chainActive.Height(), 1, "", cachedBlockHash, cachedSetHash, sectors);
+
+    BOOST_CHECK(blockHash == cachedBlockHash);
+    BOOST_CHECK(setHash == cachedSetHash);
+    BOOST_CHECK_EQUAL(2, sectors.size());
+
+    UniValue expected(UniValue::VARR);
+    CDataStream expectedSerialized(SER_NETWORK, PROTOCOL_VERSION);
+    for (const auto& coin : coins) {
+        expected.push_back(spark::RecoveryCoinToUniValue(coin));
+        expectedSerialized << coin;
+    }
+    BOOST_CHECK_EQUAL(expected.write(), spark::CSparkSectorCache::SectorsToUniValue(sectors).write());
+
+    std::vector<unsigned char> serialized;
+    size_t nCoins = 0;
+    for (const auto& sector : sectors) {
+        serialized.insert(serialized.end(), sector->serialized.begin(), sector->serialized.end());
+        nCoins += sector->nCoins;
+    }
+    BOOST_CHECK(serialized == std::vector<unsigned char>(expectedSerialized.begin(), expectedSerialized.end()));
+    BOOST_CHECK_EQUAL(nCoins, coins.size());
+
+    // sectors are shared between calls
+    std::vector<spark::CSparkSectorCache::SectorPtr> sectors2;
+    cache->GetAnonymitySet(&chainActive, chainActive.Height(), 1, "", cachedBlockHash, cachedSetHash, sectors2);
+    BOOST_CHECK(sectors == sectors2);
+
+    // over the memory budget sectors are evicted and encoded again
+    spark::CSparkSectorCache smallCache(1);
+    smallCache.GetAnonymitySet(&chainActive, chainActive.Height(), 1, "", cachedBlockHash, cachedSetHash, sectors);
+    smallCache.GetAnonymitySet(&chainActive, chainActive.Height(), 1, "", cachedBlockHash, cachedSetHash, sectors2);
+    BOOST_CHECK_EQUAL(2, sectors2.size());
+    BOOST_CHECK(sectors[0] != sectors2[0] && sectors[1] != sectors2[1]);
+    BOOST_CHECK_EQUAL(
+            spark::CSparkSectorCache::SectorsToUniValue(sectors).write(),
+            spark::CSparkSectorCache::SectorsToUniValue(sectors2).write());
+
+    cache->Clear();
+    sparkState->Reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
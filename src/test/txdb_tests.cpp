@@ -338,4 +338,102 @@ BOOST_AUTO_TEST_CASE(dbindexhelper_zerospend)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbindexhelper_balances)
+{
+    //MTP Testnet: height: 7980, txid: 02fdd0c09e5e84c4fb2207f9a5b9bbdb181c71436660865ee0ce36e37fff3492
+    CTransaction tx = TxFromStr("01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff05022c1f0104ffffffff062059925300000000232102a9ba61c5b6d3b6bbff24f8f972745bb9922448251ded2fddc5fdbc21d15b0ae0ac80f0fa02000000001976a914296134d2415bf1f2b518b3f673816d7e603b160088ac80f0fa02000000001976a914e1e1dc06a889c1b6d3eb00eef7a96f6a7cfb884888ac80f0fa02000000001976a914ab03ecfddee6330497be894d16c29ae341c123aa88ac80d1f008000000001976a9144281a58a1d5b2d3285e00cb45a8492debbdad4c588ac80f0fa02000000001976a9141fd264c0bb53bd9fef18e2248ddf1383d6e811ae88ac00000000");
+
+    uint160 key;
+    AddressType type;
+    CBitcoinAddress("TLNchzdLPyfdXp1eH4VSrUMx6wMjitzLbF").GetIndexKey(key, type);
+
+    {
+        CDbIndexHelper dbIndexHelper(true, false, true);
+        dbIndexHelper.ConnectTransaction(tx, 7980, 1, viewCache);
+
+        BOOST_CHECK(dbIndexHelper.getAddressBalances().size() == 6);
+        CAddressBalance const & balance = dbIndexHelper.getAddressBalances().at(std::make_pair(type, key));
+        BOOST_CHECK(balance.balance == 14021 * 100000);
+        BOOST_CHECK(balance.received == 14021 * 100000);
+        BOOST_CHECK(balance.txCount == 1);
+        BOOST_CHECK(balance.utxoCount == 1);
+    }
+    {
+        // the outputs and inputs of a tx are disconnected separately, the tx is still counted once
+        CDbIndexHelper dbIndexHelper(true, false, true);
+        dbIndexHelper.DisconnectTransactionOutputs(tx, 7980, 1, viewCache);
+        dbIndexHelper.DisconnectTransactionInputs(tx, 7980, 1, viewCache);
+
+        CAddressBalance const & balance = dbIndexHelper.getAddressBalances().at(std::make_pair(type, key));
+        BOOST_CHECK(balance.balance == -14021 * 100000);
+        BOOST_CHECK(balance.received == -14021 * 100000);
+        BOOST_CHECK(balance.txCount == -1);
+        BOOST_CHECK(balance.utxoCount == -1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(address_balances_and_pages)
+{
+    CBlockTreeDB db(1 << 20, true);
+    uint160 key(std::vector<unsigned char>(20, 1));
+    AddressType type = AddressType::payToPubKeyHash;
+    uint256 txhash1 = GetRandHash(), txhash2 = GetRandHash(), txhash3 = GetRandHash();
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > entries {
+        {CAddressIndexKey(type, key, 10, 1, txhash1, 0, true), -5},
+        {CAddressIndexKey(type, key, 10, 1, txhash1, 1, false), 3},
+        {CAddressIndexKey(type, key, 10, 2, txhash2, 0, false), 7},
+        {CAddressIndexKey(type, key, 11, 0, txhash3, 0, false), 1},
+    };
+    BOOST_CHECK(db.WriteAddressIndex(entries));
+
+    // a page doesn't end in the middle of a tx
+    std::vector<std::pair<CAddressIndexKey, CAmount> > page;
+    BOOST_CHECK(db.ReadAddressIndexPage(key, type, page, 0, 0, 0, 1));
+    BOOST_CHECK(page.size() == 2);
+    page.clear();
+    BOOST_CHECK(db.ReadAddressIndexPage(key, type, page, 10, 2, 0, 1));
+    BOOST_CHECK(page.size() == 1 && page[0].first.txhash == txhash2);
+    page.clear();
+    BOOST_CHECK(db.ReadAddressIndexPage(key, type, page, 10, 3, 0, 10));
+    BOOST_CHECK(page.size() == 1 && page[0].first.txhash == txhash3);
+
+    CAddressBalance change;
+    change.balance = 6;
+    change.received = 11;
+    change.txCount = 3;
+    change.utxoCount = 2;
+    std::map<std::pair<AddressType, uint160>, CAddressBalance> changes {{std::make_pair(type, key), change}};
+    uint256 hashBest;
+    BOOST_CHECK(!db.ReadAddressBalancesBest(hashBest));
+    BOOST_CHECK(db.UpdateAddressBalances(changes, uint256S("01")));
+    BOOST_CHECK(db.UpdateAddressBalances(changes, uint256S("02")));
+    BOOST_CHECK(db.ReadAddressBalancesBest(hashBest) && hashBest == uint256S("02"));
+
+    CAddressBalance balance;
+    BOOST_CHECK(db.ReadAddressBalance(key, type, balance));
+    BOOST_CHECK(balance.balance == 12 && balance.received == 22 && balance.txCount == 6 && balance.utxoCount == 4);
+
+    change.balance = -12;
+    change.received = -22;
+    change.txCount = -6;
+    change.utxoCount = -4;
+    changes[std::make_pair(type, key)] = change;
+    BOOST_CHECK(db.UpdateAddressBalances(changes, uint256()));
+    BOOST_CHECK(db.ReadAddressBalance(key, type, balance));
+    BOOST_CHECK(balance.IsNull());
+
+    // erasing the totals forgets the block they were at too
+    change.balance = 5;
+    change.received = 5;
+    change.txCount = 1;
+    change.utxoCount = 1;
+    changes[std::make_pair(type, key)] = change;
+    BOOST_CHECK(db.UpdateAddressBalances(changes, uint256S("03")));
+    BOOST_CHECK(db.EraseAddressBalances());
+    BOOST_CHECK(db.ReadAddressBalance(key, type, balance));
+    BOOST_CHECK(balance.IsNull());
+    BOOST_CHECK(!db.ReadAddressBalancesBest(hashBest));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
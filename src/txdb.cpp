@@ -27,6 +27,8 @@ static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
 static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_ADDRESSBALANCE = 'A';
+static const char DB_ADDRESSBALANCE_BEST = 'M';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
@@ -36,6 +38,9 @@ static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
 static const char DB_TOTAL_SUPPLY = 'S';
+static const char DB_INDEX_BUILDER = 'I';
+
+static const char DB_POW_HASH = 'h';
 
 namespace {
 
@@ -61,7 +66,7 @@ struct CoinEntry {
 
 }
 
-CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true)
+CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true, GetDBProfile("chainstate"))
 {
 }
 
@@ -110,7 +115,7 @@ size_t CCoinsViewDB::EstimateSize() const
     return db.EstimateSize(DB_COIN, (char)(DB_COIN+1));
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe) {
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe, false, GetDBProfile("blockindex")) {
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -313,6 +318,135 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, AddressType type,
     return true;
 }
 
+bool CBlockTreeDB::ReadAddressIndexPage(uint160 addressHash, AddressType type,
+                                        std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                                        int height, unsigned int txindex, int end, size_t nLimit) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorTxKey(type, addressHash, height, txindex)));
+
+    size_t nRead = 0;
+    int nLastHeight = 0;
+    unsigned int nLastTxIndex = 0;
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash && key.second.type == type) {
+            if (end > 0 && key.second.blockHeight > end) {
+                break;
+            }
+            if (nRead >= nLimit && (key.second.blockHeight != nLastHeight || key.second.txindex != nLastTxIndex)) {
+                break;
+            }
+            CAmount nValue;
+            if (pcursor->GetValue(nValue)) {
+                addressIndex.push_back(std::make_pair(key.second, nValue));
+                nLastHeight = key.second.blockHeight;
+                nLastTxIndex = key.second.txindex;
+                nRead++;
+                pcursor->Next();
+            } else {
+                return error("failed to get address index value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool CBlockTreeDB::ReadAddressBalance(uint160 addressHash, AddressType type, CAddressBalance &balance) {
+    balance.SetNull();
+    // addresses without any entries have no totals
+    Read(std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(type, addressHash)), balance);
+    return true;
+}
+
+bool CBlockTreeDB::UpdateAddressBalances(const std::map<std::pair<AddressType, uint160>, CAddressBalance> &changes,
+                                         const uint256 &hashBest) {
+    CDBBatch batch(*this);
+    AddAddressBalances(batch, changes);
+    batch.Write(DB_ADDRESSBALANCE_BEST, hashBest);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadAddressBalancesBest(uint256 &hashBest) {
+    return Read(DB_ADDRESSBALANCE_BEST, hashBest);
+}
+
+void CBlockTreeDB::AddAddressBalances(CDBBatch &batch, const std::map<std::pair<AddressType, uint160>, CAddressBalance> &changes) {
+    for (const auto& change : changes) {
+        auto key = std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(change.first.first, change.first.second));
+        CAddressBalance balance;
+        Read(key, balance);
+        balance += change.second;
+        if (balance.IsNull()) {
+            batch.Erase(key);
+        } else {
+            batch.Write(key, balance);
+        }
+    }
+}
+
+bool CBlockTreeDB::ReadIndexBuilderProgress(CIndexBuilderProgress &progress) {
+    return Read(DB_INDEX_BUILDER, progress);
+}
+
+bool CBlockTreeDB::ResetIndexBuilder(const CIndexBuilderProgress &progress) {
+    if (progress.fAddressIndex && !EraseAddressBalances())
+        return false;
+    CDBBatch batch(*this);
+    if (progress.fAddressIndex) {
+        batch.Erase(DB_TOTAL_SUPPLY);
+        batch.Erase(DB_ADDRESSBALANCE_BEST);
+    }
+    batch.Write(DB_INDEX_BUILDER, progress);
+    return WriteBatch(batch, true);
+}
+
+bool CBlockTreeDB::WriteIndexBuilderProgress(const CIndexBuilderProgress &progress,
+                                             const std::map<std::pair<AddressType, uint160>, CAddressBalance> &balanceChanges,
+                                             CAmount nSupplyChange) {
+    CDBBatch batch(*this);
+    AddAddressBalances(batch, balanceChanges);
+    if (progress.fAddressIndex) {
+        CAmount nSupply = 0;
+        Read(DB_TOTAL_SUPPLY, nSupply);
+        batch.Write(DB_TOTAL_SUPPLY, nSupply + nSupplyChange);
+        batch.Write(DB_ADDRESSBALANCE_BEST, progress.hashBest);
+    }
+    batch.Write(DB_INDEX_BUILDER, progress);
+    return WriteBatch(batch, true);
+}
+
+bool CBlockTreeDB::EraseIndexBuilderProgress() {
+    return Erase(DB_INDEX_BUILDER);
+}
+
+bool CBlockTreeDB::EraseAddressBalances() {
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(DB_ADDRESSBALANCE);
+
+    CDBBatch batch(*this);
+    // without their block the emptied totals are taken to be at the tip, and no block would be added to them again
+    batch.Erase(DB_ADDRESSBALANCE_BEST);
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CAddressIndexIteratorKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSBALANCE)
+            break;
+        batch.Erase(key);
+        if (batch.SizeEstimate() > (1 << 24)) {
+            if (!WriteBatch(batch))
+                return false;
+            batch.Clear();
+        }
+        pcursor->Next();
+    }
+    return WriteBatch(batch);
+}
 
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
@@ -352,6 +486,15 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+// Headers that were verified when their blocks were connected aren't hashed again
+static uint256 GetBlockIndexPoWHash(const CBlockIndex *pindex)
+{
+    uint256 powHash;
+    if (GetVerifiedPoWHash(pindex->GetBlockHash(), powHash))
+        return powHash;
+    return pindex->GetBlockPoWHash();
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
     const auto &consensusParams = Params().GetConsensus();
@@ -430,7 +573,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
                 pindexNew->activeDisablingSporks = diskindex.activeDisablingSporks;
 
                 if (fCheckPoWForAllBlocks) {
-                    if (!CheckProofOfWork(pindexNew->GetBlockPoWHash(), pindexNew->nBits, consensusParams))
+                    if (!CheckProofOfWork(GetBlockIndexPoWHash(pindexNew), pindexNew->nBits, consensusParams))
                         return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindexNew->ToString());
                 }
                 else {
@@ -458,7 +601,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
     if (!fCheckPoWForAllBlocks) {
         // delayed check for all the blocks
         for (const auto &blockIndex: lastNBlocks) {
-            if (!CheckProofOfWork(blockIndex.second->GetBlockPoWHash(), blockIndex.second->nBits, consensusParams))
+            if (!CheckProofOfWork(GetBlockIndexPoWHash(blockIndex.second), blockIndex.second->nBits, consensusParams))
                 return error("LoadBlockIndex(): CheckProofOfWork failed: %s", blockIndex.second->ToString());
         }
     }
@@ -519,11 +662,56 @@ bool CBlockTreeDB::ReadTotalSupply(CAmount & supply)
 
 /******************************************************************************/
 
-CDbIndexHelper::CDbIndexHelper(bool addressIndex_, bool spentIndex_)
+CPoWHashDB::CPoWHashDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "powhash", nCacheSize, fMemory, fWipe, false, GetDBProfile("powhash")) {
+}
+
+bool CPoWHashDB::ReadPoWHash(const uint256 &blockHash, uint256 &powHash) {
+    {
+        LOCK(cs);
+        auto it = mapPending.find(blockHash);
+        if (it != mapPending.end()) {
+            powHash = it->second;
+            return true;
+        }
+    }
+    return Read(std::make_pair(DB_POW_HASH, blockHash), powHash);
+}
+
+void CPoWHashDB::AddPoWHash(const uint256 &blockHash, const uint256 &powHash) {
+    LOCK(cs);
+    mapPending[blockHash] = powHash;
+}
+
+bool CPoWHashDB::Flush() {
+    std::map<uint256, uint256> mapWrite;
+    {
+        LOCK(cs);
+        mapWrite.swap(mapPending);
+    }
+    if (mapWrite.empty())
+        return true;
+
+    CDBBatch batch(*this);
+    for (const auto &entry : mapWrite)
+        batch.Write(std::make_pair(DB_POW_HASH, entry.first), entry.second);
+    if (WriteBatch(batch))
+        return true;
+
+    // keep what couldn't be written for the next attempt
+    LOCK(cs);
+    mapPending.insert(mapWrite.begin(), mapWrite.end());
+    return false;
+}
+
+/******************************************************************************/
+
+CDbIndexHelper::CDbIndexHelper(bool addressIndex_, bool spentIndex_, bool addressBalances_)
 {
     if (addressIndex_) {
         addressIndex.reset(AddressIndex());
         addressUnspentIndex.reset(AddressUnspentIndex());
+        if (addressBalances_)
+            addressBalances.reset(AddressBalances());
     }
 
     if (spentIndex_)
@@ -669,8 +857,30 @@ void handleOutput(const CTxOut &out, size_t outNo, uint256 const & txHash, int h
 }
 
 
+void CDbIndexHelper::addBalanceChanges(size_t addressBegin, int sign)
+{
+    if (!addressBalances)
+        return;
+
+    for (AddressIndex::const_iterator iter = addressIndex->begin() + addressBegin; iter != addressIndex->end(); ++iter) {
+        CAddressIndexKey const & key = iter->first;
+        std::pair<AddressType, uint160> address(key.type, key.hashBytes);
+        CAddressBalance & change = (*addressBalances)[address];
+
+        change.balance += sign * iter->second;
+        if (iter->second > 0)
+            change.received += sign * iter->second;
+        if (balanceTxs.emplace(address, key.txhash).second)
+            change.txCount += sign;
+        if (key.type == AddressType::payToPubKeyHash || key.type == AddressType::payToScriptHash
+                || key.type == AddressType::payToExchangeAddress)
+            change.utxoCount += key.spending ? -sign : sign;
+    }
+}
+
 void CDbIndexHelper::ConnectTransaction(CTransaction const & tx, int height, int txNumber, CCoinsViewCache const & view)
 {
+    size_t const addressBegin = addressIndex ? addressIndex->size() : 0;
     size_t no = 0;
     if(!tx.IsCoinBase() && !tx.HasNoRegularInputs()) {
         for (CTxIn const & input : tx.vin) {
@@ -698,6 +908,8 @@ void CDbIndexHelper::ConnectTransaction(CTransaction const & tx, int height, int
     for (CTxOut const & out : tx.vout) {
         handleOutput(out, no++, tx.GetHash(), height, txNumber, view, txIsCoinBase, addressIndex, addressUnspentIndex, spentIndex);
     }
+
+    addBalanceChanges(addressBegin, 1);
 }
 
 
@@ -732,6 +944,8 @@ void CDbIndexHelper::DisconnectTransactionInputs(CTransaction const & tx, int he
             handleInput(input, no++, tx.GetHash(), height, txNumber, view, addressIndex, addressUnspentIndex, spentIndex);
         }
 
+    addBalanceChanges(pAddressBegin, -1);
+
     if(addressIndex){
         std::reverse(addressIndex->begin() + pAddressBegin, addressIndex->end());
         std::reverse(addressUnspentIndex->begin() + pUnspentBegin, addressUnspentIndex->end());
@@ -746,6 +960,8 @@ void CDbIndexHelper::DisconnectTransactionInputs(CTransaction const & tx, int he
 
 void CDbIndexHelper::DisconnectTransactionOutputs(CTransaction const & tx, int height, int txNumber, CCoinsViewCache const & view)
 {
+    size_t const addressBegin = addressIndex ? addressIndex->size() : 0;
+
     if(tx.IsZerocoinSpend() || tx.IsSigmaSpend() || tx.IsLelantusJoinSplit() || tx.IsSparkSpend())
         handleZerocoinSpend(tx.vout.begin(), tx.vout.end(), tx.GetHash(), height, txNumber, view, addressIndex, tx);
 
@@ -755,6 +971,8 @@ void CDbIndexHelper::DisconnectTransactionOutputs(CTransaction const & tx, int h
         handleOutput(out, no++, tx.GetHash(), height, txNumber, view, txIsCoinBase, addressIndex, addressUnspentIndex, spentIndex);
     }
 
+    addBalanceChanges(addressBegin, -1);
+
     if(addressIndex)
     {
         std::reverse(addressIndex->begin(), addressIndex->end());
@@ -782,6 +1000,12 @@ CDbIndexHelper::SpentIndex const & CDbIndexHelper::getSpentIndex() const
     return *spentIndex;
 }
 
+
+CDbIndexHelper::AddressBalances const & CDbIndexHelper::getAddressBalances() const
+{
+    return *addressBalances;
+}
+
 namespace {
 
 //! Legacy class to deserialize pre-pertxout database entries without reindex.
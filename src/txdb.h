@@ -10,8 +10,10 @@
 #include "dbwrapper.h"
 #include "chain.h"
 #include "spentindex.h"
+#include "sync.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -116,6 +118,29 @@ private:
     friend class CCoinsViewDB;
 };
 
+/** How far the background index builder got, see indexbuilder.h */
+struct CIndexBuilderProgress
+{
+    // last block whose entries are written
+    uint256 hashBest;
+    // indexes being built
+    bool fAddressIndex;
+    bool fSpentIndex;
+    bool fTimestampIndex;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBest);
+        READWRITE(fAddressIndex);
+        READWRITE(fSpentIndex);
+        READWRITE(fTimestampIndex);
+    }
+
+    CIndexBuilderProgress() : fAddressIndex(false), fSpentIndex(false), fTimestampIndex(false) {}
+};
+
 /** Access to the block database (blocks/index/) */
 class CBlockTreeDB : public CDBWrapper
 {
@@ -142,6 +167,25 @@ public:
     bool ReadAddressIndex(uint160 addressHash, AddressType type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                           int start = 0, int end = 0);
+    // Reads the entries from the transaction at (height, txindex) on, up to end if it's set. Stops after nLimit
+    // entries, but not in the middle of the entries of a transaction.
+    bool ReadAddressIndexPage(uint160 addressHash, AddressType type,
+                              std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                              int height, unsigned int txindex, int end, size_t nLimit);
+    bool ReadAddressBalance(uint160 addressHash, AddressType type, CAddressBalance &balance);
+    // Adds the changes to the running totals of the addresses, hashBest is the block the totals are at afterwards
+    bool UpdateAddressBalances(const std::map<std::pair<AddressType, uint160>, CAddressBalance> &changes,
+                               const uint256 &hashBest);
+    bool ReadAddressBalancesBest(uint256 &hashBest);
+    bool EraseAddressBalances();
+    bool ReadIndexBuilderProgress(CIndexBuilderProgress &progress);
+    // Starts the index builder over, the totals of the address index are reset
+    bool ResetIndexBuilder(const CIndexBuilderProgress &progress);
+    // Adds the totals of the blocks the index builder wrote the entries of, and records its progress with them
+    bool WriteIndexBuilderProgress(const CIndexBuilderProgress &progress,
+                                   const std::map<std::pair<AddressType, uint160>, CAddressBalance> &balanceChanges,
+                                   CAmount nSupplyChange);
+    bool EraseIndexBuilderProgress();
 
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
@@ -152,6 +196,35 @@ public:
     int GetBlockIndexVersion(uint256 const & blockHash);
     bool AddTotalSupply(CAmount const & supply);
     bool ReadTotalSupply(CAmount & supply);
+
+private:
+    void AddAddressBalances(CDBBatch &batch, const std::map<std::pair<AddressType, uint160>, CAddressBalance> &changes);
+};
+
+/**
+ * Access to the verified PoW hash database (blocks/powhash/)
+ *
+ * Maps the hash of every connected block to the PoW hash its header was verified with: the Lyra2Z or ProgPow
+ * hash, or the MTP hash value once the MTP proof was checked. The block hash commits to all the PoW inputs, so
+ * a header with a known block hash doesn't need the memory-hard hashing again. It's kept apart from the block
+ * index so that -reindex, which wipes the block index, can still use it.
+ */
+class CPoWHashDB : public CDBWrapper
+{
+public:
+    CPoWHashDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+private:
+    CPoWHashDB(const CPoWHashDB&);
+    void operator=(const CPoWHashDB&);
+public:
+    bool ReadPoWHash(const uint256 &blockHash, uint256 &powHash);
+    // Hashes are kept in memory until the next Flush()
+    void AddPoWHash(const uint256 &blockHash, const uint256 &powHash);
+    bool Flush();
+
+private:
+    CCriticalSection cs;
+    std::map<uint256, uint256> mapPending;
 };
 
 
@@ -159,14 +232,15 @@ public:
  * This class was introduced as the logic for address and tx indices became too intricate.
  *
  * @param addressIndex, spentIndex - true if to update the corresponding index
+ * @param addressBalances - true if to collect the changes of the address totals, needs addressIndex
  *
  * It is undefined behavior if the helper was created with addressIndex == false
- * and getAddressIndex was called later (same for spentIndex and unspentIndex).
+ * and getAddressIndex was called later (same for spentIndex, unspentIndex and addressBalances).
  */
 class CDbIndexHelper : boost::noncopyable
 {
 public:
-    CDbIndexHelper(bool addressIndex, bool spentIndex);
+    CDbIndexHelper(bool addressIndex, bool spentIndex, bool addressBalances = false);
 
     void ConnectTransaction(CTransaction const & tx, int height, int txNumber, CCoinsViewCache const & view);
     void DisconnectTransactionInputs(CTransaction const & tx, int height, int txNumber, CCoinsViewCache const & view);
@@ -175,15 +249,23 @@ public:
     using AddressIndex = std::vector<std::pair<CAddressIndexKey, CAmount> >;
     using AddressUnspentIndex = std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >;
     using SpentIndex = std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >;
+    // Changes of the running totals of the addresses, subtracted for disconnected transactions
+    using AddressBalances = std::map<std::pair<AddressType, uint160>, CAddressBalance>;
 
     AddressIndex const & getAddressIndex() const;
     AddressUnspentIndex const & getAddressUnspentIndex() const;
     SpentIndex const & getSpentIndex() const;
+    AddressBalances const & getAddressBalances() const;
 
 private:
+    void addBalanceChanges(size_t addressBegin, int sign);
+
     boost::optional<AddressIndex> addressIndex;
     boost::optional<AddressUnspentIndex> addressUnspentIndex;
     boost::optional<SpentIndex> spentIndex;
+    boost::optional<AddressBalances> addressBalances;
+    // (address, tx) pairs already counted, a disconnected tx is handled in two calls
+    std::set<std::pair<std::pair<AddressType, uint160>, uint256> > balanceTxs;
 };
 
 #endif // BITCOIN_TXDB_H
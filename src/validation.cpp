@@ -73,6 +73,7 @@
 #include <atomic>
 #include <sstream>
 #include <chrono>
+#include <future>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -106,9 +107,10 @@ bool fReindex = false;
 bool fTxIndex = false;
 bool fHavePruned = false;
 bool fPruneMode = false;
-bool fAddressIndex = false;
-bool fSpentIndex = false;
-bool fTimestampIndex = false;
+std::atomic_bool fAddressIndex(false);
+std::atomic_bool fAddressBalanceIndex(false);
+std::atomic_bool fSpentIndex(false);
+std::atomic_bool fTimestampIndex(false);
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
 bool fCheckBlockIndex = false;
@@ -274,6 +276,12 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 
 CCoinsViewCache *pcoinsTip = NULL;
 CBlockTreeDB *pblocktree = NULL;
+CPoWHashDB *ppowhashdb = NULL;
+
+bool GetVerifiedPoWHash(const uint256& blockHash, uint256& powHash)
+{
+    return ppowhashdb && ppowhashdb->ReadPoWHash(blockHash, powHash);
+}
 
 enum FlushStateMode {
     FLUSH_STATE_NONE,
@@ -1818,6 +1826,69 @@ bool GetAddressIndex(uint160 addressHash, AddressType type,
     return true;
 }
 
+bool GetAddressIndexPage(uint160 addressHash, AddressType type,
+                         std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                         int height, unsigned int txindex, int end, size_t nLimit)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressIndexPage(addressHash, type, addressIndex, height, txindex, end, nLimit))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+/**
+ * Whether the running address totals have the changes of the block.
+ *
+ * The totals are read, added to and written back, so a block applied twice would be counted twice. They record
+ * the block they are at, the blocks at or below it on its chain are in them. That skips the blocks connected again
+ * past the coins tip after an unclean shutdown, and the ones -checklevel=4 connects again. Totals written before
+ * they recorded their block are taken to be at the tip, fAtTip is returned for them.
+ */
+static bool AddressBalancesInclude(const CBlockIndex* pindex, bool fAtTip)
+{
+    uint256 hashBest;
+    if (!pblocktree->ReadAddressBalancesBest(hashBest))
+        return fAtTip;
+    BlockMap::const_iterator it = mapBlockIndex.find(hashBest);
+    return it != mapBlockIndex.end() && it->second->GetAncestor(pindex->nHeight) == pindex;
+}
+
+bool GetAddressBalance(uint160 addressHash, AddressType type, CAddressBalance &balance)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (fAddressBalanceIndex)
+        return pblocktree->ReadAddressBalance(addressHash, type, balance);
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex))
+        return error("unable to get txids for address");
+
+    balance.SetNull();
+    uint256 lastTxHash;
+    for (const auto& entry : addressIndex) {
+        balance.balance += entry.second;
+        if (entry.second > 0)
+            balance.received += entry.second;
+        // entries of a tx are next to each other
+        if (balance.txCount == 0 || entry.first.txhash != lastTxHash)
+            balance.txCount++;
+        lastTxHash = entry.first.txhash;
+    }
+    if (type == AddressType::payToPubKeyHash || type == AddressType::payToScriptHash || type == AddressType::payToExchangeAddress) {
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
+        if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+            return error("unable to get txids for address");
+        balance.utxoCount = unspentOutputs.size();
+    }
+
+    return true;
+}
+
 bool GetAddressUnspent(uint160 addressHash, AddressType type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
 {
@@ -1875,8 +1946,13 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, con
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
 
+    // Headers of blocks that were connected before don't go through the memory-hard hashing again
+    uint256 verifiedPoWHash;
+    if (GetVerifiedPoWHash(block.GetHash(), verifiedPoWHash)) {
+        block.cachedPoWHash = verifiedPoWHash;
+    }
     // Firo - MTP
-    if (!CheckMerkleTreeProof(block, consensusParams)){
+    else if (!CheckMerkleTreeProof(block, consensusParams)){
     	return error("ReadBlockFromDisk: CheckMerkleTreeProof: Errors in block header at %s", pos.ToString());
     }
 
@@ -2450,6 +2526,8 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
+} // anon namespace
+
 bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock)
 {
     // Open history file to read
@@ -2476,8 +2554,6 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uin
     return true;
 }
 
-} // anon namespace
-
 /** Abort with a message */
 bool AbortNode(const std::string& strMessage, const std::string& userMessage)
 {
@@ -2569,7 +2645,7 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
         return DISCONNECT_FAILED;
     }
 
-    CDbIndexHelper dbIndexHelper(fAddressIndex, fSpentIndex);
+    CDbIndexHelper dbIndexHelper(fAddressIndex, fSpentIndex, fAddressBalanceIndex);
 
     CAmount nFees = 0;
 
@@ -2654,6 +2730,12 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
                 error("Failed to write address unspent index");
                 return DISCONNECT_FAILED;
             }
+            if (fAddressBalanceIndex && AddressBalancesInclude(pindex, true) &&
+                    !pblocktree->UpdateAddressBalances(dbIndexHelper.getAddressBalances(), pindex->pprev->GetBlockHash())) {
+                AbortNode(state, "Failed to write address balances");
+                error("Failed to write address balances");
+                return DISCONNECT_FAILED;
+            }
             if (!pblocktree->AddTotalSupply(-(block.vtx[0]->GetValueOut() - nFees))) {
                 AbortNode(state, "Failed to write total supply");
                 error("Failed to write total supply");
@@ -2712,6 +2794,22 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<CHeaderPoWCheck> headerpowcheckqueue(128);
+
+void ThreadHeaderPoWCheck() {
+    RenameThread("firo-headerch");
+    headerpowcheckqueue.Thread();
+}
+
+bool CHeaderPoWCheck::operator()() {
+    uint256 verifiedPoWHash;
+    if (GetVerifiedPoWHash(pheader->GetHash(), verifiedPoWHash))
+        pheader->cachedPoWHash = verifiedPoWHash;
+    else
+        pheader->GetPoWHash(nHeight);
+    return true;
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2789,7 +2887,9 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         return error("%s: Consensus::CheckBlock: %s", __func__, FormatStateMessage(state));
     }
 
-    if (block.IsProgPow() && !fJustCheck)
+    uint256 verifiedPoWHash, powHash;
+    bool fPoWHashVerified = GetVerifiedPoWHash(pindex->GetBlockHash(), verifiedPoWHash);
+    if (block.IsProgPow() && !fJustCheck && !fPoWHashVerified)
     {
         // do full PP hash check
 
@@ -2810,6 +2910,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         {
             return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
         }
+        powHash = final_hash;
     }
 
     // verify that the view's current state corresponds to the previous block
@@ -2949,7 +3050,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     std::vector<std::pair<uint256, CDiskTxPos> > vPos;
     vPos.reserve(block.vtx.size());
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
-    CDbIndexHelper dbIndexHelper(fAddressIndex, fSpentIndex);
+    CDbIndexHelper dbIndexHelper(fAddressIndex, fSpentIndex, fAddressBalanceIndex);
 
     std::vector<PrecomputedTransactionData> txdata;
     txdata.reserve(block.vtx.size()); // Required so that pointers to individual PrecomputedTransactionData don't get invalidated
@@ -3183,6 +3284,13 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         return true;
     }
 
+    // The header passed the full PoW check (MTP proof included) in CheckBlock and above, remember its hash
+    if (!fPoWHashVerified && ppowhashdb) {
+        if (!block.IsProgPow())
+            powHash = block.GetPoWHash(pindex->nHeight);
+        ppowhashdb->AddPoWHash(pindex->GetBlockHash(), powHash);
+    }
+
     // Write undo information to disk
     if (pindex->GetUndoPos().IsNull() || !pindex->IsValid(BLOCK_VALID_SCRIPTS))
     {
@@ -3212,6 +3320,10 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         if (!pblocktree->UpdateAddressUnspentIndex(dbIndexHelper.getAddressUnspentIndex()))
             return AbortNode(state, "Failed to write address unspent index");
 
+        if (fAddressBalanceIndex && !AddressBalancesInclude(pindex, false) &&
+                !pblocktree->UpdateAddressBalances(dbIndexHelper.getAddressBalances(), pindex->GetBlockHash()))
+            return AbortNode(state, "Failed to write address balances");
+
         if (!pblocktree->AddTotalSupply(block.vtx[0]->GetValueOut() - nFees))
             return AbortNode(state, "Failed to write total supply");
     }
@@ -3446,6 +3558,9 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
             if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks)) {
                 return AbortNode(state, "Failed to write to block index database");
             }
+            if (ppowhashdb && !ppowhashdb->Flush()) {
+                return AbortNode(state, "Failed to write to PoW hash database");
+            }
         }
         // Finally remove any pruned files
         if (fFlushForPrune)
@@ -4537,7 +4652,11 @@ bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const
     if (fCheckPOW)
     {
         uint256 final_hash;
-        if (block.IsProgPow())
+        if (GetVerifiedPoWHash(block.GetHash(), final_hash))
+        {
+            // the header was verified when its block was connected
+        }
+        else if (block.IsProgPow())
         {
             // If we use GetProgPowHashFull user may experience very slow header sync
             // We use simplified function for header check and then will use full check in ConnectBlock()
@@ -4596,7 +4715,8 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
 
         if (!block.IsProgPow()) {
             // Firo - MTP
-            if (block.IsMTP() && !CheckMerkleTreeProof(block, consensusParams))
+            uint256 verifiedPoWHash;
+            if (block.IsMTP() && !GetVerifiedPoWHash(block.GetHash(), verifiedPoWHash) && !CheckMerkleTreeProof(block, consensusParams))
                 return state.DoS(100, false, REJECT_INVALID, "bad-diffbits", false, "incorrect proof of work");
         }
     }
@@ -4994,9 +5114,50 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
     return true;
 }
 
+/**
+ * Compute the PoW hashes of a batch of headers on the header check threads, so AcceptBlockHeader finds
+ * them cached. A 2000 header message costs seconds of Lyra2Z hashing for old heights otherwise.
+ */
+static void PrecomputeHeadersPoW(const std::vector<CBlockHeader>& headers)
+{
+    if (!nScriptCheckThreads || headers.size() < 2)
+        return;
+
+    // The heights CheckBlockHeader will use: headers of a batch normally extend each other
+    std::vector<CHeaderPoWCheck> vChecks;
+    vChecks.reserve(headers.size());
+    {
+        LOCK(cs_main);
+        uint256 hashPrev;
+        int nHeight = 0;
+        for (const CBlockHeader& header : headers) {
+            if (!hashPrev.IsNull() && header.hashPrevBlock == hashPrev) {
+                nHeight = nHeight == INT_MAX ? INT_MAX : nHeight + 1;
+            } else {
+                nHeight = GetNHeight(header);
+                if (nHeight == 0 && !header.hashPrevBlock.IsNull())
+                    nHeight = INT_MAX;
+            }
+            hashPrev = header.GetHash();
+            // ProgPoW headers are checked with the light hash, which is cheap, and MTP headers carry their hash.
+            // Headers already in the index aren't checked again.
+            if (!header.IsProgPow() && !header.IsMTP() && !mapBlockIndex.count(hashPrev))
+                vChecks.emplace_back(header, nHeight);
+        }
+    }
+
+    if (vChecks.empty())
+        return;
+
+    CCheckQueueControl<CHeaderPoWCheck> control(&headerpowcheckqueue);
+    control.Add(vChecks);
+    control.Wait();
+}
+
 // Exposed wrapper for AcceptBlockHeader
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
 {
+    PrecomputeHeadersPoW(headers);
     {
         LOCK(cs_main);
         for (const CBlockHeader& header : headers) {
@@ -5459,15 +5620,26 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     LogPrintf("%s: transaction index %s\n", __func__, fTxIndex ? "enabled" : "disabled");
 
     // Check whether we have an address index
-    pblocktree->ReadFlag("addressindex", fAddressIndex);
+    bool fFlag = fAddressIndex;
+    pblocktree->ReadFlag("addressindex", fFlag);
+    fAddressIndex = fFlag;
     LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
+    // Address indexes built before the address totals were kept have no totals, balances are summed up then
+    fFlag = fAddressBalanceIndex;
+    pblocktree->ReadFlag("addressbalanceindex", fFlag);
+    fAddressBalanceIndex = fFlag && fAddressIndex;
+
     // Check whether we have a timestamp index
-    pblocktree->ReadFlag("timestampindex", fTimestampIndex);
+    fFlag = fTimestampIndex;
+    pblocktree->ReadFlag("timestampindex", fFlag);
+    fTimestampIndex = fFlag;
     LogPrintf("%s: timestamp index %s\n", __func__, fTimestampIndex ? "enabled" : "disabled");
 
     // Check whether we have a spent index
-    pblocktree->ReadFlag("spentindex", fSpentIndex);
+    fFlag = fSpentIndex;
+    pblocktree->ReadFlag("spentindex", fFlag);
+    fSpentIndex = fFlag;
     LogPrintf("%s: spent index %s\n", __func__, fSpentIndex ? "enabled" : "disabled");
 
 
@@ -5479,9 +5651,13 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
 
     PruneBlockIndexCandidates();
 
+    // Each state only reads its own fields of the block index, they are built concurrently. Most of the time
+    // goes into hashing the coins as they are inserted.
+    std::future<bool> lelantusBuilt = std::async(std::launch::async, [] { return lelantus::BuildLelantusStateFromIndex(&chainActive); });
+    std::future<bool> sparkBuilt = std::async(std::launch::async, [] { return spark::BuildSparkStateFromIndex(&chainActive); });
     sigma::BuildSigmaStateFromIndex(&chainActive);
-    lelantus::BuildLelantusStateFromIndex(&chainActive);
-    spark::BuildSparkStateFromIndex(&chainActive);
+    lelantusBuilt.get();
+    sparkBuilt.get();
 
     // Initialize MTP state
     MTPState::GetMTPState()->InitializeFromChain(&chainActive, chainparams.GetConsensus());
@@ -5744,6 +5920,8 @@ bool InitBlockIndex(const CChainParams& chainparams)
     // Use the provided setting for -addressindex in the new database
     fAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
     pblocktree->WriteFlag("addressindex", fAddressIndex);
+    fAddressBalanceIndex = fAddressIndex.load();
+    pblocktree->WriteFlag("addressbalanceindex", fAddressBalanceIndex);
 
     fSpentIndex = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
     pblocktree->WriteFlag("spentindex", fSpentIndex);
@@ -39,9 +39,11 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CBlockUndo;
 class CBloomFilter;
 class CChainParams;
 class CInv;
+class CPoWHashDB;
 class CConnman;
 class CScriptCheck;
 class CTxMemPool;
@@ -177,6 +179,29 @@ struct BlockHasher
     size_t operator()(const uint256& hash) const { return hash.GetCheapHash(); }
 };
 
+/**
+ * Closure computing the PoW hash of a header, which is then kept in its cachedPoWHash.
+ * Headers of a "headers" message are hashed in parallel with these before they are accepted one by one.
+ * nHeight must be the height CheckBlockHeader will use for the header.
+ */
+class CHeaderPoWCheck
+{
+private:
+    const CBlockHeader *pheader;
+    int nHeight;
+
+public:
+    CHeaderPoWCheck(): pheader(NULL), nHeight(0) {}
+    CHeaderPoWCheck(const CBlockHeader& header, int nHeightIn) : pheader(&header), nHeight(nHeightIn) {}
+
+    bool operator()();
+
+    void swap(CHeaderPoWCheck &check) {
+        std::swap(pheader, check.pheader);
+        std::swap(nHeight, check.nHeight);
+    }
+};
+
 extern CScript COINBASE_FLAGS;
 extern CCriticalSection cs_main;
 extern CTxMemPool mempool;
@@ -196,6 +221,12 @@ extern std::atomic_bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+/** The index flags are set by the index builder while RPC threads read them without cs_main */
+extern std::atomic_bool fAddressIndex;
+/** Whether the address index keeps the running totals of the addresses */
+extern std::atomic_bool fAddressBalanceIndex;
+extern std::atomic_bool fSpentIndex;
+extern std::atomic_bool fTimestampIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
 extern bool fCheckBlockIndex;
@@ -298,6 +329,8 @@ bool LoadBlockIndex(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the header PoW checking thread */
+void ThreadHeaderPoWCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Format a string that describes several potential problems detected by the core.
@@ -533,6 +566,12 @@ bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
 bool GetAddressIndex(uint160 addressHash, AddressType type,
                      std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                      int start = 0, int end = 0);
+/** Address index entries from the transaction at (height, txindex) on, see CBlockTreeDB::ReadAddressIndexPage */
+bool GetAddressIndexPage(uint160 addressHash, AddressType type,
+                         std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                         int height, unsigned int txindex, int end, size_t nLimit);
+/** Running totals of an address, summed up from the address index if it has none */
+bool GetAddressBalance(uint160 addressHash, AddressType type, CAddressBalance &balance);
 bool GetAddressUnspent(uint160 addressHash, AddressType type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
 
@@ -540,6 +579,7 @@ bool GetAddressUnspent(uint160 addressHash, AddressType type,
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -616,6 +656,12 @@ extern CCoinsViewCache *pcoinsTip;
 /** Global variable that points to the active block tree (protected by cs_main) */
 extern CBlockTreeDB *pblocktree;
 
+/** Global variable that points to the verified PoW hash database */
+extern CPoWHashDB *ppowhashdb;
+
+/** Look up the PoW hash a header was verified with when its block was connected, possibly before a restart or -reindex */
+bool GetVerifiedPoWHash(const uint256& blockHash, uint256& powHash);
+
 /**
  * Return the spend height, which is one more than the inputs.GetBestBlock().
  * While checking, GetBestBlock() refers to the parent block. (protected by cs_main)
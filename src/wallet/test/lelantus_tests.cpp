@@ -5,6 +5,7 @@
 #include <exception>
 
 #include "../wallet.h"
+#include "../../hdmint/wallet.h"
 
 #include <boost/test/unit_test.hpp>
 
@@ -30,6 +31,104 @@ BOOST_AUTO_TEST_CASE(create_mint_recipient)
     BOOST_CHECK_EQUAL(0, m.GetCount());
 }
 
+BOOST_AUTO_TEST_CASE(decrypt_mint_amount_with_chain_key)
+{
+    GroupElement pubcoin;
+    pubcoin.randomize();
+    uint64_t amount = 15 * COIN;
+
+    CExtKey mintValueKey;
+    std::vector<unsigned char> encryptedValue;
+    {
+        LOCK(pwalletMain->cs_wallet);
+        mintValueKey = pwalletMain->GetKeypathChainKey(BIP44_MINT_VALUE_INDEX);
+        encryptedValue = pwalletMain->EncryptMintAmount(amount, pubcoin);
+    }
+
+    // the keys derived from the chain key are the ones derived from the seed
+    uint64_t decrypted = 0;
+    BOOST_CHECK(CWallet::DecryptMintAmount(mintValueKey, encryptedValue, pubcoin, decrypted));
+    BOOST_CHECK_EQUAL(amount, decrypted);
+    BOOST_CHECK(CWallet::EncryptMintAmount(mintValueKey, amount, pubcoin) == encryptedValue);
+}
+
+BOOST_AUTO_TEST_CASE(recover_mints_across_pool_refill)
+{
+    GenerateBlocks(120);
+    std::vector<CAmount> amounts;
+    for (int i = 1; i <= 8; i++)
+        amounts.push_back(i * COIN / 10);
+
+    std::vector<CMutableTransaction> txs;
+    auto mints = GenerateMints(amounts, txs);
+    GenerateBlock(txs);
+    int32_t nCount = pwalletMain->zwallet->GetCount();
+
+    // forget the mints and the mint pool
+    CWalletDB walletdb(pwalletMain->strWalletFile);
+    pwalletMain->ZapLelantusMints();
+    std::vector<std::pair<uint256, GroupElement>> serialPubcoinPairs = walletdb.ListSerialPubcoinPairs();
+    for (auto& mintPoolPair : walletdb.ListMintPool()) {
+        uint256 hashSerial;
+        if (pwalletMain->zwallet->GetSerialForPubcoin(serialPubcoinPairs, mintPoolPair.first, hashSerial))
+            walletdb.ErasePubcoin(hashSerial);
+        walletdb.EraseMintPoolPair(mintPoolPair.first);
+    }
+
+    // a pool smaller than the number of mints, so it's refilled while they are recovered
+    ForceSetArg("-mintpoolsize", "3");
+    pwalletMain->zwallet = std::make_unique<CHDMintWallet>(pwalletMain->strWalletFile, true);
+    pwalletMain->zwallet->SyncWithChain();
+    ForceSetArg("-mintpoolsize", std::to_string(DEFAULT_MINTPOOL_SIZE));
+
+    std::list<CHDMint> recovered = walletdb.ListHDMints(true);
+    BOOST_CHECK_EQUAL(recovered.size(), mints.size());
+    for (const CHDMint& mint : mints) {
+        auto it = std::find_if(recovered.begin(), recovered.end(), [&](const CHDMint& r) {
+            return r.GetSerialHash() == mint.GetSerialHash();
+        });
+        BOOST_CHECK(it != recovered.end());
+        if (it != recovered.end())
+            BOOST_CHECK_EQUAL(it->GetAmount(), mint.GetAmount());
+    }
+    BOOST_CHECK_EQUAL(pwalletMain->zwallet->GetCount(), nCount);
+}
+
+BOOST_AUTO_TEST_CASE(mint_pool_matches_sequential_generation)
+{
+    CWalletDB walletdb(pwalletMain->strWalletFile);
+    size_t nBefore = walletdb.ListMintPool().size();
+
+    // mints derived in parallel and written in one transaction
+    ForceSetArg("-mintpoolsize", "30");
+    pwalletMain->zwallet->GenerateMintPool(walletdb, true);
+    ForceSetArg("-mintpoolsize", std::to_string(DEFAULT_MINTPOOL_SIZE));
+
+    auto mintPool = walletdb.ListMintPool();
+    BOOST_CHECK(mintPool.size() >= nBefore + 30);
+    std::vector<std::pair<uint256, GroupElement>> serialPubcoinPairs = walletdb.ListSerialPubcoinPairs();
+
+    std::set<int32_t> counts;
+    for (auto& mintPoolPair : mintPool) {
+        uint160 hashSeedMaster;
+        CKeyID seedId;
+        int32_t nCount;
+        std::tie(hashSeedMaster, seedId, nCount) = mintPoolPair.second;
+        BOOST_CHECK(counts.insert(nCount).second);
+
+        uint256 hashSerial;
+        BOOST_CHECK(pwalletMain->zwallet->GetSerialForPubcoin(serialPubcoinPairs, mintPoolPair.first, hashSerial));
+
+        // every entry is the one a single sequential derivation gives
+        auto hashes = pwalletMain->zwallet->RegenerateMintPoolEntry(walletdb, hashSeedMaster, seedId, nCount);
+        BOOST_CHECK(hashes.first == mintPoolPair.first);
+        BOOST_CHECK(hashes.second == hashSerial);
+    }
+
+    // no count is skipped
+    BOOST_CHECK_EQUAL(*counts.rbegin() - *counts.begin() + 1, (int32_t)counts.size());
+}
+
 BOOST_AUTO_TEST_CASE(mint_and_store_lelantus)
 {
     bool oldFRequireStandard = fRequireStandard;
@@ -175,6 +175,23 @@ const CWalletTx *CWallet::GetWalletTx(const uint256 &hash) const {
 CPubKey CWallet::GetKeyFromKeypath(uint32_t nChange, uint32_t nChild, CKey& secret) {
     AssertLockHeld(cs_wallet); // mapKeyMetadata
 
+    CExtKey externalChainChildKey = GetKeypathChainKey(nChange);
+    CExtKey childKey;              //key at m/44'/<1/136>'/0'/<c>/<n>
+
+    // derive m/44'/136'/0'/<c>/<n>
+    externalChainChildKey.Derive(childKey, nChild);
+
+    secret = childKey.key;
+
+    CPubKey pubkey = secret.GetPubKey();
+    assert(secret.VerifyPubKey(pubkey));
+
+    return pubkey;
+}
+
+CExtKey CWallet::GetKeypathChainKey(uint32_t nChange) {
+    AssertLockHeld(cs_wallet);
+
     uint32_t nIndex = Params().GetConsensus().IsMain() ? BIP44_FIRO_INDEX : BIP44_TEST_INDEX;
 
     // Fail if not using HD wallet (no keypaths)
@@ -188,7 +205,6 @@ CPubKey CWallet::GetKeyFromKeypath(uint32_t nChange, uint32_t nChild, CKey& secr
     CExtKey coinTypeKey;           //key at m/44'/<1/136>' (Testnet or Firo Coin Type respectively, according to SLIP-0044)
     CExtKey accountKey;            //key at m/44'/<1/136>'/0'
     CExtKey externalChainChildKey; //key at m/44'/<1/136>'/0'/<c> (Standard: 0/1, Mints: 2)
-    CExtKey childKey;              //key at m/44'/<1/136>'/0'/<c>/<n>
 
     if(hdChain.nVersion >= CHDChain::VERSION_WITH_BIP39){
         MnemonicContainer mContainer = mnemonicContainer;
@@ -215,15 +231,7 @@ CPubKey CWallet::GetKeyFromKeypath(uint32_t nChange, uint32_t nChild, CKey& secr
     // derive m/44'/136'/0'/<c>
     accountKey.Derive(externalChainChildKey, nChange);
 
-    // derive m/44'/136'/0'/<c>/<n>
-    externalChainChildKey.Derive(childKey, nChild);
-
-    secret = childKey.key;
-
-    CPubKey pubkey = secret.GetPubKey();
-    assert(secret.VerifyPubKey(pubkey));
-
-    return pubkey;
+    return externalChainChildKey;
 }
 
 CPubKey CWallet::GenerateNewKey(uint32_t nChange, bool fWriteChain)
@@ -3353,6 +3361,13 @@ std::list<CLelantusEntry> CWallet::GetAvailableLelantusCoins(const CCoinControl
     return coins;
 }
 
+static std::vector<unsigned char> GetAESKey(const CKey& secret) {
+    std::vector<unsigned char> result(CHMAC_SHA512::OUTPUT_SIZE);
+
+    CHMAC_SHA512(secret.begin(), secret.size()).Finalize(&result[0]);
+    return result;
+}
+
 std::vector<unsigned char> GetAESKey(const secp_primitives::GroupElement& pubcoin) {
     uint32_t keyPath = primitives::GetPubCoinValueHash(pubcoin).GetFirstUint32();
     CKey secret;
@@ -3360,10 +3375,16 @@ std::vector<unsigned char> GetAESKey(const secp_primitives::GroupElement& pubcoi
         pwalletMain->GetKeyFromKeypath(BIP44_MINT_VALUE_INDEX, keyPath, secret);
     }
 
-    std::vector<unsigned char> result(CHMAC_SHA512::OUTPUT_SIZE);
+    return GetAESKey(secret);
+}
 
-    CHMAC_SHA512(secret.begin(), secret.size()).Finalize(&result[0]);
-    return result;
+// Same key as above, derived from the key at BIP44_MINT_VALUE_INDEX instead of from the seed
+static std::vector<unsigned char> GetAESKey(const CExtKey& mintValueKey, const secp_primitives::GroupElement& pubcoin) {
+    uint32_t keyPath = primitives::GetPubCoinValueHash(pubcoin).GetFirstUint32();
+    CExtKey childKey;
+    mintValueKey.Derive(childKey, keyPath);
+
+    return GetAESKey(childKey.key);
 }
 
 std::vector<unsigned char> CWallet::EncryptMintAmount(uint64_t amount, const secp_primitives::GroupElement& pubcoin) const {
@@ -3392,6 +3413,28 @@ bool CWallet::DecryptMintAmount(const std::vector<unsigned char>& encryptedValue
     return true;
 }
 
+std::vector<unsigned char> CWallet::EncryptMintAmount(const CExtKey& mintValueKey, uint64_t amount, const secp_primitives::GroupElement& pubcoin) {
+    std::vector<unsigned char> key = GetAESKey(mintValueKey, pubcoin);
+    AES256Encrypt enc(key.data());
+    std::vector<unsigned char> ciphertext(16);
+    std::vector<unsigned char> plaintext(16);
+    memcpy(plaintext.data(), &amount, 8);
+    enc.Encrypt(ciphertext.data(), plaintext.data());
+    return ciphertext;
+}
+
+bool CWallet::DecryptMintAmount(const CExtKey& mintValueKey, const std::vector<unsigned char>& encryptedValue, const secp_primitives::GroupElement& pubcoin, uint64_t& amount) {
+    if (encryptedValue.size() < 16)
+        return false;
+
+    std::vector<unsigned char> key = GetAESKey(mintValueKey, pubcoin);
+    AES256Decrypt dec(key.data());
+    std::vector<unsigned char> plaintext(16);
+    dec.Decrypt(plaintext.data(), encryptedValue.data());
+    memcpy(&amount, plaintext.data(), 8);
+    return true;
+}
+
 
 template<typename Iterator>
 static CAmount CalculateCoinsBalance(Iterator begin, Iterator end) {
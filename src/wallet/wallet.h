@@ -861,6 +861,8 @@ public:
     bool GetVinAndKeysFromOutput(COutput out, CTxIn& txinRet, CPubKey& pubKeyRet, CKey& keyRet);
 
     CPubKey GetKeyFromKeypath(uint32_t nChange, uint32_t nChild, CKey& secret);
+    // Returns the key at m/44'/<coin type>'/0'/<nChange>, the parent of the keys GetKeyFromKeypath returns
+    CExtKey GetKeypathChainKey(uint32_t nChange);
     /**
      * keystore implementation
      * Generate a new key
@@ -979,6 +981,10 @@ public:
 
     bool DecryptMintAmount(const std::vector<unsigned char>& encryptedValue, const secp_primitives::GroupElement& pubcoin, uint64_t& amount) const;
 
+    // Same as above with the key GetKeypathChainKey(BIP44_MINT_VALUE_INDEX) returns, these don't need cs_wallet
+    static std::vector<unsigned char> EncryptMintAmount(const CExtKey& mintValueKey, uint64_t amount, const secp_primitives::GroupElement& pubcoin);
+    static bool DecryptMintAmount(const CExtKey& mintValueKey, const std::vector<unsigned char>& encryptedValue, const secp_primitives::GroupElement& pubcoin, uint64_t& amount);
+
 
     /** \brief Selects coins to spend, and coins to re-mint based on the required amount to spend, provided by the user. As the lower denomination now is 0.1 firo, user's request will be rounded up to the nearest 0.1. This difference between the user's requested value, and the actually spent value will be left to the miners as a fee.
      * \param[in] required Required amount to spend.